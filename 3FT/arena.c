@@ -0,0 +1,328 @@
+/*--------------------------------------------------------------------*/
+/* arena.c                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthread_mutex_t, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include "arena.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The alignment of every block, and the granularity of block sizes.
+   Block sizes are rounded up to a multiple of ALIGNMENT, and each
+   multiple up to MAX_SMALL_SIZE has its own free list.  Larger blocks
+   are allocated from the heap individually.  Chunks are CHUNK_SIZE
+   bytes. */
+
+enum { ALIGNMENT = 16, MAX_SMALL_SIZE = 512, CHUNK_SIZE = 65536 };
+
+/* The number of free lists. */
+
+enum { SIZE_CLASSES = MAX_SMALL_SIZE / ALIGNMENT };
+
+/*--------------------------------------------------------------------*/
+
+/* A Header links a chunk, or a large block, into the Arena's list of
+   them.  It occupies the first ALIGNMENT bytes of the allocation, so
+   that the memory after it keeps the allocation's alignment. */
+
+union Header
+{
+   /* The links. */
+   struct
+   {
+      union Header *psPrev;
+      union Header *psNext;
+   } sLinks;
+
+   /* Padding, to keep the memory after the Header aligned. */
+   char acPadding[ALIGNMENT];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A FreeBlock is a released small block, on the free list for its
+   size. */
+
+struct FreeBlock
+{
+   /* The next FreeBlock of the same size. */
+   struct FreeBlock *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An Arena consists of a list of chunks, the unused part of the most
+   recent chunk, a free list per small block size, and a list of large
+   blocks. */
+
+struct Arena
+{
+   /* The chunks, most recent first, linked through psNext. */
+   union Header *psChunks;
+
+   /* The next unused byte of the most recent chunk. */
+   char *pcNext;
+
+   /* The end of the most recent chunk. */
+   char *pcEnd;
+
+   /* The released small blocks, indexed by size class. */
+   struct FreeBlock *apsFreeLists[SIZE_CLASSES];
+
+   /* The large blocks, doubly linked so that each can be released
+      individually. */
+   union Header *psLargeBlocks;
+
+   /* The mutex serializing the use of a shared Arena, or NULL if the
+      Arena is not shared. */
+   pthread_mutex_t *psLock;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize rounded up to a nonzero multiple of ALIGNMENT. */
+
+static size_t Arena_round(size_t uSize)
+{
+   if (uSize == 0)
+      return ALIGNMENT;
+   return (uSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/*--------------------------------------------------------------------*/
+
+Arena_T Arena_new(void)
+{
+   Arena_T oArena;
+   size_t u;
+
+   oArena = (struct Arena*)malloc(sizeof(struct Arena));
+   if (oArena == NULL)
+      return NULL;
+
+   oArena->psChunks = NULL;
+   oArena->pcNext = NULL;
+   oArena->pcEnd = NULL;
+   for (u = 0; u < SIZE_CLASSES; u++)
+      oArena->apsFreeLists[u] = NULL;
+   oArena->psLargeBlocks = NULL;
+   oArena->psLock = NULL;
+
+   return oArena;
+}
+
+/*--------------------------------------------------------------------*/
+
+Arena_T Arena_newShared(void)
+{
+   Arena_T oArena;
+
+   oArena = Arena_new();
+   if (oArena == NULL)
+      return NULL;
+
+   oArena->psLock = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+   if (oArena->psLock == NULL)
+   {
+      free(oArena);
+      return NULL;
+   }
+   if (pthread_mutex_init(oArena->psLock, NULL) != 0)
+   {
+      free(oArena->psLock);
+      free(oArena);
+      return NULL;
+   }
+
+   return oArena;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Arena_free(Arena_T oArena)
+{
+   union Header *psHeader;
+   union Header *psNextHeader;
+
+   if (oArena == NULL)
+      return;
+
+   for (psHeader = oArena->psChunks; psHeader != NULL;
+        psHeader = psNextHeader)
+   {
+      psNextHeader = psHeader->sLinks.psNext;
+      free(psHeader);
+   }
+
+   for (psHeader = oArena->psLargeBlocks; psHeader != NULL;
+        psHeader = psNextHeader)
+   {
+      psNextHeader = psHeader->sLinks.psNext;
+      free(psHeader);
+   }
+
+   if (oArena->psLock != NULL)
+   {
+      (void)pthread_mutex_destroy(oArena->psLock);
+      free(oArena->psLock);
+   }
+   free(oArena);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new large block of uSize bytes from the heap, linked into
+   oArena's list of large blocks, or NULL if insufficient memory is
+   available. */
+
+static void *Arena_allocLarge(Arena_T oArena, size_t uSize)
+{
+   union Header *psHeader;
+
+   assert(oArena != NULL);
+
+   psHeader = (union Header*)malloc(sizeof(union Header) + uSize);
+   if (psHeader == NULL)
+      return NULL;
+
+   psHeader->sLinks.psPrev = NULL;
+   psHeader->sLinks.psNext = oArena->psLargeBlocks;
+   if (oArena->psLargeBlocks != NULL)
+      oArena->psLargeBlocks->sLinks.psPrev = psHeader;
+   oArena->psLargeBlocks = psHeader;
+
+   return psHeader + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a block of at least uSize bytes from oArena, as Arena_alloc
+   does, without locking oArena. */
+
+static void *Arena_allocUnlocked(Arena_T oArena, size_t uSize)
+{
+   union Header *psChunk;
+   struct FreeBlock *psFreeBlock;
+   size_t uClass;
+   void *pvBlock;
+
+   assert(oArena != NULL);
+
+   uSize = Arena_round(uSize);
+   if (uSize > MAX_SMALL_SIZE)
+      return Arena_allocLarge(oArena, uSize);
+
+   /* Reuse a released block of the same size, if there is one. */
+   uClass = uSize / ALIGNMENT - 1;
+   psFreeBlock = oArena->apsFreeLists[uClass];
+   if (psFreeBlock != NULL)
+   {
+      oArena->apsFreeLists[uClass] = psFreeBlock->psNext;
+      return psFreeBlock;
+   }
+
+   /* Otherwise bump the pointer, starting a new chunk if need be.
+      The rest of the old chunk is abandoned until the Arena is
+      freed. */
+   if ((size_t)(oArena->pcEnd - oArena->pcNext) < uSize)
+   {
+      psChunk = (union Header*)malloc(CHUNK_SIZE);
+      if (psChunk == NULL)
+         return NULL;
+      psChunk->sLinks.psPrev = NULL;
+      psChunk->sLinks.psNext = oArena->psChunks;
+      oArena->psChunks = psChunk;
+      oArena->pcNext = (char*)(psChunk + 1);
+      oArena->pcEnd = (char*)psChunk + CHUNK_SIZE;
+   }
+
+   pvBlock = oArena->pcNext;
+   oArena->pcNext += uSize;
+   return pvBlock;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvBlock, of size uSize, to oArena, as Arena_release does,
+   without locking oArena. */
+
+static void Arena_releaseUnlocked(Arena_T oArena, void *pvBlock,
+                                  size_t uSize)
+{
+   union Header *psHeader;
+   struct FreeBlock *psFreeBlock;
+   size_t uClass;
+
+   assert(oArena != NULL);
+   assert(pvBlock != NULL);
+
+   uSize = Arena_round(uSize);
+   if (uSize > MAX_SMALL_SIZE)
+   {
+      /* Unlink the large block and return it to the heap. */
+      psHeader = (union Header*)pvBlock - 1;
+      if (psHeader->sLinks.psPrev != NULL)
+         psHeader->sLinks.psPrev->sLinks.psNext =
+            psHeader->sLinks.psNext;
+      else
+         oArena->psLargeBlocks = psHeader->sLinks.psNext;
+      if (psHeader->sLinks.psNext != NULL)
+         psHeader->sLinks.psNext->sLinks.psPrev =
+            psHeader->sLinks.psPrev;
+      free(psHeader);
+      return;
+   }
+
+   uClass = uSize / ALIGNMENT - 1;
+   psFreeBlock = (struct FreeBlock*)pvBlock;
+   psFreeBlock->psNext = oArena->apsFreeLists[uClass];
+   oArena->apsFreeLists[uClass] = psFreeBlock;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Arena_alloc(Arena_T oArena, size_t uSize)
+{
+   void *pvBlock;
+
+   if (oArena == NULL)
+      return malloc(uSize);
+
+   if (oArena->psLock == NULL)
+      return Arena_allocUnlocked(oArena, uSize);
+
+   (void)pthread_mutex_lock(oArena->psLock);
+   pvBlock = Arena_allocUnlocked(oArena, uSize);
+   (void)pthread_mutex_unlock(oArena->psLock);
+   return pvBlock;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize)
+{
+   if (oArena == NULL)
+   {
+      free(pvBlock);
+      return;
+   }
+
+   if (pvBlock == NULL)
+      return;
+
+   if (oArena->psLock == NULL)
+   {
+      Arena_releaseUnlocked(oArena, pvBlock, uSize);
+      return;
+   }
+
+   (void)pthread_mutex_lock(oArena->psLock);
+   Arena_releaseUnlocked(oArena, pvBlock, uSize);
+   (void)pthread_mutex_unlock(oArena->psLock);
+}
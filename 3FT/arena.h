@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* arena.h                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+#include <stddef.h>
+
+/* An Arena_T object is a region of memory from which blocks are
+   allocated by bumping a pointer through large chunks, so that all of
+   them can be released at once, by freeing the chunks.  Blocks that
+   are released individually are recycled through free lists kept per
+   block size.
+
+   Every function accepts a NULL oArena to mean the ordinary heap, so
+   that a module can allocate through an optional Arena_T without
+   testing for one. */
+
+typedef struct Arena *Arena_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Arena_T object, or NULL if insufficient memory
+   is available. */
+
+Arena_T Arena_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Arena_T object, as Arena_new does, that may be
+   used by several threads at once: its allocations and releases are
+   serialized by a mutex.  Return NULL if insufficient memory is
+   available. */
+
+Arena_T Arena_newShared(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oArena and every block that was ever allocated from it,
+   whether or not it was released.  oArena may be NULL, in which case
+   nothing is freed. */
+
+void Arena_free(Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a block of at least uSize bytes from oArena, suitably
+   aligned for any object, or NULL if insufficient memory is
+   available.  If oArena is NULL, the block comes from malloc. */
+
+void *Arena_alloc(Arena_T oArena, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvBlock, which was allocated from oArena with size uSize,
+   so that it can be reused by a later allocation of the same size.
+   If oArena is NULL, pvBlock is passed to free.  pvBlock may be
+   NULL, in which case nothing happens. */
+
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize);
+
+#endif
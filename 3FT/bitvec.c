@@ -0,0 +1,177 @@
+/*--------------------------------------------------------------------*/
+/* bitvec.c                                                           */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "bitvec.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of words whose set bits are counted together in the
+   directory. */
+
+enum { WORDS_PER_BLOCK = 8 };
+
+/* The number of bits in each block. */
+
+enum { BLOCK_BITS = WORDS_PER_BLOCK * BITVEC_WORD_BITS };
+
+/*--------------------------------------------------------------------*/
+
+/* A BitVec consists of its words and a directory of the number of
+   bits set before each block of them. */
+
+struct BitVec
+{
+   /* The bits, of which there are uLength, in uWords words. */
+   size_t *puWords;
+   size_t uLength;
+   size_t uWords;
+
+   /* The number of bits set before each block of WORDS_PER_BLOCK
+      words, of which there are uBlocks. */
+   size_t *puRanks;
+   size_t uBlocks;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of set bits in uWord. */
+
+static size_t BitVec_count(size_t uWord)
+{
+   return (size_t)__builtin_popcountl((unsigned long)uWord);
+}
+
+/*--------------------------------------------------------------------*/
+
+BitVec_T BitVec_new(size_t *puWords, size_t uLength)
+{
+   BitVec_T oBitVec;
+   size_t uSet = 0;
+   size_t u;
+
+   assert(puWords != NULL || uLength == 0);
+
+   oBitVec = (BitVec_T)malloc(sizeof(struct BitVec));
+   if (oBitVec == NULL)
+      return NULL;
+
+   oBitVec->uWords = (uLength + BITVEC_WORD_BITS - 1) /
+      BITVEC_WORD_BITS;
+   oBitVec->uBlocks = (oBitVec->uWords + WORDS_PER_BLOCK - 1) /
+      WORDS_PER_BLOCK;
+   oBitVec->puRanks = (size_t*)malloc(
+      (oBitVec->uBlocks + 1) * sizeof(size_t));
+   if (oBitVec->puRanks == NULL)
+   {
+      free(oBitVec);
+      return NULL;
+   }
+   oBitVec->puWords = puWords;
+   oBitVec->uLength = uLength;
+
+   for (u = 0; u < oBitVec->uWords; u++)
+   {
+      if (u % WORDS_PER_BLOCK == 0)
+         oBitVec->puRanks[u / WORDS_PER_BLOCK] = uSet;
+      uSet += BitVec_count(puWords[u]);
+   }
+   oBitVec->puRanks[oBitVec->uBlocks] = uSet;
+
+   return oBitVec;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BitVec_free(BitVec_T oBitVec)
+{
+   if (oBitVec == NULL)
+      return;
+
+   free(oBitVec->puWords);
+   free(oBitVec->puRanks);
+   free(oBitVec);
+}
+
+/*--------------------------------------------------------------------*/
+
+int BitVec_get(BitVec_T oBitVec, size_t uBit)
+{
+   assert(oBitVec != NULL);
+   assert(uBit < oBitVec->uLength);
+
+   return (int)((oBitVec->puWords[uBit / BITVEC_WORD_BITS]
+                 >> (uBit % BITVEC_WORD_BITS)) & 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t BitVec_rank(BitVec_T oBitVec, size_t uBit)
+{
+   size_t uWord;
+   size_t uRank;
+   size_t w;
+
+   assert(oBitVec != NULL);
+   assert(uBit <= oBitVec->uLength);
+
+   uWord = uBit / BITVEC_WORD_BITS;
+   uRank = oBitVec->puRanks[uWord / WORDS_PER_BLOCK];
+   for (w = uWord - uWord % WORDS_PER_BLOCK; w < uWord; w++)
+      uRank += BitVec_count(oBitVec->puWords[w]);
+   if (uBit % BITVEC_WORD_BITS != 0)
+      uRank += BitVec_count(oBitVec->puWords[uWord] &
+         (((size_t)1 << (uBit % BITVEC_WORD_BITS)) - 1));
+   return uRank;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t BitVec_selectZero(BitVec_T oBitVec, size_t uRank)
+{
+   size_t uLow;
+   size_t uHigh;
+   size_t uMiddle;
+   size_t uWord;
+   size_t uZeros;
+   size_t uBits;
+
+   assert(oBitVec != NULL);
+   assert(oBitVec->uBlocks > 0);
+
+   /* Find the last block before which there are no more than uRank
+      zeros.  The zeros before block b are the bits before it less
+      the ones. */
+   uLow = 0;
+   uHigh = oBitVec->uBlocks - 1;
+   while (uLow < uHigh)
+   {
+      uMiddle = uLow + (uHigh - uLow + 1) / 2;
+      if (uMiddle * BLOCK_BITS - oBitVec->puRanks[uMiddle] <= uRank)
+         uLow = uMiddle;
+      else
+         uHigh = uMiddle - 1;
+   }
+   uRank -= uLow * BLOCK_BITS - oBitVec->puRanks[uLow];
+
+   /* Then the word within the block, and the bit within the word. */
+   for (uWord = uLow * WORDS_PER_BLOCK; ; uWord++)
+   {
+      assert(uWord < oBitVec->uWords);
+      uZeros = BITVEC_WORD_BITS -
+         BitVec_count(oBitVec->puWords[uWord]);
+      if (uRank < uZeros)
+         break;
+      uRank -= uZeros;
+   }
+   uZeros = ~oBitVec->puWords[uWord];
+   while (uRank-- > 0)
+      uZeros &= uZeros - 1;
+   uBits = (size_t)__builtin_ctzl((unsigned long)uZeros);
+
+   assert(uWord * BITVEC_WORD_BITS + uBits < oBitVec->uLength);
+   return uWord * BITVEC_WORD_BITS + uBits;
+}
@@ -0,0 +1,63 @@
+/*--------------------------------------------------------------------*/
+/* bitvec.h                                                           */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef BITVEC_INCLUDED
+#define BITVEC_INCLUDED
+
+#include <stddef.h>
+
+/* A BitVec_T object is an immutable array of bits that also counts
+   them: it finds the number of set bits before any position (its
+   rank) in constant time, and the position of the zero of any rank
+   (its select) in time logarithmic in the length of the array, with
+   a directory that takes an eighth of a bit per bit. */
+
+typedef struct BitVec *BitVec_T;
+
+/* The number of bits in each word of a BitVec_T's array. */
+
+enum { BITVEC_WORD_BITS = sizeof(size_t) * 8 };
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new BitVec_T object holding the uLength bits of puWords,
+   bit i of which is bit i % BITVEC_WORD_BITS of puWords[i /
+   BITVEC_WORD_BITS], or NULL if insufficient memory is available.
+   puWords, which must have been allocated with malloc, becomes the
+   BitVec's if successful, and is left to the caller otherwise.  Bits
+   beyond uLength in its last word must be 0. */
+
+BitVec_T BitVec_new(size_t *puWords, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBitVec and its bits.  oBitVec may be NULL, in which case
+   nothing is freed. */
+
+void BitVec_free(BitVec_T oBitVec);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bit uBit of oBitVec, which must be less than its
+   length. */
+
+int BitVec_get(BitVec_T oBitVec, size_t uBit);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bits of oBitVec before uBit that are set.
+   uBit may be as great as the length of oBitVec. */
+
+size_t BitVec_rank(BitVec_T oBitVec, size_t uBit);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position of the zero bit of oBitVec before which there
+   are uRank other zero bits.  oBitVec must have more than uRank zero
+   bits. */
+
+size_t BitVec_selectZero(BitVec_T oBitVec, size_t uRank);
+
+#endif
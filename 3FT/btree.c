@@ -0,0 +1,760 @@
+/*--------------------------------------------------------------------*/
+/* btree.c                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "btree.h"
+#include <assert.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most items in a leaf, so that a leaf fills a 64-byte cache line
+   on a 64-bit machine, the most children of an inner node, so that it
+   fills four, and the most levels of inner nodes, far more than any
+   number of items in memory needs.  Items are 32-bit, so a leaf holds
+   twice as many as it would pointers. */
+
+enum { LEAF_MAX = 14, INNER_MAX = 12, MAX_HEIGHT = 32 };
+
+/*--------------------------------------------------------------------*/
+
+/* A leaf holds items in order. */
+
+struct Leaf
+{
+   /* The number of items. */
+   size_t uCount;
+
+   /* The items. */
+   unsigned int auItems[LEAF_MAX];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An inner node holds nodes of the level below it in order. */
+
+struct Inner
+{
+   /* The number of children. */
+   size_t uCount;
+
+   /* The children. */
+   void *apvChildren[INNER_MAX];
+
+   /* The number of items beneath each child. */
+   size_t auSizes[INNER_MAX];
+
+   /* The first item beneath each child. */
+   unsigned int auMins[INNER_MAX];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A BTree consists of a root node and the levels beneath it. */
+
+struct BTree
+{
+   /* The root, a leaf if uHeight is 0, and an inner node otherwise. */
+   void *pvRoot;
+
+   /* The number of levels of inner nodes. */
+   size_t uHeight;
+
+   /* The number of items. */
+   size_t uLength;
+
+   /* The function that compares a key to an item, and its extra
+      argument. */
+   int (*pfCompare)(const void *pvKey, unsigned int uItem,
+                    void *pvExtra);
+   void *pvExtra;
+
+   /* The Arena from which the BTree and its nodes are allocated, or
+      NULL if they are allocated from the heap. */
+   Arena_T oArena;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of items or children of pvNode, which is at level
+   uLevel, leaves being at level 0. */
+
+static size_t BTree_countOf(const void *pvNode, size_t uLevel)
+{
+   assert(pvNode != NULL);
+
+   if (uLevel == 0)
+      return ((const struct Leaf*)pvNode)->uCount;
+   return ((const struct Inner*)pvNode)->uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the most items or children of a node at level uLevel. */
+
+static size_t BTree_maxOf(size_t uLevel)
+{
+   if (uLevel == 0)
+      return LEAF_MAX;
+   return INNER_MAX;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first item beneath pvNode, which is at level uLevel and
+   is not empty. */
+
+static unsigned int BTree_firstOf(const void *pvNode, size_t uLevel)
+{
+   assert(pvNode != NULL);
+   assert(BTree_countOf(pvNode, uLevel) > 0);
+
+   if (uLevel == 0)
+      return ((const struct Leaf*)pvNode)->auItems[0];
+   return ((const struct Inner*)pvNode)->auMins[0];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of items beneath pvNode, which is at level
+   uLevel. */
+
+static size_t BTree_sizeOf(const void *pvNode, size_t uLevel)
+{
+   const struct Inner *psInner;
+   size_t uSize = 0;
+   size_t u;
+
+   assert(pvNode != NULL);
+
+   if (uLevel == 0)
+      return ((const struct Leaf*)pvNode)->uCount;
+
+   psInner = (const struct Inner*)pvNode;
+   for (u = 0; u < psInner->uCount; u++)
+      uSize += psInner->auSizes[u];
+   return uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Allocate a node for level uLevel of oBTree, with no items or
+   children.  Return it, or NULL if insufficient memory is
+   available. */
+
+static void *BTree_newNode(BTree_T oBTree, size_t uLevel)
+{
+   void *pvNode;
+
+   assert(oBTree != NULL);
+
+   if (uLevel == 0)
+   {
+      pvNode = Arena_alloc(oBTree->oArena, sizeof(struct Leaf));
+      if (pvNode != NULL)
+         ((struct Leaf*)pvNode)->uCount = 0;
+   }
+   else
+   {
+      pvNode = Arena_alloc(oBTree->oArena, sizeof(struct Inner));
+      if (pvNode != NULL)
+         ((struct Inner*)pvNode)->uCount = 0;
+   }
+   return pvNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvNode, a node of oBTree at level uLevel, but not the nodes
+   beneath it. */
+
+static void BTree_releaseNode(BTree_T oBTree, void *pvNode,
+                              size_t uLevel)
+{
+   assert(oBTree != NULL);
+
+   if (uLevel == 0)
+      Arena_release(oBTree->oArena, pvNode, sizeof(struct Leaf));
+   else
+      Arena_release(oBTree->oArena, pvNode, sizeof(struct Inner));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the uCount items or children of pvFrom from index uFrom to
+   pvTo from index uTo, where both nodes are at level uLevel.  The
+   nodes may be the same, and the ranges may overlap.  The counts of
+   the nodes are left as they are. */
+
+static void BTree_copyEntries(void *pvTo, size_t uTo,
+                              const void *pvFrom, size_t uFrom,
+                              size_t uCount, size_t uLevel)
+{
+   struct Inner *psTo;
+   const struct Inner *psFrom;
+
+   assert(pvTo != NULL);
+   assert(pvFrom != NULL);
+
+   if (uLevel == 0)
+   {
+      memmove(((struct Leaf*)pvTo)->auItems + uTo,
+              ((const struct Leaf*)pvFrom)->auItems + uFrom,
+              uCount * sizeof(unsigned int));
+      return;
+   }
+
+   psTo = (struct Inner*)pvTo;
+   psFrom = (const struct Inner*)pvFrom;
+   memmove(psTo->apvChildren + uTo, psFrom->apvChildren + uFrom,
+           uCount * sizeof(void*));
+   memmove(psTo->auSizes + uTo, psFrom->auSizes + uFrom,
+           uCount * sizeof(size_t));
+   memmove(psTo->auMins + uTo, psFrom->auMins + uFrom,
+           uCount * sizeof(unsigned int));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the count of pvNode, which is at level uLevel, to uCount. */
+
+static void BTree_setCount(void *pvNode, size_t uLevel, size_t uCount)
+{
+   assert(pvNode != NULL);
+   assert(uCount <= BTree_maxOf(uLevel));
+
+   if (uLevel == 0)
+      ((struct Leaf*)pvNode)->uCount = uCount;
+   else
+      ((struct Inner*)pvNode)->uCount = uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search psLeaf of oBTree for the item that matches pvKey.  Return 1
+   (TRUE) if it is found, and 0 (FALSE) otherwise, storing in *puIndex
+   the index it has, or would have, in psLeaf. */
+
+static int BTree_searchLeaf(BTree_T oBTree, const struct Leaf *psLeaf,
+                            const void *pvKey, size_t *puIndex)
+{
+   size_t uLow = 0;
+   size_t uHigh;
+   size_t uMid;
+   int iCompare;
+
+   assert(oBTree != NULL);
+   assert(psLeaf != NULL);
+   assert(puIndex != NULL);
+
+   uHigh = psLeaf->uCount;
+   while (uLow < uHigh)
+   {
+      uMid = uLow + (uHigh - uLow) / 2;
+      iCompare = (*oBTree->pfCompare)(pvKey, psLeaf->auItems[uMid],
+                                      oBTree->pvExtra);
+      if (iCompare == 0)
+      {
+         *puIndex = uMid;
+         return 1;
+      }
+      if (iCompare < 0)
+         uHigh = uMid;
+      else
+         uLow = uMid + 1;
+   }
+   *puIndex = uLow;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the child of psInner, a node of oBTree, beneath
+   which an item that matches pvKey lies, or would lie: the last child
+   whose first item does not come after pvKey, or the first child if
+   every one does. */
+
+static size_t BTree_childFor(BTree_T oBTree,
+                             const struct Inner *psInner,
+                             const void *pvKey)
+{
+   size_t uLow = 1;
+   size_t uHigh;
+   size_t uMid;
+
+   assert(oBTree != NULL);
+   assert(psInner != NULL);
+
+   uHigh = psInner->uCount;
+   while (uLow < uHigh)
+   {
+      uMid = uLow + (uHigh - uLow) / 2;
+      if ((*oBTree->pfCompare)(pvKey, psInner->auMins[uMid],
+                               oBTree->pvExtra) < 0)
+         uHigh = uMid;
+      else
+         uLow = uMid + 1;
+   }
+   return uLow - 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split the child at index uChild of psParent, a node of oBTree that
+   has room for another, in two, the upper half of the child's items
+   or children going to a new node that follows it.  The child is at
+   level uLevel.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available, in which case nothing changes. */
+
+static int BTree_split(BTree_T oBTree, struct Inner *psParent,
+                       size_t uChild, size_t uLevel)
+{
+   void *pvLeft;
+   void *pvRight;
+   size_t uCount;
+   size_t uKeep;
+
+   assert(oBTree != NULL);
+   assert(psParent != NULL);
+   assert(psParent->uCount < INNER_MAX);
+   assert(uChild < psParent->uCount);
+
+   pvRight = BTree_newNode(oBTree, uLevel);
+   if (pvRight == NULL)
+      return 0;
+
+   pvLeft = psParent->apvChildren[uChild];
+   uCount = BTree_countOf(pvLeft, uLevel);
+   uKeep = (uCount + 1) / 2;
+   BTree_copyEntries(pvRight, 0, pvLeft, uKeep, uCount - uKeep, uLevel);
+   BTree_setCount(pvRight, uLevel, uCount - uKeep);
+   BTree_setCount(pvLeft, uLevel, uKeep);
+
+   BTree_copyEntries(psParent, uChild + 2, psParent, uChild + 1,
+                     psParent->uCount - uChild - 1, 1);
+   psParent->uCount++;
+   psParent->apvChildren[uChild + 1] = pvRight;
+   psParent->auSizes[uChild + 1] = BTree_sizeOf(pvRight, uLevel);
+   psParent->auSizes[uChild] -= psParent->auSizes[uChild + 1];
+   psParent->auMins[uChild + 1] = BTree_firstOf(pvRight, uLevel);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Restore the fill of the child at index uChild of psParent, a node
+   of oBTree, which has fallen below half, by merging it with a
+   neighbor, or, if the two would not fit in one node, by sharing
+   their items or children evenly between them.  The child is at level
+   uLevel. */
+
+static void BTree_rebalance(BTree_T oBTree, struct Inner *psParent,
+                            size_t uChild, size_t uLevel)
+{
+   void *pvLeft;
+   void *pvRight;
+   size_t uLeft;
+   size_t uLeftCount;
+   size_t uRightCount;
+   size_t uNewLeftCount;
+
+   assert(oBTree != NULL);
+   assert(psParent != NULL);
+   assert(uChild < psParent->uCount);
+
+   /* Only the root may have a single child. */
+   if (psParent->uCount < 2)
+      return;
+
+   uLeft = (uChild + 1 < psParent->uCount) ? uChild : uChild - 1;
+   pvLeft = psParent->apvChildren[uLeft];
+   pvRight = psParent->apvChildren[uLeft + 1];
+   uLeftCount = BTree_countOf(pvLeft, uLevel);
+   uRightCount = BTree_countOf(pvRight, uLevel);
+
+   if (uLeftCount + uRightCount <= BTree_maxOf(uLevel))
+   {
+      BTree_copyEntries(pvLeft, uLeftCount, pvRight, 0, uRightCount,
+                        uLevel);
+      BTree_setCount(pvLeft, uLevel, uLeftCount + uRightCount);
+      psParent->auSizes[uLeft] += psParent->auSizes[uLeft + 1];
+      BTree_releaseNode(oBTree, pvRight, uLevel);
+      BTree_copyEntries(psParent, uLeft + 1, psParent, uLeft + 2,
+                        psParent->uCount - uLeft - 2, 1);
+      psParent->uCount--;
+   }
+   else
+   {
+      uNewLeftCount = (uLeftCount + uRightCount) / 2;
+      if (uLeftCount < uNewLeftCount)
+      {
+         BTree_copyEntries(pvLeft, uLeftCount, pvRight, 0,
+                           uNewLeftCount - uLeftCount, uLevel);
+         BTree_copyEntries(pvRight, 0, pvRight,
+                           uNewLeftCount - uLeftCount,
+                           uRightCount - (uNewLeftCount - uLeftCount),
+                           uLevel);
+      }
+      else
+      {
+         BTree_copyEntries(pvRight, uLeftCount - uNewLeftCount,
+                           pvRight, 0, uRightCount, uLevel);
+         BTree_copyEntries(pvRight, 0, pvLeft, uNewLeftCount,
+                           uLeftCount - uNewLeftCount, uLevel);
+      }
+      BTree_setCount(pvLeft, uLevel, uNewLeftCount);
+      BTree_setCount(pvRight, uLevel,
+                     uLeftCount + uRightCount - uNewLeftCount);
+      psParent->auSizes[uLeft] = BTree_sizeOf(pvLeft, uLevel);
+      psParent->auSizes[uLeft + 1] = BTree_sizeOf(pvRight, uLevel);
+      psParent->auMins[uLeft + 1] = BTree_firstOf(pvRight, uLevel);
+   }
+   psParent->auMins[uLeft] = BTree_firstOf(pvLeft, uLevel);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the item that matches pvKey from beneath pvNode, a node of
+   oBTree at level uLevel, and return it, or return 0 if there is
+   none.  Leaves pvNode itself less than half full if need be, for its
+   parent to rebalance. */
+
+static unsigned int BTree_removeFrom(BTree_T oBTree, void *pvNode,
+                                     size_t uLevel, const void *pvKey)
+{
+   struct Leaf *psLeaf;
+   struct Inner *psInner;
+   unsigned int uItem;
+   void *pvChild;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(pvNode != NULL);
+
+   if (uLevel == 0)
+   {
+      psLeaf = (struct Leaf*)pvNode;
+      if (! BTree_searchLeaf(oBTree, psLeaf, pvKey, &u))
+         return 0;
+      uItem = psLeaf->auItems[u];
+      BTree_copyEntries(psLeaf, u, psLeaf, u + 1,
+                        psLeaf->uCount - u - 1, 0);
+      psLeaf->uCount--;
+      return uItem;
+   }
+
+   psInner = (struct Inner*)pvNode;
+   u = BTree_childFor(oBTree, psInner, pvKey);
+   pvChild = psInner->apvChildren[u];
+   uItem = BTree_removeFrom(oBTree, pvChild, uLevel - 1, pvKey);
+   if (uItem == 0)
+      return 0;
+
+   psInner->auSizes[u]--;
+   if (BTree_countOf(pvChild, uLevel - 1) > 0)
+      psInner->auMins[u] = BTree_firstOf(pvChild, uLevel - 1);
+   if (BTree_countOf(pvChild, uLevel - 1) < BTree_maxOf(uLevel - 1) / 2)
+      BTree_rebalance(oBTree, psInner, u, uLevel - 1);
+   return uItem;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvNode, a node of oBTree at level uLevel, and every node
+   beneath it. */
+
+static void BTree_releaseAll(BTree_T oBTree, void *pvNode,
+                             size_t uLevel)
+{
+   struct Inner *psInner;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(pvNode != NULL);
+
+   if (uLevel > 0)
+   {
+      psInner = (struct Inner*)pvNode;
+      for (u = 0; u < psInner->uCount; u++)
+         BTree_releaseAll(oBTree, psInner->apvChildren[u], uLevel - 1);
+   }
+   BTree_releaseNode(oBTree, pvNode, uLevel);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(uItem, pvExtra) for each item uItem beneath pvNode,
+   a node at level uLevel, in order. */
+
+static void BTree_mapFrom(const void *pvNode, size_t uLevel,
+                          void (*pfApply)(unsigned int uItem,
+                                          void *pvExtra),
+                          void *pvExtra)
+{
+   const struct Leaf *psLeaf;
+   const struct Inner *psInner;
+   size_t u;
+
+   assert(pvNode != NULL);
+   assert(pfApply != NULL);
+
+   if (uLevel == 0)
+   {
+      psLeaf = (const struct Leaf*)pvNode;
+      for (u = 0; u < psLeaf->uCount; u++)
+         (*pfApply)(psLeaf->auItems[u], pvExtra);
+      return;
+   }
+
+   psInner = (const struct Inner*)pvNode;
+   for (u = 0; u < psInner->uCount; u++)
+      BTree_mapFrom(psInner->apvChildren[u], uLevel - 1, pfApply,
+                    pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+BTree_T BTree_new(Arena_T oArena,
+                  int (*pfCompare)(const void *pvKey,
+                                   unsigned int uItem, void *pvExtra),
+                  void *pvExtra)
+{
+   BTree_T oBTree;
+
+   assert(pfCompare != NULL);
+
+   oBTree = (struct BTree*)Arena_alloc(oArena, sizeof(struct BTree));
+   if (oBTree == NULL)
+      return NULL;
+
+   oBTree->oArena = oArena;
+   oBTree->pvRoot = BTree_newNode(oBTree, 0);
+   if (oBTree->pvRoot == NULL)
+   {
+      Arena_release(oArena, oBTree, sizeof(struct BTree));
+      return NULL;
+   }
+   oBTree->uHeight = 0;
+   oBTree->uLength = 0;
+   oBTree->pfCompare = pfCompare;
+   oBTree->pvExtra = pvExtra;
+   return oBTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_free(BTree_T oBTree)
+{
+   assert(oBTree != NULL);
+
+   BTree_releaseAll(oBTree, oBTree->pvRoot, oBTree->uHeight);
+   Arena_release(oBTree->oArena, oBTree, sizeof(struct BTree));
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t BTree_getLength(BTree_T oBTree)
+{
+   assert(oBTree != NULL);
+
+   return oBTree->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int BTree_get(BTree_T oBTree, size_t uIndex)
+{
+   const struct Inner *psInner;
+   const void *pvNode;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+   assert(uIndex < oBTree->uLength);
+
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = (const struct Inner*)pvNode;
+      for (u = 0; uIndex >= psInner->auSizes[u]; u++)
+         uIndex -= psInner->auSizes[u];
+      pvNode = psInner->apvChildren[u];
+   }
+   return ((const struct Leaf*)pvNode)->auItems[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int BTree_find(BTree_T oBTree, const void *pvKey)
+{
+   const void *pvNode;
+   size_t uLevel;
+   size_t u;
+
+   assert(oBTree != NULL);
+
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+      pvNode = ((const struct Inner*)pvNode)->apvChildren[
+         BTree_childFor(oBTree, (const struct Inner*)pvNode, pvKey)];
+
+   if (! BTree_searchLeaf(oBTree, (const struct Leaf*)pvNode, pvKey,
+                          &u))
+      return 0;
+   return ((const struct Leaf*)pvNode)->auItems[u];
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_search(BTree_T oBTree, const void *pvKey, size_t *puIndex)
+{
+   const struct Inner *psInner;
+   const void *pvNode;
+   size_t uBefore = 0;
+   size_t uLevel;
+   size_t uChild;
+   size_t u;
+   int iFound;
+
+   assert(oBTree != NULL);
+   assert(puIndex != NULL);
+
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = (const struct Inner*)pvNode;
+      uChild = BTree_childFor(oBTree, psInner, pvKey);
+      for (u = 0; u < uChild; u++)
+         uBefore += psInner->auSizes[u];
+      pvNode = psInner->apvChildren[uChild];
+   }
+
+   iFound = BTree_searchLeaf(oBTree, (const struct Leaf*)pvNode, pvKey,
+                             &u);
+   *puIndex = uBefore + u;
+   return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+int BTree_add(BTree_T oBTree, const void *pvKey, unsigned int uItem)
+{
+   struct Inner *apsPath[MAX_HEIGHT];
+   size_t auPath[MAX_HEIGHT];
+   struct Inner *psInner;
+   struct Leaf *psLeaf;
+   void *pvNode;
+   size_t uLevel;
+   size_t u;
+   int iFound;
+
+   assert(oBTree != NULL);
+   assert(uItem != 0);
+
+   /* Split a full root beneath a new one, so that the tree grows by
+      a level. */
+   if (BTree_countOf(oBTree->pvRoot, oBTree->uHeight) ==
+       BTree_maxOf(oBTree->uHeight))
+   {
+      assert(oBTree->uHeight + 1 < MAX_HEIGHT);
+      psInner = (struct Inner*)BTree_newNode(oBTree, 1);
+      if (psInner == NULL)
+         return 0;
+      psInner->uCount = 1;
+      psInner->apvChildren[0] = oBTree->pvRoot;
+      psInner->auSizes[0] = oBTree->uLength;
+      psInner->auMins[0] = BTree_firstOf(oBTree->pvRoot,
+                                          oBTree->uHeight);
+      if (! BTree_split(oBTree, psInner, 0, oBTree->uHeight))
+      {
+         BTree_releaseNode(oBTree, psInner, 1);
+         return 0;
+      }
+      oBTree->pvRoot = psInner;
+      oBTree->uHeight++;
+   }
+
+   /* Descend to the leaf, splitting each full node before entering
+      it, so that every node on the way has room for one more.  A
+      failed split leaves the items as they were, so the way is only
+      recorded here, and the counts updated once it is certain. */
+   pvNode = oBTree->pvRoot;
+   for (uLevel = oBTree->uHeight; uLevel > 0; uLevel--)
+   {
+      psInner = (struct Inner*)pvNode;
+      u = BTree_childFor(oBTree, psInner, pvKey);
+      if (BTree_countOf(psInner->apvChildren[u], uLevel - 1) ==
+          BTree_maxOf(uLevel - 1))
+      {
+         if (! BTree_split(oBTree, psInner, u, uLevel - 1))
+            return 0;
+         if ((*oBTree->pfCompare)(pvKey, psInner->auMins[u + 1],
+                                  oBTree->pvExtra) >= 0)
+            u++;
+      }
+      apsPath[uLevel - 1] = psInner;
+      auPath[uLevel - 1] = u;
+      pvNode = psInner->apvChildren[u];
+   }
+
+   psLeaf = (struct Leaf*)pvNode;
+   iFound = BTree_searchLeaf(oBTree, psLeaf, pvKey, &u);
+   assert(! iFound);
+   (void)iFound;
+   BTree_copyEntries(psLeaf, u + 1, psLeaf, u, psLeaf->uCount - u, 0);
+   psLeaf->auItems[u] = uItem;
+   psLeaf->uCount++;
+
+   /* Count the item beneath each node above it, from the bottom up,
+      where it may have become the first. */
+   for (uLevel = 0; uLevel < oBTree->uHeight; uLevel++)
+   {
+      psInner = apsPath[uLevel];
+      u = auPath[uLevel];
+      psInner->auSizes[u]++;
+      psInner->auMins[u] = BTree_firstOf(psInner->apvChildren[u],
+                                          uLevel);
+   }
+   oBTree->uLength++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int BTree_remove(BTree_T oBTree, const void *pvKey)
+{
+   unsigned int uItem;
+   void *pvRoot;
+
+   assert(oBTree != NULL);
+
+   uItem = BTree_removeFrom(oBTree, oBTree->pvRoot, oBTree->uHeight,
+                            pvKey);
+   if (uItem == 0)
+      return 0;
+   oBTree->uLength--;
+
+   /* Drop a root left with a single child, so that the tree shrinks
+      by a level. */
+   pvRoot = oBTree->pvRoot;
+   if (oBTree->uHeight > 0 && ((struct Inner*)pvRoot)->uCount == 1)
+   {
+      oBTree->pvRoot = ((struct Inner*)pvRoot)->apvChildren[0];
+      BTree_releaseNode(oBTree, pvRoot, oBTree->uHeight);
+      oBTree->uHeight--;
+   }
+   return uItem;
+}
+
+/*--------------------------------------------------------------------*/
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(unsigned int uItem, void *pvExtra),
+               void *pvExtra)
+{
+   assert(oBTree != NULL);
+   assert(pfApply != NULL);
+
+   BTree_mapFrom(oBTree->pvRoot, oBTree->uHeight, pfApply, pvExtra);
+}
@@ -0,0 +1,93 @@
+/*--------------------------------------------------------------------*/
+/* btree.h                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef BTREE_INCLUDED
+#define BTREE_INCLUDED
+
+#include <stddef.h>
+#include "arena.h"
+
+/* A BTree_T object is a sequence of items, each a nonzero unsigned
+   int, kept in order by a comparison function, in a B+tree: the items
+   lie in leaves, each a cache line, and inner nodes record the first
+   item and the number of items beneath each of their children.  An
+   item is thus found, added or removed by its key, and found by its
+   index in the order, in time logarithmic in the number of items, and
+   items are added and removed by moving only the few in one node. */
+
+typedef struct BTree *BTree_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty BTree_T object, allocated from oArena, whose
+   items are ordered by (*pfCompare)(pvKey, uItem, pvExtra), which
+   compares a key to an item as strcmp would, or NULL if insufficient
+   memory is available. */
+
+BTree_T BTree_new(Arena_T oArena,
+                  int (*pfCompare)(const void *pvKey,
+                                   unsigned int uItem, void *pvExtra),
+                  void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oBTree. */
+
+void BTree_free(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of items in oBTree. */
+
+size_t BTree_getLength(BTree_T oBTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the item at index uIndex of oBTree.  uIndex must be less
+   than the number of items. */
+
+unsigned int BTree_get(BTree_T oBTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the item of oBTree that matches pvKey, or 0 if there is
+   none. */
+
+unsigned int BTree_find(BTree_T oBTree, const void *pvKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Search oBTree for the item that matches pvKey.  Return 1 (TRUE) if
+   it is found, and 0 (FALSE) otherwise.  In either case, store in
+   *puIndex the index that such an item has, or would have. */
+
+int BTree_search(BTree_T oBTree, const void *pvKey, size_t *puIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add uItem, whose key is pvKey, to oBTree, which must hold no item
+   that matches pvKey.  Return 1 (TRUE) if successful, or 0 (FALSE)
+   if insufficient memory is available, in which case oBTree is
+   unchanged. */
+
+int BTree_add(BTree_T oBTree, const void *pvKey, unsigned int uItem);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the item that matches pvKey from oBTree, and return it, or
+   return 0 if there is none. */
+
+unsigned int BTree_remove(BTree_T oBTree, const void *pvKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(uItem, pvExtra) for each item uItem of oBTree, in
+   order.  pfApply must not change oBTree. */
+
+void BTree_map(BTree_T oBTree,
+               void (*pfApply)(unsigned int uItem, void *pvExtra),
+               void *pvExtra);
+
+#endif
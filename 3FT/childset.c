@@ -0,0 +1,844 @@
+/*--------------------------------------------------------------------*/
+/* childset.c                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "childset.h"
+#include "btree.h"
+#include "hash.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The fewest slots that a table has, and the fewest children for
+   which an array has room. */
+
+enum { MIN_SLOTS = 16, MIN_ROOM = 4 };
+
+/*--------------------------------------------------------------------*/
+
+/* A ChildSet consists of an array of children and, beyond the
+   threshold, a hash table of them, or else, beyond the threshold, of
+   a BTree of them. */
+
+struct ChildSet
+{
+   /* The children, in order of names unless iSorted is 0: an array
+      with room for uRoom, of which the first uLength are in use, or
+      NULL if they are in oTree. */
+   unsigned int *puChildren;
+   size_t uLength;
+   size_t uRoom;
+
+   /* The children, in a BTree keyed by name, or NULL if they are in
+      puChildren. */
+   BTree_T oTree;
+
+   /* The function that returns a child's name, and its context. */
+   const char *(*pfGetName)(unsigned int uChild, void *pvContext);
+   void *pvContext;
+
+   /* The Arena from which the ChildSet, its array and its table are
+      allocated, or NULL if they are allocated from the heap. */
+   Arena_T oArena;
+
+   /* The hash table, an array of uSlots slots, a power of 2, probed
+      linearly.  A slot holds 0 if it is empty, or else 1 more than
+      the index of a child in puChildren.  NULL if there is no
+      table. */
+   unsigned int *puSlots;
+   size_t uSlots;
+
+   /* 1 (TRUE) if puChildren is in order of names, which it always is
+      if there is no table. */
+   int iSorted;
+
+   /* 1 (TRUE) if the ChildSet is read without locks, and so must never
+      have a table. */
+   int iShared;
+
+   /* The number of children beyond which the ChildSet keeps a table,
+      or 0 if it never does. */
+   size_t uThreshold;
+
+   /* 1 (TRUE) if the ChildSet, beyond its threshold, moves its
+      children to a BTree rather than keep a table. */
+   int iOrdered;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A child with its name, for sorting children with qsort. */
+
+struct Entry
+{
+   const char *pcName;
+   unsigned int uChild;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Compare pcKey to pcName as strcmp would, except that pcKey ends at
+   its first slash, if it has one.  A key at the very address of the
+   name, as a child's own name is, matches without being read. */
+
+static int ChildSet_compareKey(const char *pcKey, const char *pcName)
+{
+   assert(pcKey != NULL);
+   assert(pcName != NULL);
+
+   if (pcKey == pcName)
+      return 0;
+
+   while (*pcKey == *pcName && *pcKey != '\0')
+   {
+      pcKey++;
+      pcName++;
+   }
+
+   if (*pcKey == '/')
+      return 0 - (int)(unsigned char)*pcName;
+   return (int)(unsigned char)*pcKey - (int)(unsigned char)*pcName;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the names of the Entries pvEntry1 and pvEntry2, for
+   qsort. */
+
+static int ChildSet_compareEntries(const void *pvEntry1,
+                                   const void *pvEntry2)
+{
+   assert(pvEntry1 != NULL);
+   assert(pvEntry2 != NULL);
+
+   return strcmp(((const struct Entry*)pvEntry1)->pcName,
+                 ((const struct Entry*)pvEntry2)->pcName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of uChild, a child of oChildSet. */
+
+static const char *ChildSet_nameOf(ChildSet_T oChildSet,
+                                   unsigned int uChild)
+{
+   assert(oChildSet != NULL);
+   assert(uChild != 0);
+
+   return (*oChildSet->pfGetName)(uChild, oChildSet->pvContext);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the key pvKey to the name of the child uChild of the
+   ChildSet pvChildSet, for its BTree. */
+
+static int ChildSet_compareChild(const void *pvKey, unsigned int uChild,
+                                 void *pvChildSet)
+{
+   assert(pvKey != NULL);
+   assert(pvChildSet != NULL);
+
+   return ChildSet_compareKey((const char*)pvKey,
+      ChildSet_nameOf((ChildSet_T)pvChildSet, uChild));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the child at index uIndex of oChildSet's
+   array. */
+
+static const char *ChildSet_nameAt(ChildSet_T oChildSet, size_t uIndex)
+{
+   assert(oChildSet != NULL);
+   assert(uIndex < oChildSet->uLength);
+
+   return ChildSet_nameOf(oChildSet, oChildSet->puChildren[uIndex]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give oChildSet's array room for uRoom children, at least as many
+   as it holds, in a new block.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if insufficient memory is available, in which case
+   oChildSet is unchanged. */
+
+static int ChildSet_makeRoom(ChildSet_T oChildSet, size_t uRoom)
+{
+   unsigned int *puChildren;
+
+   assert(oChildSet != NULL);
+   assert(uRoom >= oChildSet->uLength);
+
+   /* An Arena cannot resize a block in place, so move the children to
+      a new block and release the old one. */
+   puChildren = (unsigned int*)
+      Arena_alloc(oChildSet->oArena, uRoom * sizeof(unsigned int));
+   if (puChildren == NULL)
+      return 0;
+   if (oChildSet->puChildren != NULL)
+   {
+      memcpy(puChildren, oChildSet->puChildren,
+             oChildSet->uLength * sizeof(unsigned int));
+      Arena_release(oChildSet->oArena, oChildSet->puChildren,
+                    oChildSet->uRoom * sizeof(unsigned int));
+   }
+   oChildSet->puChildren = puChildren;
+   oChildSet->uRoom = uRoom;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release oChildSet's array, once its children are elsewhere. */
+
+static void ChildSet_dropArray(ChildSet_T oChildSet)
+{
+   assert(oChildSet != NULL);
+
+   Arena_release(oChildSet->oArena, oChildSet->puChildren,
+                 oChildSet->uRoom * sizeof(unsigned int));
+   oChildSet->puChildren = NULL;
+   oChildSet->uLength = 0;
+   oChildSet->uRoom = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert uChild at index uIndex of oChildSet's array, growing it if
+   it is full.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available, in which case oChildSet is
+   unchanged. */
+
+static int ChildSet_insertAt(ChildSet_T oChildSet, size_t uIndex,
+                             unsigned int uChild)
+{
+   assert(oChildSet != NULL);
+   assert(oChildSet->puChildren != NULL);
+   assert(uIndex <= oChildSet->uLength);
+
+   if (oChildSet->uLength == oChildSet->uRoom &&
+       ! ChildSet_makeRoom(oChildSet, 2 * oChildSet->uRoom))
+      return 0;
+
+   memmove(oChildSet->puChildren + uIndex + 1,
+           oChildSet->puChildren + uIndex,
+           (oChildSet->uLength - uIndex) * sizeof(unsigned int));
+   oChildSet->puChildren[uIndex] = uChild;
+   oChildSet->uLength++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the child at index uIndex of oChildSet's array, and return
+   it. */
+
+static unsigned int ChildSet_deleteAt(ChildSet_T oChildSet,
+                                      size_t uIndex)
+{
+   unsigned int uChild;
+
+   assert(oChildSet != NULL);
+   assert(uIndex < oChildSet->uLength);
+
+   uChild = oChildSet->puChildren[uIndex];
+   memmove(oChildSet->puChildren + uIndex,
+           oChildSet->puChildren + uIndex + 1,
+           (oChildSet->uLength - uIndex - 1) * sizeof(unsigned int));
+   oChildSet->uLength--;
+   return uChild;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search oChildSet's sorted array for the child named by pcKey.
+   Return 1 (TRUE) if it is found, and 0 (FALSE) otherwise, storing
+   in *puIndex the index it has, or would have. */
+
+static int ChildSet_search(ChildSet_T oChildSet, const char *pcKey,
+                           size_t *puIndex)
+{
+   size_t uLow = 0;
+   size_t uHigh;
+   size_t uMid;
+   int iCompare;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->iSorted);
+   assert(puIndex != NULL);
+
+   uHigh = oChildSet->uLength;
+   while (uLow < uHigh)
+   {
+      uMid = uLow + (uHigh - uLow) / 2;
+      iCompare = ChildSet_compareKey(pcKey,
+                                     ChildSet_nameAt(oChildSet, uMid));
+      if (iCompare == 0)
+      {
+         *puIndex = uMid;
+         return 1;
+      }
+      if (iCompare < 0)
+         uHigh = uMid;
+      else
+         uLow = uMid + 1;
+   }
+   *puIndex = uLow;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of oChildSet's table that holds the child named by
+   pcKey, or else the empty slot where it would go. */
+
+static unsigned int *ChildSet_probe(ChildSet_T oChildSet,
+                                    const char *pcKey)
+{
+   size_t uMask;
+   size_t u;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->puSlots != NULL);
+
+   uMask = oChildSet->uSlots - 1;
+   for (u = Hash_key(pcKey) & uMask;
+        oChildSet->puSlots[u] != 0; u = (u + 1) & uMask)
+      if (ChildSet_compareKey(pcKey,
+             ChildSet_nameAt(oChildSet, oChildSet->puSlots[u] - 1))
+          == 0)
+         break;
+   return &oChildSet->puSlots[u];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill oChildSet's table, which must be empty or stale, with every
+   child at its current index. */
+
+static void ChildSet_fill(ChildSet_T oChildSet)
+{
+   size_t u;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->puSlots != NULL);
+
+   memset(oChildSet->puSlots, 0,
+          oChildSet->uSlots * sizeof(unsigned int));
+   for (u = 0; u < oChildSet->uLength; u++)
+      *ChildSet_probe(oChildSet, ChildSet_nameAt(oChildSet, u)) =
+         (unsigned int)(u + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give oChildSet a new table of uSlots slots, a power of 2, in place
+   of any it has.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available, in which case oChildSet is
+   unchanged. */
+
+static int ChildSet_index(ChildSet_T oChildSet, size_t uSlots)
+{
+   unsigned int *puSlots;
+
+   assert(oChildSet != NULL);
+
+   puSlots = (unsigned int*)Arena_alloc(oChildSet->oArena,
+                                        uSlots * sizeof(unsigned int));
+   if (puSlots == NULL)
+      return 0;
+
+   if (oChildSet->puSlots != NULL)
+      Arena_release(oChildSet->oArena, oChildSet->puSlots,
+                    oChildSet->uSlots * sizeof(unsigned int));
+   oChildSet->puSlots = puSlots;
+   oChildSet->uSlots = uSlots;
+   ChildSet_fill(oChildSet);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Sort oChildSet's array by name, and refill its table, whose indexes
+   the sort changes.  Sorts pairs of names and children, to compare
+   names without calling pfGetName, or, without the memory for them,
+   sorts the children in place by insertion. */
+
+static void ChildSet_sort(ChildSet_T oChildSet)
+{
+   struct Entry *psEntries;
+   unsigned int *puChildren;
+   unsigned int uChild;
+   const char *pcName;
+   size_t uLength;
+   size_t u;
+   size_t v;
+
+   assert(oChildSet != NULL);
+
+   puChildren = oChildSet->puChildren;
+   uLength = oChildSet->uLength;
+   psEntries = (struct Entry*)malloc(uLength * sizeof(struct Entry));
+   if (psEntries != NULL)
+   {
+      for (u = 0; u < uLength; u++)
+      {
+         psEntries[u].uChild = puChildren[u];
+         psEntries[u].pcName =
+            ChildSet_nameOf(oChildSet, puChildren[u]);
+      }
+      qsort(psEntries, uLength, sizeof(struct Entry),
+            ChildSet_compareEntries);
+      for (u = 0; u < uLength; u++)
+         puChildren[u] = psEntries[u].uChild;
+      free(psEntries);
+   }
+   else
+      for (u = 1; u < uLength; u++)
+      {
+         uChild = puChildren[u];
+         pcName = ChildSet_nameOf(oChildSet, uChild);
+         for (v = u; v > 0 &&
+                 strcmp(ChildSet_nameAt(oChildSet, v - 1), pcName) > 0;
+              v--)
+            puChildren[v] = puChildren[v - 1];
+         puChildren[v] = uChild;
+      }
+
+   oChildSet->iSorted = 1;
+   if (oChildSet->puSlots != NULL)
+      ChildSet_fill(oChildSet);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Drop oChildSet's table, sorting its array first if need be. */
+
+static void ChildSet_unindex(ChildSet_T oChildSet)
+{
+   assert(oChildSet != NULL);
+   assert(oChildSet->puSlots != NULL);
+
+   if (! oChildSet->iSorted)
+      ChildSet_sort(oChildSet);
+   Arena_release(oChildSet->oArena, oChildSet->puSlots,
+                 oChildSet->uSlots * sizeof(unsigned int));
+   oChildSet->puSlots = NULL;
+   oChildSet->uSlots = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Empty the slot at index uHole of oChildSet's table, moving back the
+   slots after it that would otherwise be cut off from their home
+   slots, as linear probing requires. */
+
+static void ChildSet_vacate(ChildSet_T oChildSet, size_t uHole)
+{
+   size_t uMask;
+   size_t uHome;
+   size_t u;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->puSlots != NULL);
+
+   uMask = oChildSet->uSlots - 1;
+   for (u = (uHole + 1) & uMask; oChildSet->puSlots[u] != 0;
+        u = (u + 1) & uMask)
+   {
+      uHome = Hash_key(ChildSet_nameAt(oChildSet,
+                               oChildSet->puSlots[u] - 1)) & uMask;
+      /* The child at u may fill the hole if its home slot does not
+         lie cyclically after the hole and up to u. */
+      if (((u - uHome) & uMask) >= ((u - uHole) & uMask))
+      {
+         oChildSet->puSlots[uHole] = oChildSet->puSlots[u];
+         uHole = u;
+      }
+   }
+   oChildSet->puSlots[uHole] = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of slots for a table of uLength children: a
+   power of 2 that keeps the table at most half full. */
+
+static size_t ChildSet_slotsFor(size_t uLength)
+{
+   size_t uSlots = MIN_SLOTS;
+
+   while (uSlots < 2 * uLength + 2)
+      uSlots *= 2;
+   return uSlots;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the children of oChildSet, which is a plain array, to a
+   BTree.  Without the memory for it, oChildSet stays an array. */
+
+static void ChildSet_plant(ChildSet_T oChildSet)
+{
+   BTree_T oTree;
+   size_t u;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->puChildren != NULL);
+   assert(oChildSet->puSlots == NULL);
+
+   oTree = BTree_new(oChildSet->oArena, ChildSet_compareChild,
+                     oChildSet);
+   if (oTree == NULL)
+      return;
+   for (u = 0; u < oChildSet->uLength; u++)
+      if (! BTree_add(oTree, ChildSet_nameAt(oChildSet, u),
+                      oChildSet->puChildren[u]))
+      {
+         BTree_free(oTree);
+         return;
+      }
+
+   ChildSet_dropArray(oChildSet);
+   oChildSet->oTree = oTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append the child uChild to the array of the ChildSet pvChildSet,
+   which has room for it, for BTree_map. */
+
+static void ChildSet_fillWith(unsigned int uChild, void *pvChildSet)
+{
+   ChildSet_T oChildSet = (ChildSet_T)pvChildSet;
+
+   assert(pvChildSet != NULL);
+   assert(oChildSet->uLength < oChildSet->uRoom);
+
+   oChildSet->puChildren[oChildSet->uLength] = uChild;
+   oChildSet->uLength++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the children of oChildSet from its BTree back to an array.
+   Without the memory for it, oChildSet keeps the BTree. */
+
+static void ChildSet_uproot(ChildSet_T oChildSet)
+{
+   size_t uRoom;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->oTree != NULL);
+   assert(oChildSet->puChildren == NULL);
+
+   uRoom = BTree_getLength(oChildSet->oTree);
+   if (uRoom < MIN_ROOM)
+      uRoom = MIN_ROOM;
+   if (! ChildSet_makeRoom(oChildSet, uRoom))
+      return;
+   BTree_map(oChildSet->oTree, ChildSet_fillWith, oChildSet);
+
+   BTree_free(oChildSet->oTree);
+   oChildSet->oTree = NULL;
+   oChildSet->iSorted = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+ChildSet_T ChildSet_new(Arena_T oArena,
+                        const char *(*pfGetName)(unsigned int uChild,
+                                                 void *pvContext),
+                        void *pvContext, size_t uThreshold,
+                        int iOrdered)
+{
+   ChildSet_T oChildSet;
+
+   assert(pfGetName != NULL);
+
+   oChildSet = (struct ChildSet*)Arena_alloc(oArena,
+                                             sizeof(struct ChildSet));
+   if (oChildSet == NULL)
+      return NULL;
+
+   oChildSet->puChildren = NULL;
+   oChildSet->uLength = 0;
+   oChildSet->uRoom = 0;
+   oChildSet->oArena = oArena;
+   if (! ChildSet_makeRoom(oChildSet, MIN_ROOM))
+   {
+      Arena_release(oArena, oChildSet, sizeof(struct ChildSet));
+      return NULL;
+   }
+   oChildSet->oTree = NULL;
+   oChildSet->pfGetName = pfGetName;
+   oChildSet->pvContext = pvContext;
+   oChildSet->puSlots = NULL;
+   oChildSet->uSlots = 0;
+   oChildSet->iSorted = 1;
+   oChildSet->iShared = 0;
+   oChildSet->uThreshold = uThreshold;
+   oChildSet->iOrdered = iOrdered;
+   return oChildSet;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ChildSet_free(ChildSet_T oChildSet)
+{
+   assert(oChildSet != NULL);
+
+   if (oChildSet->oTree != NULL)
+   {
+      BTree_free(oChildSet->oTree);
+      Arena_release(oChildSet->oArena, oChildSet,
+                    sizeof(struct ChildSet));
+      return;
+   }
+
+   if (oChildSet->puSlots != NULL)
+      Arena_release(oChildSet->oArena, oChildSet->puSlots,
+                    oChildSet->uSlots * sizeof(unsigned int));
+   ChildSet_dropArray(oChildSet);
+   Arena_release(oChildSet->oArena, oChildSet, sizeof(struct ChildSet));
+}
+
+/*--------------------------------------------------------------------*/
+
+void ChildSet_share(ChildSet_T oChildSet)
+{
+   assert(oChildSet != NULL);
+   assert(oChildSet->puSlots == NULL);
+   assert(oChildSet->oTree == NULL);
+
+   oChildSet->iShared = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+ChildSet_T ChildSet_copy(ChildSet_T oChildSet)
+{
+   ChildSet_T oCopy;
+
+   assert(oChildSet != NULL);
+   assert(oChildSet->iShared);
+
+   oCopy = (struct ChildSet*)Arena_alloc(oChildSet->oArena,
+                                         sizeof(struct ChildSet));
+   if (oCopy == NULL)
+      return NULL;
+
+   /* Keep the spare room, so that a copy made to add a child seldom
+      has to grow. */
+   *oCopy = *oChildSet;
+   oCopy->puChildren = (unsigned int*)Arena_alloc(
+      oChildSet->oArena, oChildSet->uRoom * sizeof(unsigned int));
+   if (oCopy->puChildren == NULL)
+   {
+      Arena_release(oChildSet->oArena, oCopy, sizeof(struct ChildSet));
+      return NULL;
+   }
+   memcpy(oCopy->puChildren, oChildSet->puChildren,
+          oChildSet->uLength * sizeof(unsigned int));
+   return oCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t ChildSet_getLength(ChildSet_T oChildSet)
+{
+   assert(oChildSet != NULL);
+
+   if (oChildSet->oTree != NULL)
+      return BTree_getLength(oChildSet->oTree);
+   return oChildSet->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int ChildSet_get(ChildSet_T oChildSet, size_t uIndex)
+{
+   assert(oChildSet != NULL);
+   assert(uIndex < ChildSet_getLength(oChildSet));
+
+   if (oChildSet->oTree != NULL)
+      return BTree_get(oChildSet->oTree, uIndex);
+   if (! oChildSet->iSorted)
+      ChildSet_sort(oChildSet);
+   return oChildSet->puChildren[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int ChildSet_find(ChildSet_T oChildSet, const char *pcKey)
+{
+   unsigned int uSlot;
+   size_t uIndex;
+
+   assert(oChildSet != NULL);
+   assert(pcKey != NULL);
+
+   if (oChildSet->oTree != NULL)
+      return BTree_find(oChildSet->oTree, pcKey);
+   if (oChildSet->puSlots != NULL)
+   {
+      uSlot = *ChildSet_probe(oChildSet, pcKey);
+      if (uSlot == 0)
+         return 0;
+      return oChildSet->puChildren[uSlot - 1];
+   }
+
+   if (! ChildSet_search(oChildSet, pcKey, &uIndex))
+      return 0;
+   return oChildSet->puChildren[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+int ChildSet_rank(ChildSet_T oChildSet, const char *pcKey,
+                  size_t *puIndex)
+{
+   assert(oChildSet != NULL);
+   assert(pcKey != NULL);
+   assert(puIndex != NULL);
+
+   if (oChildSet->oTree != NULL)
+      return BTree_search(oChildSet->oTree, pcKey, puIndex);
+   if (! oChildSet->iSorted)
+      ChildSet_sort(oChildSet);
+   return ChildSet_search(oChildSet, pcKey, puIndex);
+}
+
+/*--------------------------------------------------------------------*/
+
+int ChildSet_add(ChildSet_T oChildSet, unsigned int uChild)
+{
+   const char *pcName;
+   size_t uLength;
+   size_t uIndex;
+   int iFound;
+
+   assert(oChildSet != NULL);
+   assert(uChild != 0);
+
+   pcName = ChildSet_nameOf(oChildSet, uChild);
+   if (oChildSet->oTree != NULL)
+      return BTree_add(oChildSet->oTree, pcName, uChild);
+   uLength = oChildSet->uLength;
+
+   /* Keep a table at most half full, or else do without one. */
+   if (oChildSet->puSlots != NULL && 2 * (uLength + 1) >
+       oChildSet->uSlots &&
+       ! ChildSet_index(oChildSet, 2 * oChildSet->uSlots))
+      ChildSet_unindex(oChildSet);
+
+   if (oChildSet->puSlots == NULL)
+   {
+      iFound = ChildSet_search(oChildSet, pcName, &uIndex);
+      assert(! iFound);
+      (void)iFound;
+      if (! ChildSet_insertAt(oChildSet, uIndex, uChild))
+         return 0;
+
+      if (oChildSet->iShared || oChildSet->uThreshold == 0 ||
+          uLength + 1 <= oChildSet->uThreshold)
+         return 1;
+      if (oChildSet->iOrdered)
+         ChildSet_plant(oChildSet);
+      else
+         (void)ChildSet_index(oChildSet,
+                              ChildSet_slotsFor(uLength + 1));
+      return 1;
+   }
+
+   /* With a table, append the child, which leaves the array sorted
+      only if the child comes after the last. */
+   assert(*ChildSet_probe(oChildSet, pcName) == 0);
+   if (! ChildSet_insertAt(oChildSet, uLength, uChild))
+      return 0;
+   if (oChildSet->iSorted && uLength > 0 &&
+       strcmp(ChildSet_nameAt(oChildSet, uLength - 1), pcName) > 0)
+      oChildSet->iSorted = 0;
+   *ChildSet_probe(oChildSet, pcName) = (unsigned int)(uLength + 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int ChildSet_remove(ChildSet_T oChildSet, const char *pcKey)
+{
+   unsigned int uChild;
+   unsigned int uLastChild;
+   unsigned int *puSlot;
+   size_t uIndex;
+   size_t uLast;
+   size_t uThreshold;
+
+   assert(oChildSet != NULL);
+   assert(pcKey != NULL);
+
+   uThreshold = oChildSet->uThreshold;
+   if (oChildSet->oTree != NULL)
+   {
+      uChild = BTree_remove(oChildSet->oTree, pcKey);
+      if (uThreshold == 0 ||
+          BTree_getLength(oChildSet->oTree) < uThreshold / 2)
+         ChildSet_uproot(oChildSet);
+      return uChild;
+   }
+
+   if (oChildSet->puSlots == NULL)
+   {
+      if (! ChildSet_search(oChildSet, pcKey, &uIndex))
+         return 0;
+      return ChildSet_deleteAt(oChildSet, uIndex);
+   }
+
+   puSlot = ChildSet_probe(oChildSet, pcKey);
+   if (*puSlot == 0)
+      return 0;
+   uIndex = *puSlot - 1;
+   uChild = oChildSet->puChildren[uIndex];
+   ChildSet_vacate(oChildSet, (size_t)(puSlot - oChildSet->puSlots));
+
+   /* Fill the gap with the last child, rather than shifting every
+      child after it, unless the child removed is the last. */
+   uLast = oChildSet->uLength - 1;
+   if (uIndex != uLast)
+   {
+      uLastChild = oChildSet->puChildren[uLast];
+      oChildSet->puChildren[uIndex] = uLastChild;
+      *ChildSet_probe(oChildSet, ChildSet_nameOf(oChildSet, uLastChild))
+         = (unsigned int)(uIndex + 1);
+      oChildSet->iSorted = 0;
+   }
+   oChildSet->uLength--;
+
+   if (uThreshold == 0 || uLast < uThreshold / 2)
+      ChildSet_unindex(oChildSet);
+   return uChild;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ChildSet_map(ChildSet_T oChildSet,
+                  void (*pfApply)(unsigned int uChild, void *pvExtra),
+                  void *pvExtra)
+{
+   size_t u;
+
+   assert(oChildSet != NULL);
+   assert(pfApply != NULL);
+
+   if (oChildSet->oTree != NULL)
+   {
+      BTree_map(oChildSet->oTree, pfApply, pvExtra);
+      return;
+   }
+   for (u = 0; u < oChildSet->uLength; u++)
+      (*pfApply)(oChildSet->puChildren[u], pvExtra);
+}
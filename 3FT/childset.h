@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------*/
+/* childset.h                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef CHILDSET_INCLUDED
+#define CHILDSET_INCLUDED
+
+#include <stddef.h>
+#include "arena.h"
+
+/* A ChildSet_T object is the set of children of one kind of a
+   directory, each a nonzero unsigned int that stands for the child,
+   such as its index in a Slab, and each with a distinct name, which a
+   function given to the ChildSet finds.  Children are kept as such
+   32-bit values, rather than as pointers, in its array, its table
+   and its BTree alike, so that they take half the space.
+
+   A small ChildSet is an array sorted by name.  Once it holds more
+   children than its threshold, it also keeps a hash table of them,
+   so that children are found, added and removed in constant expected
+   time, and lets the array fall out of order, sorting it again only
+   when a child is fetched by its position in name order.
+   Or, if the ChildSet is ordered, it moves its children to a BTree,
+   which keeps them in order at a cost logarithmic in their number for
+   every operation.  When it shrinks to half the threshold, it goes
+   back to a plain array.
+
+   A key, by which a child is looked up, is a name that ends at its
+   first slash, if it has one, so that the rest of a path can follow
+   it. */
+
+typedef struct ChildSet *ChildSet_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty ChildSet_T object, allocated from oArena, whose
+   children are named by (*pfGetName)(uChild, pvContext), and whose
+   threshold is uThreshold children, or NULL if insufficient memory is
+   available.  A uThreshold of 0 means that the ChildSet never keeps a
+   table.  Beyond its threshold, the ChildSet moves its children to a
+   BTree if iOrdered is 1 (TRUE), or keeps a hash table of them if
+   iOrdered is 0 (FALSE). */
+
+ChildSet_T ChildSet_new(Arena_T oArena,
+                        const char *(*pfGetName)(unsigned int uChild,
+                                                 void *pvContext),
+                        void *pvContext, size_t uThreshold,
+                        int iOrdered);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oChildSet. */
+
+void ChildSet_free(ChildSet_T oChildSet);
+
+/*--------------------------------------------------------------------*/
+
+/* Mark oChildSet as read by threads that hold no lock on it: it stays
+   a sorted array, whatever its size, so that no reading of it changes
+   it, and it may be copied by ChildSet_copy.  oChildSet must be a
+   plain array, as is the case while it is below the threshold. */
+
+void ChildSet_share(ChildSet_T oChildSet);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of the shared oChildSet, or NULL if insufficient
+   memory is available. */
+
+ChildSet_T ChildSet_copy(ChildSet_T oChildSet);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of children in oChildSet. */
+
+size_t ChildSet_getLength(ChildSet_T oChildSet);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the child at index uIndex of oChildSet, in order of names.
+   uIndex must be less than the number of children. */
+
+unsigned int ChildSet_get(ChildSet_T oChildSet, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the child of oChildSet named by pcKey, or 0 if there is
+   none.  Never changes oChildSet. */
+
+unsigned int ChildSet_find(ChildSet_T oChildSet, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Search oChildSet for the child named by pcKey.  Return 1 (TRUE) if
+   it is found, and 0 (FALSE) otherwise.  In either case, store in
+   *puIndex the index that such a child has, or would have, in order
+   of names. */
+
+int ChildSet_rank(ChildSet_T oChildSet, const char *pcKey,
+                  size_t *puIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add uChild to oChildSet, which must hold no child of the same
+   name.  Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+   memory is available. */
+
+int ChildSet_add(ChildSet_T oChildSet, unsigned int uChild);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the child named by pcKey from oChildSet, and return it, or
+   return 0 if there is none. */
+
+unsigned int ChildSet_remove(ChildSet_T oChildSet, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(uChild, pvExtra) for each child uChild of
+   oChildSet, in no particular order.  pfApply must not change
+   oChildSet. */
+
+void ChildSet_map(ChildSet_T oChildSet,
+                  void (*pfApply)(unsigned int uChild, void *pvExtra),
+                  void *pvExtra);
+
+#endif
@@ -6,6 +6,7 @@
 #include "dynarray.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -30,6 +31,10 @@ struct DynArray
 
    /* The array that underlies the DynArray. */
    const void **ppvArray;
+
+   /* The Arena from which the DynArray and its array are allocated,
+      or NULL if they are allocated from the heap. */
+   Arena_T oArena;
 };
 
 /*--------------------------------------------------------------------*/
@@ -65,10 +70,26 @@ static int DynArray_grow(DynArray_T oDynArray)
 
    uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
 
-   ppvNewArray = (const void**)
-      realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
-   if (ppvNewArray == NULL)
-      return 0;
+   if (oDynArray->oArena == NULL)
+   {
+      ppvNewArray = (const void**)
+         realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
+      if (ppvNewArray == NULL)
+         return 0;
+   }
+   else
+   {
+      /* An Arena cannot resize a block in place, so move the
+         elements to a new block and release the old one. */
+      ppvNewArray = (const void**)
+         Arena_alloc(oDynArray->oArena, sizeof(void*) * uNewLength);
+      if (ppvNewArray == NULL)
+         return 0;
+      memcpy((void*)ppvNewArray, (const void*)oDynArray->ppvArray,
+             sizeof(void*) * oDynArray->uPhysLength);
+      Arena_release(oDynArray->oArena, (void*)oDynArray->ppvArray,
+                    sizeof(void*) * oDynArray->uPhysLength);
+   }
 
    oDynArray->uPhysLength = uNewLength;
    oDynArray->ppvArray = ppvNewArray;
@@ -78,10 +99,18 @@ static int DynArray_grow(DynArray_T oDynArray)
 /*--------------------------------------------------------------------*/
 
 DynArray_T DynArray_new(size_t uLength)
+{
+   return DynArray_newIn(uLength, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+DynArray_T DynArray_newIn(size_t uLength, Arena_T oArena)
 {
    DynArray_T oDynArray;
 
-   oDynArray = (struct DynArray*)malloc(sizeof(struct DynArray));
+   oDynArray = (struct DynArray*)
+      Arena_alloc(oArena, sizeof(struct DynArray));
    if (oDynArray == NULL)
       return NULL;
 
@@ -90,12 +119,22 @@ DynArray_T DynArray_new(size_t uLength)
       oDynArray->uPhysLength = uLength;
    else
       oDynArray->uPhysLength = MIN_PHYS_LENGTH;
+   oDynArray->oArena = oArena;
 
-   oDynArray->ppvArray =
-      (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
+   if (oArena == NULL)
+      oDynArray->ppvArray =
+         (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
+   else
+   {
+      oDynArray->ppvArray = (const void**)
+         Arena_alloc(oArena, sizeof(void*) * oDynArray->uPhysLength);
+      if (oDynArray->ppvArray != NULL)
+         memset((void*)oDynArray->ppvArray, 0,
+                sizeof(void*) * oDynArray->uPhysLength);
+   }
    if (oDynArray->ppvArray == NULL)
    {
-      free(oDynArray);
+      Arena_release(oArena, oDynArray, sizeof(struct DynArray));
       return NULL;
    }
 
@@ -104,13 +143,38 @@ DynArray_T DynArray_new(size_t uLength)
 
 /*--------------------------------------------------------------------*/
 
+DynArray_T DynArray_copy(DynArray_T oDynArray)
+{
+   DynArray_T oCopy;
+
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   /* Keep the spare capacity, so that a copy made to add an element
+      seldom has to grow. */
+   oCopy = DynArray_newIn(oDynArray->uPhysLength, oDynArray->oArena);
+   if (oCopy == NULL)
+      return NULL;
+
+   oCopy->uLength = oDynArray->uLength;
+   memcpy((void*)oCopy->ppvArray, (const void*)oDynArray->ppvArray,
+          sizeof(void*) * oDynArray->uLength);
+
+   assert(DynArray_isValid(oCopy));
+
+   return oCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
 void DynArray_free(DynArray_T oDynArray)
 {
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   free(oDynArray->ppvArray);
-   free(oDynArray);
+   Arena_release(oDynArray->oArena, (void*)oDynArray->ppvArray,
+                 sizeof(void*) * oDynArray->uPhysLength);
+   Arena_release(oDynArray->oArena, oDynArray, sizeof(struct DynArray));
 }
 
 /*--------------------------------------------------------------------*/
@@ -432,3 +496,32 @@ int DynArray_bsearch(DynArray_T oDynArray,
    *puIndex = (size_t)(ppvElement - &oDynArray->ppvArray[0]);
    return 1;
 }
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_bsearchKey(DynArray_T oDynArray,
+                        const void *pvKey,
+                        size_t *puIndex,
+                        int (*pfCompareKey)(const void *pvKey,
+                                            const void *pvElement))
+{
+   assert(oDynArray != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompareKey != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   /* A key beyond the last element, as when elements are added in
+      order, is placed without a search. */
+   if (oDynArray->uLength == 0 ||
+       (*pfCompareKey)(pvKey,
+          oDynArray->ppvArray[oDynArray->uLength - 1]) > 0)
+   {
+      *puIndex = oDynArray->uLength;
+      return 0;
+   }
+
+   /* DynArray_bsearch always passes the sought element as the first
+      argument of the comparison, so the key can stand in for it. */
+   return DynArray_bsearch(oDynArray, (void*)pvKey, puIndex,
+                           pfCompareKey);
+}
@@ -7,6 +7,7 @@
 #define DYNARRAY_INCLUDED
 
 #include <stddef.h>
+#include "arena.h"
 
 /* A DynArray_T object is an array whose length can expand
    dynamically. */
@@ -22,7 +23,24 @@ DynArray_T DynArray_new(size_t uLength);
 
 /*--------------------------------------------------------------------*/
 
-/* Free oDynArray. */
+/* Return a new DynArray_T object whose length is uLength, allocated
+   along with its underlying array from oArena, or NULL if
+   insufficient memory is available.  If oArena is NULL, this is
+   equivalent to DynArray_new.  oArena must outlive the object. */
+
+DynArray_T DynArray_newIn(size_t uLength, Arena_T oArena);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new DynArray_T object with the same length and elements as
+   oDynArray, allocated from the same Arena, or NULL if insufficient
+   memory is available. */
+
+DynArray_T DynArray_copy(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oDynArray, releasing it to its Arena if it has one. */
 
 void DynArray_free(DynArray_T oDynArray);
 
@@ -129,4 +147,24 @@ int DynArray_bsearch(DynArray_T oDynArray,
                      int (*pfCompare)(const void *pvElement1,
                                       const void *pvElement2));
 
+/*--------------------------------------------------------------------*/
+
+/* Binary search oDynArray for the element that matches pvKey using
+   *pfCompareKey, which compares a key with an element, so that no
+   element needs to be built just to be searched for.  If such an
+   element is found, then assign its index to *puIndex and return 1.
+   If not, then assign the index where it would belong to *puIndex and
+   return 0.
+   *pfCompareKey must return <0, 0, or >0 if pvKey is less than,
+   matches, or is greater than *pvElement.
+   oDynArray must be sorted consistently with *pfCompareKey.
+   A key greater than the last element is placed after a single
+   comparison, so searching in increasing order takes constant time. */
+
+int DynArray_bsearchKey(DynArray_T oDynArray,
+                        const void *pvKey,
+                        size_t *puIndex,
+                        int (*pfCompareKey)(const void *pvKey,
+                                            const void *pvElement));
+
 #endif
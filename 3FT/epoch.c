@@ -0,0 +1,466 @@
+/*--------------------------------------------------------------------*/
+/* epoch.c                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthreads, posix_memalign and sched_yield, which -ansi would
+   otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include "epoch.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The size of a cache line, which separates the memory that each
+   reader writes from the memory that any other thread writes. */
+
+enum { CACHE_LINE = 64 };
+
+/*--------------------------------------------------------------------*/
+
+/* A Record announces whether one thread is inside an Epoch, and since
+   which global epoch.  It fills a cache line of its own. */
+
+union Record
+{
+   /* The fields. */
+   struct
+   {
+      /* The global epoch when the owning thread entered, or 0 if it
+         is outside. */
+      unsigned long ulEpoch;
+
+      /* The number of calls of Epoch_enter not yet left, which only
+         the owning thread reads or writes. */
+      unsigned long ulDepth;
+
+      /* 1 (TRUE) while a thread owns the Record, and 0 (FALSE) once
+         it has exited and the Record may be reused. */
+      int iOwned;
+
+      /* The next Record of the Epoch. */
+      union Record *psNext;
+   } sFields;
+
+   /* Padding, to fill the cache line. */
+   char acPadding[CACHE_LINE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Retired block is waiting for the readers that might still be
+   using it to leave. */
+
+struct Retired
+{
+   /* The block and how to free it. */
+   void *pvBlock;
+   void (*pfFree)(void *pvBlock, void *pvExtra);
+   void *pvExtra;
+
+   /* The global epoch when the block was retired. */
+   unsigned long ulEpoch;
+
+   /* The Retired block that was retired next. */
+   struct Retired *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An Epoch consists of the global epoch, a Record per thread that has
+   entered it, and the blocks retired to it, in the order they were
+   retired. */
+
+struct Epoch
+{
+   /* The global epoch, which starts at 1.  Every reader reads it, and
+      only writers write it, so it is alone on its cache line. */
+   union
+   {
+      unsigned long ulEpoch;
+      char acPadding[CACHE_LINE];
+   } uGlobal;
+
+   /* The number of readers inside that could not be given a Record,
+      which keep the global epoch from advancing at all. */
+   unsigned long ulUnrecorded;
+
+   /* The Records, most recent first. */
+   union Record *psRecords;
+
+   /* The Retired blocks, oldest first. */
+   struct Retired *psFirstRetired;
+   struct Retired *psLastRetired;
+
+   /* The mutex serializing writers, which guards psRecords and the
+      Retired blocks, and the advancing of the global epoch. */
+   pthread_mutex_t sLock;
+
+   /* The key under which each thread finds its Record. */
+   pthread_key_t sKey;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Give up the Record pvRecord of a thread that is exiting, so that
+   another thread can reuse it. */
+
+static void Epoch_disown(void *pvRecord)
+{
+   union Record *psRecord = (union Record*)pvRecord;
+
+   assert(psRecord != NULL);
+
+   __atomic_store_n(&psRecord->sFields.iOwned, 0, __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------*/
+
+Epoch_T Epoch_new(void)
+{
+   Epoch_T oEpoch;
+   void *pvEpoch;
+
+   if (posix_memalign(&pvEpoch, CACHE_LINE, sizeof(struct Epoch)) != 0)
+      return NULL;
+   oEpoch = (struct Epoch*)pvEpoch;
+
+   oEpoch->uGlobal.ulEpoch = 1;
+   oEpoch->ulUnrecorded = 0;
+   oEpoch->psRecords = NULL;
+   oEpoch->psFirstRetired = NULL;
+   oEpoch->psLastRetired = NULL;
+
+   if (pthread_mutex_init(&oEpoch->sLock, NULL) != 0)
+   {
+      free(oEpoch);
+      return NULL;
+   }
+   if (pthread_key_create(&oEpoch->sKey, Epoch_disown) != 0)
+   {
+      (void)pthread_mutex_destroy(&oEpoch->sLock);
+      free(oEpoch);
+      return NULL;
+   }
+
+   return oEpoch;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_free(Epoch_T oEpoch)
+{
+   union Record *psRecord;
+   union Record *psNextRecord;
+
+   if (oEpoch == NULL)
+      return;
+
+   Epoch_flush(oEpoch);
+
+   for (psRecord = oEpoch->psRecords; psRecord != NULL;
+        psRecord = psNextRecord)
+   {
+      psNextRecord = psRecord->sFields.psNext;
+      free(psRecord);
+   }
+
+   (void)pthread_key_delete(oEpoch->sKey);
+   (void)pthread_mutex_destroy(&oEpoch->sLock);
+   free(oEpoch);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_flush(Epoch_T oEpoch)
+{
+   struct Retired *psRetired;
+   struct Retired *psNextRetired;
+
+   if (oEpoch == NULL)
+      return;
+
+   /* Freeing a block may retire more, which are freed in turn. */
+   while (oEpoch->psFirstRetired != NULL)
+   {
+      psRetired = oEpoch->psFirstRetired;
+      oEpoch->psFirstRetired = NULL;
+      oEpoch->psLastRetired = NULL;
+      for (; psRetired != NULL; psRetired = psNextRetired)
+      {
+         psNextRetired = psRetired->psNext;
+         (*psRetired->pfFree)(psRetired->pvBlock, psRetired->pvExtra);
+         free(psRetired);
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a Record for the calling thread in oEpoch, reusing one given
+   up by a thread that has exited if there is one, or NULL if
+   insufficient memory is available. */
+
+static union Record *Epoch_register(Epoch_T oEpoch)
+{
+   union Record *psRecord;
+   void *pvRecord;
+
+   assert(oEpoch != NULL);
+
+   (void)pthread_mutex_lock(&oEpoch->sLock);
+
+   for (psRecord = oEpoch->psRecords; psRecord != NULL;
+        psRecord = psRecord->sFields.psNext)
+      if (! __atomic_load_n(&psRecord->sFields.iOwned,
+                            __ATOMIC_ACQUIRE))
+         break;
+
+   if (psRecord == NULL)
+   {
+      if (posix_memalign(&pvRecord, CACHE_LINE,
+                         sizeof(union Record)) != 0)
+      {
+         (void)pthread_mutex_unlock(&oEpoch->sLock);
+         return NULL;
+      }
+      psRecord = (union Record*)pvRecord;
+      psRecord->sFields.ulEpoch = 0;
+      psRecord->sFields.psNext = oEpoch->psRecords;
+      oEpoch->psRecords = psRecord;
+   }
+   psRecord->sFields.ulDepth = 0;
+   psRecord->sFields.iOwned = 1;
+
+   (void)pthread_mutex_unlock(&oEpoch->sLock);
+
+   if (pthread_setspecific(oEpoch->sKey, psRecord) != 0)
+   {
+      Epoch_disown(psRecord);
+      return NULL;
+   }
+   return psRecord;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_enter(Epoch_T oEpoch)
+{
+   union Record *psRecord;
+   unsigned long ulEpoch;
+
+   if (oEpoch == NULL)
+      return;
+
+   psRecord = (union Record*)pthread_getspecific(oEpoch->sKey);
+   if (psRecord == NULL)
+      psRecord = Epoch_register(oEpoch);
+   if (psRecord == NULL)
+   {
+      __atomic_add_fetch(&oEpoch->ulUnrecorded, 1, __ATOMIC_SEQ_CST);
+      return;
+   }
+
+   if (psRecord->sFields.ulDepth++ > 0)
+      return;
+
+   /* Announce the epoch before reading anything it protects. */
+   ulEpoch = __atomic_load_n(&oEpoch->uGlobal.ulEpoch,
+                             __ATOMIC_RELAXED);
+   __atomic_store_n(&psRecord->sFields.ulEpoch, ulEpoch,
+                    __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_leave(Epoch_T oEpoch)
+{
+   union Record *psRecord;
+
+   if (oEpoch == NULL)
+      return;
+
+   /* A thread without a Record, or whose Record was only given to it
+      by a nested call, entered as an unrecorded reader. */
+   psRecord = (union Record*)pthread_getspecific(oEpoch->sKey);
+   if (psRecord == NULL || psRecord->sFields.ulDepth == 0)
+   {
+      __atomic_sub_fetch(&oEpoch->ulUnrecorded, 1, __ATOMIC_RELEASE);
+      return;
+   }
+
+   if (--psRecord->sFields.ulDepth == 0)
+      __atomic_store_n(&psRecord->sFields.ulEpoch, 0,
+                       __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Advance oEpoch's global epoch, if every reader inside has seen its
+   current value.  Return 1 (TRUE) if it advanced, and 0 (FALSE)
+   otherwise.  oEpoch's mutex must be held. */
+
+static int Epoch_advance(Epoch_T oEpoch)
+{
+   union Record *psRecord;
+   unsigned long ulEpoch;
+   unsigned long ulSeen;
+
+   assert(oEpoch != NULL);
+
+   if (__atomic_load_n(&oEpoch->ulUnrecorded, __ATOMIC_SEQ_CST) != 0)
+      return 0;
+
+   ulEpoch = oEpoch->uGlobal.ulEpoch;
+   for (psRecord = oEpoch->psRecords; psRecord != NULL;
+        psRecord = psRecord->sFields.psNext)
+   {
+      ulSeen = __atomic_load_n(&psRecord->sFields.ulEpoch,
+                               __ATOMIC_SEQ_CST);
+      if (ulSeen != 0 && ulSeen != ulEpoch)
+         return 0;
+   }
+
+   __atomic_store_n(&oEpoch->uGlobal.ulEpoch, ulEpoch + 1,
+                    __ATOMIC_SEQ_CST);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Unlink from oEpoch the Retired blocks that no reader can be using
+   any more, and return them, in a list linked through psNext.
+   oEpoch's mutex must be held. */
+
+static struct Retired *Epoch_expire(Epoch_T oEpoch)
+{
+   struct Retired *psExpired;
+   struct Retired *psRetired;
+   struct Retired *psPrev = NULL;
+
+   assert(oEpoch != NULL);
+
+   /* A block retired in epoch e may still be in use by readers that
+      entered in e - 1 or e, and by no others once the global epoch
+      has reached e + 2. */
+   psExpired = oEpoch->psFirstRetired;
+   for (psRetired = psExpired; psRetired != NULL;
+        psRetired = psRetired->psNext)
+   {
+      if (psRetired->ulEpoch + 2 > oEpoch->uGlobal.ulEpoch)
+         break;
+      psPrev = psRetired;
+   }
+   if (psPrev == NULL)
+      return NULL;
+
+   oEpoch->psFirstRetired = psPrev->psNext;
+   if (oEpoch->psFirstRetired == NULL)
+      oEpoch->psLastRetired = NULL;
+   psPrev->psNext = NULL;
+   return psExpired;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the blocks of psExpired, a list returned by Epoch_expire, and
+   its Retired records.  Called outside oEpoch's mutex, since freeing
+   a large block can take a while. */
+
+static void Epoch_freeExpired(struct Retired *psExpired)
+{
+   struct Retired *psNextExpired;
+
+   for (; psExpired != NULL; psExpired = psNextExpired)
+   {
+      psNextExpired = psExpired->psNext;
+      (*psExpired->pfFree)(psExpired->pvBlock, psExpired->pvExtra);
+      free(psExpired);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_retire(Epoch_T oEpoch, void *pvBlock,
+                  void (*pfFree)(void *pvBlock, void *pvExtra),
+                  void *pvExtra)
+{
+   struct Retired *psRetired;
+   struct Retired *psNextRetired;
+   union Record *psRecord;
+   unsigned long ulTarget;
+
+   assert(pfFree != NULL);
+
+   if (oEpoch == NULL)
+   {
+      (*pfFree)(pvBlock, pvExtra);
+      return;
+   }
+
+   /* Order the unlinking of pvBlock before the reading of the
+      readers' Records. */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   psRetired = (struct Retired*)malloc(sizeof(struct Retired));
+
+   /* A thread that is inside, or may be, keeps the global epoch from
+      advancing far enough for pvBlock to be freed at once, and may
+      hold locks that the other readers wait for, so it waits for
+      memory instead, which the blocks expired meanwhile may give
+      back. */
+   psRecord = (union Record*)pthread_getspecific(oEpoch->sKey);
+   while (psRetired == NULL &&
+          (psRecord == NULL || psRecord->sFields.ulDepth > 0))
+   {
+      (void)pthread_mutex_lock(&oEpoch->sLock);
+      (void)Epoch_advance(oEpoch);
+      psNextRetired = Epoch_expire(oEpoch);
+      (void)pthread_mutex_unlock(&oEpoch->sLock);
+      if (psNextRetired == NULL)
+         (void)sched_yield();
+      Epoch_freeExpired(psNextRetired);
+      psRetired = (struct Retired*)malloc(sizeof(struct Retired));
+   }
+
+   (void)pthread_mutex_lock(&oEpoch->sLock);
+   if (psRetired == NULL)
+   {
+      /* Without memory to defer the block, wait for the readers that
+         might be using it to leave, and free it now. */
+      ulTarget = oEpoch->uGlobal.ulEpoch + 2;
+      while (oEpoch->uGlobal.ulEpoch < ulTarget)
+         if (! Epoch_advance(oEpoch))
+         {
+            (void)pthread_mutex_unlock(&oEpoch->sLock);
+            (void)sched_yield();
+            (void)pthread_mutex_lock(&oEpoch->sLock);
+         }
+   }
+   else
+   {
+      psRetired->pvBlock = pvBlock;
+      psRetired->pfFree = pfFree;
+      psRetired->pvExtra = pvExtra;
+      psRetired->ulEpoch = oEpoch->uGlobal.ulEpoch;
+      psRetired->psNext = NULL;
+      if (oEpoch->psLastRetired == NULL)
+         oEpoch->psFirstRetired = psRetired;
+      else
+         oEpoch->psLastRetired->psNext = psRetired;
+      oEpoch->psLastRetired = psRetired;
+      (void)Epoch_advance(oEpoch);
+   }
+   psNextRetired = Epoch_expire(oEpoch);
+   (void)pthread_mutex_unlock(&oEpoch->sLock);
+
+   if (psRetired == NULL)
+      (*pfFree)(pvBlock, pvExtra);
+
+   Epoch_freeExpired(psNextRetired);
+}
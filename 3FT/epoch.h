@@ -0,0 +1,81 @@
+/*--------------------------------------------------------------------*/
+/* epoch.h                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef EPOCH_INCLUDED
+#define EPOCH_INCLUDED
+
+/* An Epoch_T object defers the freeing of shared memory until no
+   reader can still be using it, so that readers need take no locks.
+   A reader brackets its use of the shared structure with Epoch_enter
+   and Epoch_leave.  A writer that unlinks a block from the structure
+   passes it to Epoch_retire, which frees it only once every reader
+   that was inside when it was unlinked has left.
+
+   Each thread announces itself in its own record, on its own cache
+   line, so readers on different processors write to no common memory.
+   A global epoch advances when every reader inside has seen its
+   current value; a block retired in one epoch is freed two epochs
+   later.
+
+   Every function accepts a NULL oEpoch to mean that there are no
+   concurrent readers: Epoch_enter and Epoch_leave do nothing, and
+   Epoch_retire frees the block at once. */
+
+typedef struct Epoch *Epoch_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Epoch_T object, or NULL if insufficient memory is
+   available. */
+
+Epoch_T Epoch_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free every block still retired to oEpoch, and then oEpoch itself.
+   No thread may be inside oEpoch.  oEpoch may be NULL, in which case
+   nothing is freed. */
+
+void Epoch_free(Epoch_T oEpoch);
+
+/*--------------------------------------------------------------------*/
+
+/* Free every block still retired to oEpoch, including any retired
+   while they are freed, without waiting.  No thread may be inside
+   oEpoch.  oEpoch may be NULL, in which case nothing is freed. */
+
+void Epoch_flush(Epoch_T oEpoch);
+
+/*--------------------------------------------------------------------*/
+
+/* Mark the calling thread as a reader inside oEpoch, so that no block
+   it can reach is freed until it calls Epoch_leave.  Calls may be
+   nested. */
+
+void Epoch_enter(Epoch_T oEpoch);
+
+/*--------------------------------------------------------------------*/
+
+/* Mark the calling thread as having left oEpoch, matching its last
+   call of Epoch_enter. */
+
+void Epoch_leave(Epoch_T oEpoch);
+
+/*--------------------------------------------------------------------*/
+
+/* Arrange for (*pfFree)(pvBlock, pvExtra) to be called once no thread
+   that was inside oEpoch when pvBlock was unlinked can still be inside.
+   pvBlock must already be unreachable to readers that enter from now
+   on.  The calling thread may be inside oEpoch.  Blocks retired
+   earlier may be freed during the call.  If there is no memory to
+   defer pvBlock, a thread outside oEpoch waits for the readers that
+   may be using it and frees it at once, and a thread inside waits for
+   memory to be freed. */
+
+void Epoch_retire(Epoch_T oEpoch, void *pvBlock,
+                  void (*pfFree)(void *pvBlock, void *pvExtra),
+                  void *pvExtra);
+
+#endif
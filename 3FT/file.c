@@ -8,41 +8,34 @@
 #include <assert.h>
 #include <stdio.h>
 
-#include "dynarray.h"
+#include "names.h"
 #include "node.h"
 #include "file.h"
 
 /*
-   A node structure represents a directory in the directory tree
+   A File structure represents a file in the directory tree. It comes
+   from the slab of its tree, and its name, the last component of its
+   path, is interned in the names attached to that slab. What only
+   reading or replacing the file's contents needs is kept in a record
+   of its own, so that lookups and listings, which read names, read
+   less memory.
 */
-struct node {
-   /* the full path of this directory */
-   char* path;
-
-   /* the parent directory of this directory
-      NULL for the root of the directory tree */
-   Node_T parent;
+struct file {
+   /* the index of the directory containing this file in the slab */
+   unsigned int parent;
 
-   /* the files of this directory
-      stored in sorted order by pathname */
-   DynArray_T fchildren;
+   /* the index of this file's contents record in the slab, or 0 for
+      a copy not yet given its contents by File_copyContents */
+   unsigned int cold;
 
-   /* the subdirectories of this directory
-      stored in sorted order by pathname */
-   DynArray_T dchildren;
+   /* the interned name of this file */
+   const char* name;
 };
 
 /*
-   A File structure represents a directory in the directory tree
+   A file's contents record.
 */
-struct file {
-   /* the full path of this directory */
-   char* path;
-
-   /* the parent directory of this directory
-      NULL for the root of the directory tree */
-   Node_T parent;
-
+struct file_contents {
    /* content contained in of the file File */
    void *contents;
 
@@ -50,64 +43,138 @@ struct file {
    size_t length;
 };
 
-/* see FT_file.h for specification */
-File_T File_create(const char* fname, Node_T parent, void* contents,
-                   size_t length)
-{
+/*
+   Returns the contents record of n.
+*/
+static struct file_contents* File_getCold(File_T n) {
+   assert(n != NULL);
+   assert(n->cold != 0);
+
+   return Slab_at(Slab_of(n), n->cold);
+}
+
+/*
+   Returns a new file named fname beneath parent, allocated from slab,
+   without a contents record, or NULL if there is an allocation error.
+*/
+static File_T File_createHot(const char* fname, Node_T parent,
+                             Slab_T slab) {
    File_T new;
-   char* path;
 
    assert(fname != NULL);
+   assert(parent != NULL);
 
-   new = malloc(sizeof(struct file));
+   /* allocates memory for the file, and shares its name with every
+      other use of it in the tree */
+   new = Slab_alloc(slab, sizeof(struct file));
    if(new == NULL)
       return NULL;
+   new->name = Names_intern(Slab_getClient(slab), fname,
+                            strlen(fname));
+   if(new->name == NULL) {
+      Slab_release(slab, new, sizeof(struct file));
+      return NULL;
+   }
+
+   new->parent = Slab_indexOf(parent);
+   new->cold = 0;
+   return new;
+}
+
+/*
+   Gives n, which has no contents record, one holding contents and
+   length, from n's slab.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean File_addCold(File_T n, void* contents, size_t length) {
+   struct file_contents* cold;
+
+   assert(n != NULL);
+   assert(n->cold == 0);
+
+   cold = Slab_alloc(Slab_of(n), sizeof(struct file_contents));
+   if(cold == NULL)
+      return FALSE;
+   cold->contents = contents;
+   cold->length = length;
+   n->cold = Slab_indexOf(cold);
+   return TRUE;
+}
 
-   if(parent == NULL)
-      path = malloc(strlen(fname)+1);
-   else
-      path = malloc(strlen(parent->path) + 1 + strlen(fname) + 1);
+/* see FT_file.h for specification */
+File_T File_create(const char* fname, Node_T parent, void* contents,
+                   size_t length, Slab_T slab)
+{
+   File_T new;
 
-   if(path == NULL) {
-      free(new);
+   new = File_createHot(fname, parent, slab);
+   if(new == NULL)
+      return NULL;
+   if(!File_addCold(new, contents, length)) {
+      File_destroy(new);
       return NULL;
    }
 
-   *path = '\0';
+   return new;
+}
+
+/* see FT_file.h for specification */
+File_T File_copy(File_T n, Node_T parent, Slab_T slab) {
+   assert(n != NULL);
 
-   if(parent != NULL) {
-      strcpy(path, parent->path);
-      strcat(path, "/");
-   }
-   strcat(path, fname);
+   return File_createHot(File_getName(n), parent, slab);
+}
 
-   new->path = path;
-   new->parent = parent;
-   new->contents = contents;
-   new->length = length;
+/* see FT_file.h for specification */
+boolean File_copyContents(File_T copy, File_T n) {
+   assert(copy != NULL);
+   assert(n != NULL);
 
-   return new;
+   return File_addCold(copy, File_getContents(n),
+                       File_getContentLength(n));
 }
 
 /* see FT_file.h for specification */
 void File_destroy(File_T n) {
    assert(n != NULL);
 
-   free(n->path);
-   free(n);
+   if(n->cold != 0)
+      Slab_release(Slab_of(n), File_getCold(n),
+                   sizeof(struct file_contents));
+   Names_release(Slab_getClient(Slab_of(n)), n->name);
+   Slab_release(Slab_of(n), n, sizeof(struct file));
 }
 
 /* see FT_file.h for specification */
-char* File_getPath(File_T n) {
-   char* pathCopy;
-
+const char* File_getName(File_T n) {
    assert(n != NULL);
 
-   pathCopy = malloc(strlen(n->path)+1);
-   if(pathCopy == NULL)
-      return NULL;
+   return n->name;
+}
+
+/* see FT_file.h for specification */
+size_t File_getPath(File_T n, char* buffer, size_t size) {
+   size_t parentLength;
+   size_t nameLength;
+   size_t copyLength;
+
+   assert(n != NULL);
+   assert(buffer != NULL || size == 0);
+
+   parentLength = Node_getPath(File_getParent(n), buffer, size);
+   nameLength = strlen(File_getName(n));
+
+   /* append the slash and as much of the name as fits */
+   if(parentLength + 1 < size) {
+      buffer[parentLength] = '/';
+      copyLength = size - parentLength - 2;
+      if(nameLength < copyLength)
+         copyLength = nameLength;
+      memcpy(buffer + parentLength + 1, File_getName(n), copyLength);
+      buffer[parentLength + 1 + copyLength] = '\0';
+   }
 
-   return strcpy(pathCopy, n->path);
+   return parentLength + 1 + nameLength;
 }
 
 
@@ -116,32 +183,38 @@ int File_compare(File_T File1, File_T File2) {
    assert(File1 != NULL);
    assert(File2 != NULL);
 
-   return strcmp(File1->path, File2->path);
+   if(File1->name == File2->name)
+      return 0;
+   return strcmp(File_getName(File1), File_getName(File2));
 }
 
 /* see FT_file.h for specification */
 Node_T File_getParent(File_T n) {
    assert(n != NULL);
 
-   return n->parent;
+   return Slab_at(Slab_of(n), n->parent);
 }
 
 /* see FT_file.h for specification */
 void* File_getContents(File_T n) {
    assert(n != NULL);
 
-   return n->contents;
+   return __atomic_load_n(&File_getCold(n)->contents, __ATOMIC_ACQUIRE);
 }
 
 /* see FT_file.h for specification */
 void* File_replaceContents(File_T n, void *contents, size_t length) {
+   struct file_contents* cold;
    void* original;
    assert(n != NULL);
 
-   original = n->contents;
+   cold = File_getCold(n);
+   original = cold->contents;
 
-   n->contents = contents;
-   n->length = length;
+   /* readers may load either field without a lock, so each is
+      replaced atomically */
+   __atomic_store_n(&cold->contents, contents, __ATOMIC_RELEASE);
+   __atomic_store_n(&cold->length, length, __ATOMIC_RELAXED);
 
    return original;
 }
@@ -150,74 +223,23 @@ void* File_replaceContents(File_T n, void *contents, size_t length) {
 size_t File_getContentLength(File_T n) {
    assert (n != NULL);
 
-   return n->length;
-}
-
-/* see node.h for specification */
-int File_linkChild(Node_T parent, File_T child) {
-   size_t i;
-   char* rest;
-
-   assert(parent != NULL);
-   assert(child != NULL);
-
-   /* check if a duplicate child already exists */
-   if(Node_hasFileChild(parent, child->path, NULL))
-      return ALREADY_IN_TREE;
-
-   /* check that parent path is a prefix of child path */
-   i = strlen(parent->path);
-   if(strncmp(child->path, parent->path, i))
-      return PARENT_CHILD_ERROR;
-
-   /* check that child path extends beyond parent path */
-   rest = child->path + i;
-   if(strlen(child->path) >= i && rest[0] != '/')
-      return PARENT_CHILD_ERROR;
-
-   /* check that child isn't a grandchild of parent */
-   rest++;
-   if(strstr(rest, "/") != NULL)
-      return PARENT_CHILD_ERROR;
-
-   child->parent = parent;
-
-   /* check that child isn't already linked, add child at given index */
-   if(DynArray_bsearch(parent->fchildren, child, &i,
-                       (int (*)(const void*, const void*))
-                       File_compare) == 1)
-      return ALREADY_IN_TREE;
-
-   if(DynArray_addAt(parent->fchildren, i, child) == TRUE)
-      return SUCCESS;
-   else
-      return PARENT_CHILD_ERROR;
-}
-
-/* see node.h for specification */
-void File_unlinkChild(Node_T parent, File_T child) {
-   size_t i = 0;
-
-   assert(parent != NULL);
-   assert(child != NULL);
-
-   if(DynArray_bsearch(parent->fchildren, child, &i,
-                       (int (*)(const void*, const void*))
-                       File_compare) != 0)
-      (void) DynArray_removeAt(parent->fchildren, i);
+   return __atomic_load_n(&File_getCold(n)->length, __ATOMIC_RELAXED);
 }
 
 /* see FT_file.h for specification */
 char* File_ToString(File_T n) {
    char* copyPath;
+   size_t length;
 
    assert(n != NULL);
 
-   copyPath = malloc(strlen(n->path)+1);
+   length = File_getPath(n, NULL, 0);
+   copyPath = malloc(length + 1);
    if(copyPath == NULL) {
       return NULL;
    }
    else {
-      return strcpy(copyPath, n->path);
+      (void) File_getPath(n, copyPath, length + 1);
+      return copyPath;
    }
 }
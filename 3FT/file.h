@@ -8,43 +8,74 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "arena.h"
 #include "elements.h"
+#include "slab.h"
 
 /*
-   Given a parent node and a file string fname, returns a new
+   Given a parent node and a file name fname, returns a new
    File_T or NULL if any allocation error occurs in creating
    the File or its fields.
 
-   The new structure is initialized to have its path as the parent's
-   path, which must exist, prefixed to the directory string parameter,
-   separated by a slash. It is also initialized with its parent link
-   as the parent parameter value, but the parent itself is not changed
-   to link to the new File.
+   Only the name is stored: the file's full path is the parent's path
+   followed by a slash and the name, and is rebuilt on demand by
+   File_getPath. The new structure is also initialized with its parent
+   link as the parent parameter value, but the parent itself is not
+   changed to link to the new File.
 
    The file contains a pointer to contents, and holds the length of the
    contents in its field length.
+
+   The File is allocated from slab, which must be the one that parent
+   came from, its name is interned in the Names_T attached to slab as
+   its client, and its contents and length are kept in a record of
+   their own.
 */
 
 File_T File_create(const char* fname, Node_T parent, void* contents,
-                   size_t length);
+                   size_t length, Slab_T slab);
 
 /*
-  Destroys the file n.
+  Destroys the file n, releasing its memory to its slab.
 */
 void File_destroy(File_T n);
 
+/*
+  Returns a copy of n beneath parent, which must be a copy of n's
+  parent, allocated from slab, or NULL if there is an allocation
+  error. The copy has no contents until File_copyContents gives it
+  n's, so that the contents of many copies can be placed together,
+  apart from their names; until then it may only be destroyed.
+*/
+File_T File_copy(File_T n, Node_T parent, Slab_T slab);
+
+/*
+  Gives copy, made from n by File_copy, n's contents and length, in a
+  record from copy's slab.
+  Returns TRUE, or FALSE if there is an allocation error.
+*/
+boolean File_copyContents(File_T copy, File_T n);
+
 
 /*
-  Compares File1 and File2 based on their paths.
+  Compares File1 and File2, which must be siblings, by their names.
   Returns <0, 0, or >0 if File1 is less than
   equal to, or greater than File2, respectively.
 */
 int File_compare(File_T File1, File_T File2);
 
 /*
-   Returns n's path.
+   Returns n's name, the last component of its path. The name is
+   owned by n and remains valid until n is destroyed; it must not be
+   modified or freed by the caller.
+*/
+const char* File_getName(File_T n);
+
+/*
+   Writes n's full path into buffer, which holds size characters, as
+   Node_getPath does. Returns the length of the full path.
 */
-char* File_getPath(File_T n);
+size_t File_getPath(File_T n, char* buffer, size_t size);
 
 /*
    Returns the parent Node of n, if it exists, otherwise returns NULL
@@ -69,22 +100,34 @@ size_t File_getContentLength(File_T n);
 /*
   Makes child a child of parent, if possible, and returns SUCCESS.
   This is not possible in the following cases:
-  * parent already has a child with child's path,
+  * parent already has a child with child's name,
     in which case: returns ALREADY_IN_TREE
-    * child's path is not parent's path + / + directory,
+    * child was not created with parent as its parent,
     or the parent cannot link to the child,
     in which cases: returns PARENT_CHILD_ERROR
+  Any memory that parent needs for its children is allocated from
+  arena, and a set of them keeps a hash table of them beyond
+  threshold children, or a B+tree of them if ordered, or neither if
+  threshold is 0.
+
+  Since this changes parent's children, it is implemented in node.c.
 */
-int File_linkChild(Node_T parent, File_T child);
+int File_linkChild(Node_T parent, File_T child, Arena_T arena,
+                   size_t threshold, boolean ordered);
 
 /*
-  Unlinks File parent from its File child, if it can be found in 
+  Unlinks File parent from its File child, if it can be found in
   the parent's children. child is unchanged.
+  Returns SUCCESS, or MEMORY_ERROR if parent's children are shared
+  with readers and their copy without child cannot be allocated, in
+  which case parent is unchanged.
+
+  Since this changes parent's children, it is implemented in node.c.
 */
-void File_unlinkChild(Node_T parent, File_T child);
+int File_unlinkChild(Node_T parent, File_T child);
 
 /*
-  Returns a string representation for n, 
+  Returns a string representation for n, its full path,
   or NULL if there is an allocation error.
   Allocates memory for the returned string,
   which is then owned by client!
@@ -0,0 +1,932 @@
+/*--------------------------------------------------------------------*/
+/* frozen.c                                                           */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "frozen.h"
+#include "bitvec.h"
+#include "hash.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of entries, and of characters of names, for which a
+   Frozen first makes room. */
+
+enum { MIN_ENTRIES = 16, MIN_NAMES = 256 };
+
+/* The number of bits in a word of the index's bit arrays, the most
+   levels that the index may have, and the bits that each level has
+   per path still to be placed in it. */
+
+enum { WORD_BITS = sizeof(size_t) * CHAR_BIT, MAX_LEVELS = 32,
+       GAMMA = 2 };
+
+/*--------------------------------------------------------------------*/
+
+/* What a search reads of an entry: its name, and where its children
+   are.  Kept apart from the rest, so that searches read less
+   memory. */
+
+struct Entry
+{
+   /* The offset of the entry's name in the pool of names. */
+   size_t uName;
+
+   /* The index in the array of children of the first child of the
+      entry, and the number of its children, which is 0 for a
+      file. */
+   size_t uFirst;
+   size_t uCount;
+};
+
+/* What only listings and the reading of files need of an entry. */
+
+struct Detail
+{
+   /* The entry's parent, or 0 for the root. */
+   size_t uParent;
+
+   /* The length of the entry's full path. */
+   size_t uPathLength;
+
+   /* The contents of the file, and their length. */
+   void *pvContents;
+   size_t uLength;
+
+   /* 1 (TRUE) if the entry is a file, and 0 (FALSE) if it is a
+      directory. */
+   int iIsFile;
+};
+
+/* A child of a directory, as laid out for searching. */
+
+struct Child
+{
+   /* The first bytes of the child's name, as made by
+      Frozen_prefix. */
+   size_t uPrefix;
+
+   /* The child's entry. */
+   size_t uEntry;
+};
+
+/* A child with its name, for sorting children with qsort. */
+
+struct Named
+{
+   const char *pcName;
+   size_t uEntry;
+};
+
+/* A Frozen consists of parallel arrays of Entries and Details, a pool
+   of the entries' names, and, once finished, an array of the children
+   of every directory. */
+
+struct Frozen
+{
+   /* The entries, and their details, in the order added, of which
+      there are uLength, with room for uCapacity. */
+   struct Entry *psEntries;
+   struct Detail *psDetails;
+   size_t uLength;
+   size_t uCapacity;
+
+   /* The names of the entries, each ending with '\0', taking
+      uNamesLength characters, with room for uNamesCapacity. */
+   char *pcNames;
+   size_t uNamesLength;
+   size_t uNamesCapacity;
+
+   /* The children of every directory, each directory's together, in
+      Eytzinger order, with element 0 unused, so that the children of
+      entry e are psChildren[psEntries[e].uFirst] onward.  NULL until
+      the Frozen is finished. */
+   struct Child *psChildren;
+
+   /* The length of the longest full path of an entry. */
+   size_t uMaxPathLength;
+
+   /* A minimal perfect hash of the full paths of the entries, which
+      maps each of them to its own slot, from 0 to uLength - 1, or, if
+      it could not be built, NULL puSlotEntries and pucFingerprints.
+      It is a cascade of uLevels bit arrays, stored one after another
+      in oBits: level l occupies auLevelWords[l] words from word
+      auLevelStart[l], and a path's bit in it is found by a hash of
+      the path seeded by l.  A path's slot is the number of bits set
+      before the first of its bits that is set. */
+   BitVec_T oBits;
+   size_t auLevelStart[MAX_LEVELS];
+   size_t auLevelWords[MAX_LEVELS];
+   size_t uLevels;
+
+   /* The entry in each slot, and a byte of the hash of its path, by
+      which most paths that are not entries are rejected without
+      reading the entry. */
+   unsigned int *puSlotEntries;
+   unsigned char *pucFingerprints;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first bytes of pcKey, which ends at its first slash, if
+   it has one, as many as a size_t holds, packed into a size_t with
+   the first byte most significant and with 0 for any byte past the
+   end, so that prefixes compare as numbers as their keys compare as
+   strings. */
+
+static size_t Frozen_prefix(const char *pcKey)
+{
+   size_t uPrefix = 0;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; u < sizeof(size_t); u++)
+   {
+      uPrefix <<= 8;
+      if (*pcKey != '\0' && *pcKey != '/')
+         uPrefix |= (unsigned char)*pcKey++;
+   }
+   return uPrefix;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare pcKey to pcName as strcmp would, except that pcKey ends at
+   its first slash, if it has one. */
+
+static int Frozen_compareKey(const char *pcKey, const char *pcName)
+{
+   assert(pcKey != NULL);
+   assert(pcName != NULL);
+
+   while (*pcKey == *pcName && *pcKey != '\0')
+   {
+      pcKey++;
+      pcName++;
+   }
+
+   if (*pcKey == '/')
+      return 0 - (int)(unsigned char)*pcName;
+   return (int)(unsigned char)*pcKey - (int)(unsigned char)*pcName;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the names of the Named children pvNamed1 and pvNamed2, for
+   qsort. */
+
+static int Frozen_compareNamed(const void *pvNamed1,
+                               const void *pvNamed2)
+{
+   assert(pvNamed1 != NULL);
+   assert(pvNamed2 != NULL);
+
+   return strcmp(((const struct Named*)pvNamed1)->pcName,
+                 ((const struct Named*)pvNamed2)->pcName);
+}
+
+/*--------------------------------------------------------------------*/
+
+Frozen_T Frozen_new(void)
+{
+   Frozen_T oFrozen;
+
+   oFrozen = (Frozen_T)calloc(1, sizeof(struct Frozen));
+   return oFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Frozen_free(Frozen_T oFrozen)
+{
+   if (oFrozen == NULL)
+      return;
+
+   free(oFrozen->psEntries);
+   free(oFrozen->psDetails);
+   free(oFrozen->pcNames);
+   free(oFrozen->psChildren);
+   BitVec_free(oFrozen->oBits);
+   free(oFrozen->puSlotEntries);
+   free(oFrozen->pucFingerprints);
+   free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oFrozen for one more entry, with a name of uNameLength
+   characters.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int Frozen_reserve(Frozen_T oFrozen, size_t uNameLength)
+{
+   struct Entry *psEntries;
+   struct Detail *psDetails;
+   char *pcNames;
+   size_t uCapacity;
+
+   assert(oFrozen != NULL);
+
+   if (oFrozen->uLength == oFrozen->uCapacity)
+   {
+      uCapacity = 2 * oFrozen->uCapacity;
+      if (uCapacity < MIN_ENTRIES)
+         uCapacity = MIN_ENTRIES;
+      psEntries = (struct Entry*)realloc(oFrozen->psEntries,
+                                         uCapacity *
+                                         sizeof(struct Entry));
+      if (psEntries == NULL)
+         return 0;
+      oFrozen->psEntries = psEntries;
+      psDetails = (struct Detail*)realloc(oFrozen->psDetails,
+                                          uCapacity *
+                                          sizeof(struct Detail));
+      if (psDetails == NULL)
+         return 0;
+      oFrozen->psDetails = psDetails;
+      oFrozen->uCapacity = uCapacity;
+   }
+
+   if (oFrozen->uNamesCapacity - oFrozen->uNamesLength <= uNameLength)
+   {
+      uCapacity = 2 * oFrozen->uNamesCapacity;
+      if (uCapacity < MIN_NAMES)
+         uCapacity = MIN_NAMES;
+      if (uCapacity - oFrozen->uNamesLength <= uNameLength)
+         uCapacity = oFrozen->uNamesLength + uNameLength + 1;
+      pcNames = (char*)realloc(oFrozen->pcNames, uCapacity);
+      if (pcNames == NULL)
+         return 0;
+      oFrozen->pcNames = pcNames;
+      oFrozen->uNamesCapacity = uCapacity;
+   }
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_add(Frozen_T oFrozen, size_t uParent, const char *pcName,
+               int iIsFile, void *pvContents, size_t uLength)
+{
+   struct Entry *psEntry;
+   struct Detail *psDetail;
+   size_t uNameLength;
+
+   assert(oFrozen != NULL);
+   assert(pcName != NULL);
+   assert(oFrozen->psChildren == NULL);
+
+   uNameLength = strlen(pcName);
+   if (! Frozen_reserve(oFrozen, uNameLength))
+      return 0;
+
+   psEntry = &oFrozen->psEntries[oFrozen->uLength];
+   psDetail = &oFrozen->psDetails[oFrozen->uLength];
+
+   psEntry->uName = oFrozen->uNamesLength;
+   psEntry->uFirst = 0;
+   psEntry->uCount = 0;
+   memcpy(oFrozen->pcNames + oFrozen->uNamesLength, pcName,
+          uNameLength + 1);
+   oFrozen->uNamesLength += uNameLength + 1;
+
+   if (oFrozen->uLength == 0)
+   {
+      psDetail->uParent = 0;
+      psDetail->uPathLength = uNameLength;
+   }
+   else
+   {
+      assert(uParent < oFrozen->uLength);
+      assert(! oFrozen->psDetails[uParent].iIsFile);
+      psDetail->uParent = uParent;
+      psDetail->uPathLength =
+         oFrozen->psDetails[uParent].uPathLength + 1 + uNameLength;
+      oFrozen->psEntries[uParent].uCount++;
+   }
+   psDetail->pvContents = pvContents;
+   psDetail->uLength = uLength;
+   psDetail->iIsFile = iIsFile;
+
+   if (psDetail->uPathLength > oFrozen->uMaxPathLength)
+      oFrozen->uMaxPathLength = psDetail->uPathLength;
+   oFrozen->uLength++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lay out the subtree rooted at position uPosition of the Eytzinger
+   array psBase[1..uCount] from psNamed, in order of names, starting
+   at psNamed[uNext].  Return the index in psNamed after the last one
+   laid out. */
+
+static size_t Frozen_layOut(const struct Named *psNamed,
+                            struct Child *psBase, size_t uCount,
+                            size_t uNext, size_t uPosition)
+{
+   assert(psNamed != NULL);
+   assert(psBase != NULL);
+
+   if (uPosition <= uCount)
+   {
+      uNext = Frozen_layOut(psNamed, psBase, uCount, uNext,
+                            2 * uPosition);
+      psBase[uPosition].uPrefix = Frozen_prefix(psNamed[uNext].pcName);
+      psBase[uPosition].uEntry = psNamed[uNext].uEntry;
+      uNext++;
+      uNext = Frozen_layOut(psNamed, psBase, uCount, uNext,
+                            2 * uPosition + 1);
+   }
+   return uNext;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash uHash of a path mixed with the seed uSeed, so that
+   each seed gives an independent hash of the path. */
+
+static size_t Frozen_mix(size_t uHash, size_t uSeed)
+{
+   size_t uMixed;
+
+   uMixed = uHash + (uSeed + 1) * (size_t)0x9e3779b97f4a7c15UL;
+   uMixed = (uMixed ^ (uMixed >> 30)) * (size_t)0xbf58476d1ce4e5b9UL;
+   uMixed = (uMixed ^ (uMixed >> 27)) * (size_t)0x94d049bb133111ebUL;
+   return uMixed ^ (uMixed >> 31);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the fingerprint of a path whose hash is uHash. */
+
+static unsigned char Frozen_fingerprint(size_t uHash)
+{
+   return (unsigned char)(Frozen_mix(uHash, MAX_LEVELS)
+                          >> (WORD_BITS - CHAR_BIT));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bit uBit of the bit array puBits. */
+
+static int Frozen_testBit(const size_t *puBits, size_t uBit)
+{
+   assert(puBits != NULL);
+
+   return (int)((puBits[uBit / WORD_BITS] >> (uBit % WORD_BITS)) & 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the bit uBit of the bit array puBits. */
+
+static void Frozen_setBit(size_t *puBits, size_t uBit)
+{
+   assert(puBits != NULL);
+
+   puBits[uBit / WORD_BITS] |= (size_t)1 << (uBit % WORD_BITS);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bit that the path whose hash is uHash has in the level
+   uLevel of the index of oFrozen, counting from the start of the
+   level. */
+
+static size_t Frozen_levelBit(Frozen_T oFrozen, size_t uHash,
+                              size_t uLevel)
+{
+   assert(oFrozen != NULL);
+
+   return Frozen_mix(uHash, uLevel) %
+      (oFrozen->auLevelWords[uLevel] * WORD_BITS);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the slot of the path whose hash is uHash in the index of
+   oFrozen.  Return 1 (TRUE) if the path has one, storing it in
+   *puSlot, and 0 (FALSE) if no path with that hash is an entry. */
+
+static int Frozen_slotOf(Frozen_T oFrozen, size_t uHash,
+                         size_t *puSlot)
+{
+   size_t uLevel;
+   size_t uBit;
+
+   assert(oFrozen != NULL);
+   assert(puSlot != NULL);
+
+   for (uLevel = 0; uLevel < oFrozen->uLevels; uLevel++)
+   {
+      uBit = oFrozen->auLevelStart[uLevel] * WORD_BITS +
+         Frozen_levelBit(oFrozen, uHash, uLevel);
+      if (! BitVec_get(oFrozen->oBits, uBit))
+         continue;
+
+      *puSlot = BitVec_rank(oFrozen->oBits, uBit);
+      return 1;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free whatever of the index of oFrozen has been built, leaving it
+   without one. */
+
+static void Frozen_dropIndex(Frozen_T oFrozen)
+{
+   assert(oFrozen != NULL);
+
+   BitVec_free(oFrozen->oBits);
+   free(oFrozen->puSlotEntries);
+   free(oFrozen->pucFingerprints);
+   oFrozen->oBits = NULL;
+   oFrozen->puSlotEntries = NULL;
+   oFrozen->pucFingerprints = NULL;
+   oFrozen->uLevels = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build the levels of the index of oFrozen for the uRemaining paths
+   whose hashes are puHashes[puKeys[0..uRemaining)], in the bit arrays
+   puSeen and puTwice, each large enough for the first level.  Each
+   level holds a bit for each path that no other path still to be
+   placed hashes to, and the rest go on to the next level.  Return 1
+   (TRUE) if every path is placed, or 0 (FALSE) if insufficient memory
+   is available or if MAX_LEVELS do not suffice. */
+
+static int Frozen_buildLevels(Frozen_T oFrozen, const size_t *puHashes,
+                              size_t *puKeys, size_t uRemaining,
+                              size_t *puSeen, size_t *puTwice)
+{
+   size_t *puBits = NULL;
+   size_t *puGrown;
+   size_t uWords = 0;
+   size_t uLevelWords;
+   size_t uBit;
+   size_t uKept;
+   size_t u;
+
+   assert(oFrozen != NULL);
+   assert(puHashes != NULL);
+   assert(puKeys != NULL);
+   assert(puSeen != NULL);
+   assert(puTwice != NULL);
+
+   for (oFrozen->uLevels = 0;
+        uRemaining > 0 && oFrozen->uLevels < MAX_LEVELS;
+        oFrozen->uLevels++)
+   {
+      uLevelWords = (GAMMA * uRemaining + WORD_BITS - 1) / WORD_BITS;
+      oFrozen->auLevelStart[oFrozen->uLevels] = uWords;
+      oFrozen->auLevelWords[oFrozen->uLevels] = uLevelWords;
+      memset(puSeen, 0, uLevelWords * sizeof(size_t));
+      memset(puTwice, 0, uLevelWords * sizeof(size_t));
+
+      for (u = 0; u < uRemaining; u++)
+      {
+         uBit = Frozen_levelBit(oFrozen, puHashes[puKeys[u]],
+                                oFrozen->uLevels);
+         if (Frozen_testBit(puSeen, uBit))
+            Frozen_setBit(puTwice, uBit);
+         else
+            Frozen_setBit(puSeen, uBit);
+      }
+
+      puGrown = (size_t*)realloc(puBits, (uWords + uLevelWords) *
+                                 sizeof(size_t));
+      if (puGrown == NULL)
+      {
+         free(puBits);
+         return 0;
+      }
+      puBits = puGrown;
+      for (u = 0; u < uLevelWords; u++)
+         puBits[uWords + u] = puSeen[u] & ~puTwice[u];
+      uWords += uLevelWords;
+
+      /* The paths that collided go on to the next level. */
+      uKept = 0;
+      for (u = 0; u < uRemaining; u++)
+         if (Frozen_testBit(puTwice,
+                            Frozen_levelBit(oFrozen,
+                                            puHashes[puKeys[u]],
+                                            oFrozen->uLevels)))
+            puKeys[uKept++] = puKeys[u];
+      uRemaining = uKept;
+   }
+   if (uRemaining == 0)
+      oFrozen->oBits = BitVec_new(puBits, uWords * WORD_BITS);
+   if (oFrozen->oBits == NULL)
+   {
+      free(puBits);
+      return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build the index of the finished oFrozen, or, if insufficient memory
+   is available, leave it without one. */
+
+static void Frozen_index(Frozen_T oFrozen)
+{
+   size_t *puHashes;
+   size_t *puKeys;
+   size_t *puSeen;
+   size_t *puTwice;
+   size_t uWords;
+   size_t uSlot;
+   size_t u;
+   const char *pcName;
+   int iBuilt;
+
+   assert(oFrozen != NULL);
+
+   if (oFrozen->uLength == 0 || oFrozen->uLength > UINT_MAX)
+      return;
+
+   uWords = (GAMMA * oFrozen->uLength + WORD_BITS - 1) / WORD_BITS;
+   puHashes = (size_t*)malloc(oFrozen->uLength * sizeof(size_t));
+   puKeys = (size_t*)malloc(oFrozen->uLength * sizeof(size_t));
+   puSeen = (size_t*)malloc(uWords * sizeof(size_t));
+   puTwice = (size_t*)malloc(uWords * sizeof(size_t));
+   oFrozen->puSlotEntries = (unsigned int*)malloc(
+      oFrozen->uLength * sizeof(unsigned int));
+   oFrozen->pucFingerprints = (unsigned char*)malloc(oFrozen->uLength);
+   iBuilt = puHashes != NULL && puKeys != NULL && puSeen != NULL &&
+      puTwice != NULL && oFrozen->puSlotEntries != NULL &&
+      oFrozen->pucFingerprints != NULL;
+
+   /* Each path is its parent's path, a slash, and its name, so its
+      hash continues its parent's. */
+   for (u = 0; iBuilt && u < oFrozen->uLength; u++)
+   {
+      pcName = oFrozen->pcNames + oFrozen->psEntries[u].uName;
+      if (u == 0)
+         puHashes[u] = Hash_bytes("", 0);
+      else
+         puHashes[u] = Hash_continue(
+            puHashes[oFrozen->psDetails[u].uParent], "/", 1);
+      puHashes[u] = Hash_continue(puHashes[u], pcName,
+                                  strlen(pcName));
+      puKeys[u] = u;
+   }
+
+   if (iBuilt)
+      iBuilt = Frozen_buildLevels(oFrozen, puHashes, puKeys,
+                                  oFrozen->uLength, puSeen, puTwice);
+
+   for (u = 0; iBuilt && u < oFrozen->uLength; u++)
+   {
+      (void)Frozen_slotOf(oFrozen, puHashes[u], &uSlot);
+      assert(uSlot < oFrozen->uLength);
+      oFrozen->puSlotEntries[uSlot] = (unsigned int)u;
+      oFrozen->pucFingerprints[uSlot] =
+         Frozen_fingerprint(puHashes[u]);
+   }
+
+   if (! iBuilt)
+      Frozen_dropIndex(oFrozen);
+   free(puHashes);
+   free(puKeys);
+   free(puSeen);
+   free(puTwice);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_finish(Frozen_T oFrozen)
+{
+   struct Named *psNamed;
+   size_t *puNext;
+   size_t uFirst;
+   size_t u;
+   void *pvShrunk;
+
+   assert(oFrozen != NULL);
+   assert(oFrozen->psChildren == NULL);
+
+   oFrozen->psChildren = (struct Child*)malloc(
+      (oFrozen->uLength + 1) * sizeof(struct Child));
+   psNamed = (struct Named*)malloc(
+      (oFrozen->uLength + 1) * sizeof(struct Named));
+   puNext = (size_t*)malloc((oFrozen->uLength + 1) * sizeof(size_t));
+   if (oFrozen->psChildren == NULL || psNamed == NULL ||
+       puNext == NULL)
+   {
+      free(oFrozen->psChildren);
+      oFrozen->psChildren = NULL;
+      free(psNamed);
+      free(puNext);
+      return 0;
+   }
+
+   /* Each directory's children follow those of the directories added
+      before it. */
+   uFirst = 1;
+   for (u = 0; u < oFrozen->uLength; u++)
+   {
+      oFrozen->psEntries[u].uFirst = uFirst;
+      puNext[u] = uFirst;
+      uFirst += oFrozen->psEntries[u].uCount;
+   }
+
+   /* Gather the children of each directory, sort them by name, and
+      lay them out for searching. */
+   for (u = 1; u < oFrozen->uLength; u++)
+   {
+      uFirst = puNext[oFrozen->psDetails[u].uParent]++;
+      psNamed[uFirst].pcName =
+         oFrozen->pcNames + oFrozen->psEntries[u].uName;
+      psNamed[uFirst].uEntry = u;
+   }
+   for (u = 0; u < oFrozen->uLength; u++)
+   {
+      uFirst = oFrozen->psEntries[u].uFirst;
+      if (oFrozen->psEntries[u].uCount == 0)
+         continue;
+      qsort(psNamed + uFirst, oFrozen->psEntries[u].uCount,
+            sizeof(struct Named), Frozen_compareNamed);
+      (void)Frozen_layOut(psNamed + uFirst,
+                          oFrozen->psChildren + uFirst - 1,
+                          oFrozen->psEntries[u].uCount, 0, 1);
+   }
+   free(psNamed);
+   free(puNext);
+
+   /* Give back the room that was made for entries never added. */
+   if (oFrozen->uLength > 0)
+   {
+      pvShrunk = realloc(oFrozen->psEntries,
+                         oFrozen->uLength * sizeof(struct Entry));
+      if (pvShrunk != NULL)
+         oFrozen->psEntries = (struct Entry*)pvShrunk;
+      pvShrunk = realloc(oFrozen->psDetails,
+                         oFrozen->uLength * sizeof(struct Detail));
+      if (pvShrunk != NULL)
+         oFrozen->psDetails = (struct Detail*)pvShrunk;
+      pvShrunk = realloc(oFrozen->pcNames, oFrozen->uNamesLength);
+      if (pvShrunk != NULL)
+         oFrozen->pcNames = (char*)pvShrunk;
+   }
+
+   Frozen_index(oFrozen);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the children of the directory uDirectory of oFrozen for the
+   one named by pcKey, which ends at its first slash, if it has one.
+   Return 1 (TRUE) if there is one, storing its entry in *puEntry, and
+   0 (FALSE) otherwise. */
+
+static int Frozen_findChild(Frozen_T oFrozen, size_t uDirectory,
+                            const char *pcKey, size_t *puEntry)
+{
+   const struct Child *psBase;
+   const char *pcName;
+   size_t uPrefix;
+   size_t uCount;
+   size_t uPosition;
+   int iRight;
+
+   assert(oFrozen != NULL);
+   assert(pcKey != NULL);
+   assert(puEntry != NULL);
+
+   /* psBase[1..uCount] are the children, so that the children of
+      position p of the implicit binary tree are at 2p and 2p + 1. */
+   psBase = oFrozen->psChildren + oFrozen->psEntries[uDirectory].uFirst
+      - 1;
+   uCount = oFrozen->psEntries[uDirectory].uCount;
+   uPrefix = Frozen_prefix(pcKey);
+
+   /* Descend to a leaf, going right past every child whose name comes
+      before the key.  The step is computed, not branched on; only
+      children whose prefix equals the key's are compared as
+      strings. */
+   uPosition = 1;
+   while (uPosition <= uCount)
+   {
+      iRight = psBase[uPosition].uPrefix < uPrefix;
+      if (psBase[uPosition].uPrefix == uPrefix)
+         iRight = Frozen_compareKey(pcKey, oFrozen->pcNames +
+            oFrozen->psEntries[psBase[uPosition].uEntry].uName) > 0;
+      uPosition = 2 * uPosition + (size_t)iRight;
+   }
+
+   /* Undo the right turns since the last left turn, which leads back
+      to the first child whose name does not come before the key. */
+   uPosition >>= __builtin_ffsl((long)~uPosition);
+   if (uPosition == 0 || psBase[uPosition].uPrefix != uPrefix)
+      return 0;
+
+   pcName = oFrozen->pcNames +
+      oFrozen->psEntries[psBase[uPosition].uEntry].uName;
+   if (Frozen_compareKey(pcKey, pcName) != 0)
+      return 0;
+
+   *puEntry = psBase[uPosition].uEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if pcPath, of length uLength, is the full path of
+   the entry uEntry of oFrozen, and 0 (FALSE) otherwise, comparing the
+   names of the entry and of its ancestors with pcPath from its end
+   back. */
+
+static int Frozen_isPathOf(Frozen_T oFrozen, size_t uEntry,
+                           const char *pcPath, size_t uLength)
+{
+   const struct Detail *psDetail;
+   size_t uStart;
+
+   assert(oFrozen != NULL);
+   assert(pcPath != NULL);
+
+   if (oFrozen->psDetails[uEntry].uPathLength != uLength)
+      return 0;
+
+   for (;;)
+   {
+      psDetail = &oFrozen->psDetails[uEntry];
+      uStart = 0;
+      if (uEntry != 0)
+         uStart = oFrozen->psDetails[psDetail->uParent].uPathLength
+            + 1;
+      if (memcmp(pcPath + uStart,
+                 oFrozen->pcNames + oFrozen->psEntries[uEntry].uName,
+                 psDetail->uPathLength - uStart) != 0)
+         return 0;
+      if (uEntry == 0)
+         return 1;
+      if (pcPath[uStart - 1] != '/')
+         return 0;
+      uEntry = psDetail->uParent;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up pcPath in the index of oFrozen, as Frozen_find does. */
+
+static int Frozen_findHashed(Frozen_T oFrozen, const char *pcPath,
+                             size_t *puEntry)
+{
+   size_t uLength;
+   size_t uSlot;
+   size_t uEntry;
+   size_t uHash;
+
+   assert(oFrozen != NULL);
+   assert(pcPath != NULL);
+   assert(puEntry != NULL);
+
+   uLength = strlen(pcPath);
+   uHash = Hash_bytes(pcPath, uLength);
+
+   /* A path that is not an entry may still be given a slot, so it is
+      checked against the slot's fingerprint, and then, since two
+      paths may share a fingerprint, against the entry itself. */
+   if (! Frozen_slotOf(oFrozen, uHash, &uSlot) ||
+       oFrozen->pucFingerprints[uSlot] != Frozen_fingerprint(uHash))
+      return 0;
+   uEntry = oFrozen->puSlotEntries[uSlot];
+   if (! Frozen_isPathOf(oFrozen, uEntry, pcPath, uLength))
+      return 0;
+
+   *puEntry = uEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_find(Frozen_T oFrozen, const char *pcPath,
+                size_t *puEntry)
+{
+   const char *pcName;
+   size_t uEntry = 0;
+
+   assert(oFrozen != NULL);
+   assert(oFrozen->psChildren != NULL);
+   assert(pcPath != NULL);
+   assert(puEntry != NULL);
+
+   if (oFrozen->uLength == 0)
+      return 0;
+   if (oFrozen->pucFingerprints != NULL)
+      return Frozen_findHashed(oFrozen, pcPath, puEntry);
+
+   /* Without an index, search from the root down, directory by
+      directory.  The first component names the root. */
+   pcName = oFrozen->pcNames + oFrozen->psEntries[0].uName;
+   if (Frozen_compareKey(pcPath, pcName) != 0)
+      return 0;
+   pcPath += strlen(pcName);
+
+   while (*pcPath == '/')
+   {
+      pcPath++;
+      if (! Frozen_findChild(oFrozen, uEntry, pcPath, &uEntry))
+         return 0;
+      pcPath += strlen(oFrozen->pcNames +
+                       oFrozen->psEntries[uEntry].uName);
+   }
+
+   *puEntry = uEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_isFile(Frozen_T oFrozen, size_t uEntry)
+{
+   assert(oFrozen != NULL);
+   assert(uEntry < oFrozen->uLength);
+
+   return oFrozen->psDetails[uEntry].iIsFile;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Frozen_getContents(Frozen_T oFrozen, size_t uEntry)
+{
+   assert(oFrozen != NULL);
+   assert(uEntry < oFrozen->uLength);
+
+   return oFrozen->psDetails[uEntry].pvContents;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Frozen_getLength(Frozen_T oFrozen, size_t uEntry)
+{
+   assert(oFrozen != NULL);
+   assert(uEntry < oFrozen->uLength);
+
+   return oFrozen->psDetails[uEntry].uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Frozen_getMaxPathLength(Frozen_T oFrozen)
+{
+   assert(oFrozen != NULL);
+
+   return oFrozen->uMaxPathLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Frozen_map(Frozen_T oFrozen, char *pcBuffer,
+               int (*pfApply)(const char *pcPath, size_t uLength,
+                              void *pvExtra),
+               void *pvExtra)
+{
+   const struct Detail *psDetail;
+   size_t uStart;
+   size_t u;
+   int iResult;
+
+   assert(oFrozen != NULL);
+   assert(pcBuffer != NULL);
+   assert(pfApply != NULL);
+
+   /* In pre-order, everything added between a directory and its
+      child lies beneath the directory, so the buffer still begins
+      with the directory's path when the child's name is put after
+      it. */
+   for (u = 0; u < oFrozen->uLength; u++)
+   {
+      psDetail = &oFrozen->psDetails[u];
+      uStart = 0;
+      if (u > 0)
+      {
+         uStart = oFrozen->psDetails[psDetail->uParent].uPathLength;
+         pcBuffer[uStart++] = '/';
+      }
+      memcpy(pcBuffer + uStart,
+             oFrozen->pcNames + oFrozen->psEntries[u].uName,
+             psDetail->uPathLength - uStart + 1);
+
+      iResult = (*pfApply)(pcBuffer, psDetail->uPathLength, pvExtra);
+      if (iResult != 0)
+         return iResult;
+   }
+   return 0;
+}
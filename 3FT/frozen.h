@@ -0,0 +1,125 @@
+/*--------------------------------------------------------------------*/
+/* frozen.h                                                           */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FROZEN_INCLUDED
+#define FROZEN_INCLUDED
+
+#include <stddef.h>
+
+/* A Frozen_T object is an immutable copy of a hierarchy of named
+   directories and files, packed for reading into a few arrays, with
+   no allocation per entry.  Each directory's children are kept in
+   Eytzinger order, the order of a breadth-first walk of a balanced
+   binary search tree of their names, so that the first steps of every
+   search of them read the same few cache lines, and each step chooses
+   its next child by arithmetic rather than by a branch.  Each child
+   also carries the first bytes of its name, packed into a number, so
+   that most steps compare numbers rather than strings.
+
+   A finished Frozen_T also has an index of the full paths of its
+   entries: a minimal perfect hash, which gives each path a slot of
+   its own in a few bits per path, and a one-byte fingerprint of each
+   slot's path, which rejects most other paths without reading any
+   entry.  A path is then found by hashing it once, whatever its
+   depth.
+
+   A Frozen_T is built by adding its entries, in the order in which
+   its listing is to visit them, and is then finished, after which it
+   is only read.  A finished Frozen_T may be read by any number of
+   threads at once.  Entries are identified by their position in the
+   order added, from 0 for the root. */
+
+typedef struct Frozen *Frozen_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Frozen_T object, to which entries are to be
+   added, or NULL if insufficient memory is available. */
+
+Frozen_T Frozen_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oFrozen, but not the contents of its files.  oFrozen may be
+   NULL, in which case nothing is freed. */
+
+void Frozen_free(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Add to the unfinished oFrozen an entry named pcName beneath the
+   directory uParent, or, for the first entry, as the root, in which
+   case uParent is ignored.  The entry is a file whose contents are
+   pvContents, of uLength bytes, if iIsFile is 1 (TRUE), and otherwise
+   a directory.  Entries must be added in pre-order: each directory
+   directly followed by everything beneath it.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+int Frozen_add(Frozen_T oFrozen, size_t uParent, const char *pcName,
+               int iIsFile, void *pvContents, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Finish oFrozen, laying out the children of each directory for
+   searching and building its index, after which no entry may be
+   added.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available.  If there is memory enough for
+   all but the index, oFrozen goes without one. */
+
+int Frozen_finish(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Search the finished oFrozen for the entry whose full path, the
+   names from the root down joined by slashes, is pcPath.  Return 1
+   (TRUE) if there is one, storing its identifier in *puEntry, and 0
+   (FALSE) otherwise.  Uses the index, in constant expected time, if
+   oFrozen has one, and otherwise searches each directory on the
+   path in turn. */
+
+int Frozen_find(Frozen_T oFrozen, const char *pcPath,
+                size_t *puEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the entry uEntry of oFrozen is a file, and 0
+   (FALSE) if it is a directory. */
+
+int Frozen_isFile(Frozen_T oFrozen, size_t uEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the contents of the file uEntry of oFrozen. */
+
+void *Frozen_getContents(Frozen_T oFrozen, size_t uEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the contents of the file uEntry of oFrozen. */
+
+size_t Frozen_getLength(Frozen_T oFrozen, size_t uEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the longest full path of an entry of
+   oFrozen, or 0 if it has none. */
+
+size_t Frozen_getMaxPathLength(Frozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(pcPath, uLength, pvExtra) for the full path pcPath,
+   of length uLength, of each entry of the finished oFrozen, in the
+   order in which the entries were added, building each path in
+   pcBuffer, which must hold Frozen_getMaxPathLength(oFrozen) + 1
+   characters.  Stop at the first call that returns a nonzero value,
+   and return that value.  Return 0 if every call returns 0. */
+
+int Frozen_map(Frozen_T oFrozen, char *pcBuffer,
+               int (*pfApply)(const char *pcPath, size_t uLength,
+                              void *pvExtra),
+               void *pvExtra);
+
+#endif
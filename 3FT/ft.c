@@ -3,46 +3,446 @@
 /* Authors: Misrach Ewunetie, Shruti Roy                              */
 /*--------------------------------------------------------------------*/
 
+/* for pthread_rwlock_t, which -ansi would otherwise hide, and for
+   pinning threads to processors where the system allows it */
+#define _GNU_SOURCE
+
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 
-#include "dynarray.h"
 #include "ft.h"
 #include "node.h"
 #include "file.h"
+#include "symtable.h"
+#include "dynarray.h"
+#include "pool.h"
+#include "slab.h"
+#include "names.h"
+#include "hash.h"
+#include "frozen.h"
+#include "snapshot.h"
+
+/* A File Tree is an ADT: each FT_T points to one of these. */
+struct FT {
+   /* a pointer to the root node in the hierarchy */
+   Node_T root;
+   /* a counter of the number of nodes in the hierarchy, which is
+      updated atomically; with a pool or pending hierarchies, it also
+      counts the nodes of removed hierarchies not yet freed */
+   size_t count;
+
+   /* The lock guarding root, or NULL unless the tree was created with
+      FT_CONCURRENT, in which case every directory has a lock too. */
+   pthread_rwlock_t* rootLock;
+
+   /* The epoch inside which lookups read the hierarchy without locks,
+      and to which writers retire what they unlink from it, or NULL
+      unless the tree was created with FT_CONCURRENT. */
+   Epoch_T epoch;
+
+   /* Optionally, two hash indexes from the full path of every
+      directory and every file to its Node_T or File_T. Both are NULL
+      unless the tree was created with FT_PATH_INDEX. */
+   SymTable_T dirIndex;
+   SymTable_T fileIndex;
+
+   /* The arena from which the hierarchy is allocated, or NULL if it is
+      allocated from the heap. Non-NULL only if the tree was created
+      with FT_ARENA. */
+   Arena_T arena;
+
+   /* The slab from which the directories and files of the hierarchy
+      are allocated, which lets them refer to one another by 32-bit
+      indices, with the table of their names attached. */
+   Slab_T slab;
+
+   /* The workers among which removed hierarchies are freed, in the
+      background, or NULL unless the tree was created with
+      FT_PARALLEL_FREE. */
+   Pool_T pool;
+
+   /* The stack of removed directories whose hierarchies are freed a
+      few nodes at a time, by later operations on the tree, and the
+      most nodes that each operation frees. pending is NULL unless the
+      tree was created with FT_INCREMENTAL_FREE alone. */
+   DynArray_T pending;
+   size_t budget;
+
+   /* The number of files, or of subdirectories, beyond which each
+      directory of the tree keeps a hash table of them, or 0 if none
+      does. */
+   size_t threshold;
+
+   /* TRUE if each directory of the tree beyond the threshold moves its
+      files, or subdirectories, to a B+tree rather than keep a hash
+      table of them. */
+   boolean ordered;
+
+   /* The packed copy of the hierarchy from which reads are served
+      while the tree is frozen, or NULL if it is not. It is replaced
+      atomically, and retired to the epoch when the tree thaws. */
+   Frozen_T frozen;
+};
+
+/* The most nodes that an operation on a tree with pending removals
+   frees, unless the client sets another budget. */
+enum { FT_FREE_BUDGET = 64 };
+
+/* The fan-out threshold with which trees are created, which
+   FT_setFanOutThreshold sets, read and written atomically, since
+   trees may be created by different threads. */
+static size_t fanOutThreshold = 512;
+
+/* Whether trees are created ordered, which FT_setFanOutOrdered sets,
+   read and written atomically for the same reason. */
+static boolean fanOutOrdered = FALSE;
+
+/* The tree behind the FT_* functions without a handle, or NULL if it
+   is not in an initialized state. */
+static FT_T defaultTree;
+
+/*
+   Discards ft's path indexes, reverting all lookups to traversal.
+   Used when the indexes can no longer be kept in step with the tree.
+*/
+static void FT_dropIndex(FT_T ft) {
+   if(ft->dirIndex != NULL)
+      SymTable_free(ft->dirIndex);
+   if(ft->fileIndex != NULL)
+      SymTable_free(ft->fileIndex);
+   ft->dirIndex = NULL;
+   ft->fileIndex = NULL;
+}
+
+/*
+   Ensures that *pBuffer, which holds *pSize characters, can hold at
+   least size characters, growing it if necessary.
+   Returns TRUE if it can, or FALSE if there is an allocation error.
+*/
+static boolean FT_reserve(char** pBuffer, size_t* pSize, size_t size) {
+   char* grown;
+   size_t newSize;
+
+   assert(pBuffer != NULL);
+   assert(pSize != NULL);
+
+   if(size <= *pSize)
+      return TRUE;
+
+   newSize = 2 * *pSize;
+   if(newSize < size)
+      newSize = size;
+
+   grown = realloc(*pBuffer, newSize);
+   if(grown == NULL)
+      return FALSE;
+
+   *pBuffer = grown;
+   *pSize = newSize;
+   return TRUE;
+}
+
+/*
+   Adds the directories from n up to, but not including, ancestor to
+   the path index, if there is one. The full path of n is the first
+   length characters of path.
+*/
+static void FT_indexDirs(FT_T ft, Node_T n, Node_T ancestor,
+                         const char* path, size_t length) {
+   char* prefix;
+
+   assert(n != NULL);
+   assert(path != NULL);
+
+   if(ft->dirIndex == NULL)
+      return;
+
+   /* each directory's path is its child's path up to the last slash */
+   prefix = malloc(length + 1);
+   if(prefix == NULL) {
+      FT_dropIndex(ft);
+      return;
+   }
+   memcpy(prefix, path, length);
+   prefix[length] = '\0';
+
+   for(; n != ancestor; n = Node_getParent(n)) {
+      if(!SymTable_put(ft->dirIndex, prefix, n)) {
+         FT_dropIndex(ft);
+         break;
+      }
+      if(Node_getParent(n) != ancestor)
+         *strrchr(prefix, '/') = '\0';
+   }
+
+   free(prefix);
+}
+
+/*
+   Adds file f, whose full path is path, to the path index, if there
+   is one.
+*/
+static void FT_indexFile(FT_T ft, File_T f, const char* path) {
+   assert(f != NULL);
+   assert(path != NULL);
+
+   if(ft->fileIndex != NULL && !SymTable_put(ft->fileIndex, path, f))
+      FT_dropIndex(ft);
+}
+
+/*
+   Removes every directory and file in the hierarchy rooted at n from
+   the path index. (*pBuffer)[0..length) is the full path of n, and
+   *pBuffer, which holds *pSize characters, is grown as needed to
+   build the full paths of n's descendants after it.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_unindexFrom(FT_T ft, Node_T n, char** pBuffer,
+                              size_t* pSize, size_t length) {
+   Node_T child;
+   const char* name;
+   size_t nameLength;
+   size_t c;
+
+   assert(n != NULL);
+   assert(pBuffer != NULL);
+   assert(pSize != NULL);
+
+   (*pBuffer)[length] = '\0';
+   (void) SymTable_remove(ft->dirIndex, *pBuffer);
+
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_getDirChild(n, c);
+      if(child != NULL)
+         name = Node_getName(child);
+      else
+         name = File_getName(Node_getFileChild(n, c));
+      nameLength = strlen(name);
+      if(!FT_reserve(pBuffer, pSize, length + nameLength + 2))
+         return FALSE;
+      (*pBuffer)[length] = '/';
+      memcpy(*pBuffer + length + 1, name, nameLength + 1);
+      if(child == NULL)
+         (void) SymTable_remove(ft->fileIndex, *pBuffer);
+      else if(!FT_unindexFrom(ft, child, pBuffer, pSize,
+                              length + 1 + nameLength))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/*
+   Removes every directory and file in the hierarchy rooted at n, whose
+   full path is path, from the path index, if there is one, in a single
+   pass over the hierarchy rather than one lookup per entry.
+*/
+static void FT_unindexHierarchy(FT_T ft, Node_T n, const char* path) {
+   char* buffer;
+   size_t size;
+
+   assert(n != NULL);
+   assert(path != NULL);
+
+   if(ft->dirIndex == NULL)
+      return;
+
+   size = strlen(path) + 1;
+   buffer = malloc(size);
+   if(buffer == NULL) {
+      FT_dropIndex(ft);
+      return;
+   }
+   strcpy(buffer, path);
+
+   if(!FT_unindexFrom(ft, n, &buffer, &size, size - 1))
+      FT_dropIndex(ft);
+   free(buffer);
+}
+
+/*
+   Points the path index at n and every directory and file in the
+   hierarchy rooted at n, which replace those of the same paths.
+   (*pBuffer)[0..length) is the full path of n, and *pBuffer, which
+   holds *pSize characters, is grown as needed to build the full paths
+   of n's descendants after it.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_reindexFrom(FT_T ft, Node_T n, char** pBuffer,
+                              size_t* pSize, size_t length) {
+   Node_T child;
+   File_T file;
+   const char* name;
+   size_t nameLength;
+   size_t c;
+
+   assert(n != NULL);
+   assert(pBuffer != NULL);
+   assert(pSize != NULL);
+
+   (*pBuffer)[length] = '\0';
+   (void) SymTable_replace(ft->dirIndex, *pBuffer, n);
+
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_getDirChild(n, c);
+      file = Node_getFileChild(n, c);
+      if(child != NULL)
+         name = Node_getName(child);
+      else
+         name = File_getName(file);
+      nameLength = strlen(name);
+      if(!FT_reserve(pBuffer, pSize, length + nameLength + 2))
+         return FALSE;
+      (*pBuffer)[length] = '/';
+      memcpy(*pBuffer + length + 1, name, nameLength + 1);
+      if(child == NULL)
+         (void) SymTable_replace(ft->fileIndex, *pBuffer, file);
+      else if(!FT_reindexFrom(ft, child, pBuffer, pSize,
+                              length + 1 + nameLength))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/*
+   Locks n, or ft's root pointer if n is NULL, for reading if exclusive
+   is FALSE and for changing otherwise. Does nothing unless ft was
+   created with FT_CONCURRENT.
+
+   Locks are always taken from the root downward, and a directory is
+   locked before its parent is released, so that a directory cannot
+   be removed while a thread is on its way into it.
+*/
+static void FT_lock(FT_T ft, Node_T n, boolean exclusive) {
+   int result = 0;
+
+   assert(ft != NULL);
+
+   if(n != NULL) {
+      if(exclusive)
+         Node_lockExclusive(n);
+      else
+         Node_lockShared(n);
+   }
+   else if(ft->rootLock != NULL) {
+      if(exclusive)
+         result = pthread_rwlock_wrlock(ft->rootLock);
+      else
+         result = pthread_rwlock_rdlock(ft->rootLock);
+   }
+   assert(result == 0);
+   (void) result;
+}
+
+/*
+   Releases the lock taken on n, or on ft's root pointer if n is NULL,
+   by FT_lock.
+*/
+static void FT_unlock(FT_T ft, Node_T n) {
+   int result = 0;
+
+   assert(ft != NULL);
+
+   if(n != NULL)
+      Node_unlock(n);
+   else if(ft->rootLock != NULL)
+      result = pthread_rwlock_unlock(ft->rootLock);
+   assert(result == 0);
+   (void) result;
+}
+
+/*
+   Adds delta to ft's count. The count is shared by every thread using
+   ft, so it is updated atomically.
+*/
+static void FT_addCount(FT_T ft, size_t delta) {
+   assert(ft != NULL);
+
+   (void) __atomic_add_fetch(&ft->count, delta, __ATOMIC_RELAXED);
+}
+
+/*
+   Subtracts delta from ft's count, atomically.
+*/
+static void FT_subtractCount(FT_T ft, size_t delta) {
+   assert(ft != NULL);
 
-/* A Directory Tree is an AO with 3 state variables: */
-/* a flag for if it is in an initialized state (TRUE) or not (FALSE) */
-static boolean isInitialized;
-/* a pointer to the root node in the hierarchy */
-static Node_T root;
-/* a counter of the number of nodes in the hierarchy */
-static size_t count;
+   (void) __atomic_sub_fetch(&ft->count, delta, __ATOMIC_RELAXED);
+}
 
 /*
-   Starting at the parameter curr, traverses as far down
-   the hierarchy as possible while still matching the path
-   parameter.
+   Returns TRUE if root is not NULL and its name is the first
+   component of the first limit characters of path.
+*/
+static boolean FT_isRootOf(Node_T root, const char* path,
+                           size_t limit) {
+   const char* rootName;
+   size_t rootLength;
+
+   assert(path != NULL);
+
+   if(root == NULL)
+      return FALSE;
 
-   Returns a pointer to the farthest matching node down that path,
-   or NULL if there is no node in curr's hierarchy that matches
-   a prefix of the path.
+   rootName = Node_getName(root);
+   rootLength = strlen(rootName);
+   return (boolean) (rootLength <= limit &&
+                     !strncmp(path, rootName, rootLength) &&
+                     (rootLength == limit || path[rootLength] == '/'));
+}
 
-   If the full path is found, sets foundFullPath to true.
-   Else, foundFullPath will be false.
+/*
+   Traverses ft's hierarchy from the root as far as possible while
+   still matching the first limit characters of the path parameter,
+   one path component at a time. path[limit] must be a slash or the
+   end of path.
+   Each level of the descent is a single binary search of the current
+   directory's children for the next component, made directly against
+   path, so a lookup costs O(depth * log(fanout)) regardless of the
+   size of the rest of the tree, and allocates no memory.
+
+   Returns the farthest directory down that path, or NULL if the root
+   does not match the first component of the path.
+   This is the descent of the functions that change the tree: the
+   directory returned, or ft's root pointer if NULL is returned, is
+   left locked exclusively by FT_lock, and must be released with
+   FT_unlock. The descent locks each directory shared in turn before
+   releasing its parent, and only the directory returned is locked
+   exclusively, so descents into different parts of the tree do not
+   wait for each other. In a concurrent tree, the caller must be inside
+   ft's epoch until it has released the directory, since a directory
+   above it may be removed meanwhile, without waiting for it.
+
+   If the full path is found, sets foundFullPath to TRUE.
+   Else, foundFullPath will be FALSE.
 
    If a file is found with a prefix of the path or the path itself,
-   isFile is set to true. Otherwise, it will be false.
+   isFile is set to TRUE and the directory containing it is returned.
+   Otherwise, it will be FALSE.
+
+   If prefix is not NULL, stores in *prefix the length of the prefix
+   of path that names the directory returned, so that the caller need
+   not walk up from it through ancestors it holds no lock on.
 */
-static Node_T FT_traversePath(char* path, Node_T curr,
-                              boolean *isFile, boolean *foundFullPath) {
-   Node_T found;
-   File_T fileFound;
-   size_t i;
+static Node_T FT_traversePath(FT_T ft, const char* path, size_t limit,
+                              boolean *isFile, boolean *foundFullPath,
+                              size_t *prefix) {
+   Node_T parent = NULL;
+   Node_T curr;
+   Node_T child;
+   File_T file = NULL;
+   const char* name;
+   const char* end;
+   boolean currExclusive;
 
+   assert(ft != NULL);
    assert(path != NULL);
    assert(isFile != NULL);
    assert(foundFullPath != NULL);
@@ -50,604 +450,3056 @@ static Node_T FT_traversePath(char* path, Node_T curr,
    *foundFullPath = FALSE;
    *isFile = FALSE;
 
-   /* if the current node is NULL, cannot traverse further */
+   /* without locks, there is nothing to hold exclusively */
+   currExclusive = (boolean) (ft->rootLock == NULL);
+
+   /* the first component must name the root */
+   FT_lock(ft, NULL, FALSE);
+   for(;;) {
+      curr = ft->root;
+      if(!FT_isRootOf(curr, path, limit))
+         curr = NULL;
+      if(curr != NULL || currExclusive)
+         break;
+
+      /* look again with the root pointer locked exclusively, so that
+         the caller can set it */
+      FT_unlock(ft, NULL);
+      FT_lock(ft, NULL, TRUE);
+      currExclusive = TRUE;
+   }
    if(curr == NULL)
       return NULL;
 
-   /* if the current path matches the target, we have traversed the
-      full path */
-   if(!strcmp(path,Node_getPath(curr))) {
+   FT_lock(ft, curr, FALSE);
+   currExclusive = (boolean) (ft->rootLock == NULL);
+   end = path + strlen(Node_getName(curr));
+   for(;;) {
+      if(end < path + limit) {
+         /* the next component runs from after the slash to the next
+            one */
+         name = end + 1;
+         child = Node_findChild(curr, name, &file);
+         if(child != NULL) {
+            FT_lock(ft, child, FALSE);
+            FT_unlock(ft, parent);
+            parent = curr;
+            curr = child;
+            currExclusive = (boolean) (ft->rootLock == NULL);
+            end = name + strcspn(name, "/");
+            continue;
+         }
+      }
+
+      if(currExclusive)
+         break;
+
+      /* relock curr exclusively, which its locked parent keeps in the
+         tree meanwhile, and look again in case it changed */
+      FT_unlock(ft, curr);
+      FT_lock(ft, curr, TRUE);
+      currExclusive = TRUE;
+   }
+   FT_unlock(ft, parent);
+
+   if(prefix != NULL)
+      *prefix = (size_t) (end - path);
+   if(end == path + limit)
       *foundFullPath = TRUE;
-      return curr;
-   }
-
-   /* if the current path is a prefix of the target, continue traversing
-      through its children */
-   if(!strncmp(path, Node_getPath(curr), strlen(Node_getPath(curr)))) {
-      /* iterate through directory children and traverse. return if
-         the end of any matching path has been found. */
-      for(i = 0; i < Node_getNumChildren(curr, 0); i++) {
-         found = FT_traversePath(path, Node_getDirChild(curr, i),
-                                 isFile, foundFullPath);
-         if(found != NULL)
-            return found;
-      }
-
-      /* iterate through file children and check if paths match target
-         or a prefix of target. Indicate that a file has been found
-         and whether it matches the full path. Return the current
-         directory (the parent of the target file). */
-      for(i = 0; i < Node_getNumChildren(curr, 1); i++) {
-         fileFound = Node_getFileChild(curr, i);
-
-         if (fileFound != NULL) {
-             if(!strncmp(path, File_getPath(fileFound),
-                              strlen(File_getPath(fileFound)))) {
-                *isFile = TRUE;
-                if(!strcmp(path,File_getPath(fileFound)))
-                   *foundFullPath = TRUE;
-                
-                return curr;
-             }
+   else {
+      /* a file can only match the last component of the path, and
+         was found by the same search that found no directory */
+      name = end + 1;
+      if(file != NULL) {
+         *isFile = TRUE;
+         *foundFullPath =
+            (boolean) (name + strcspn(name, "/") == path + limit);
+      }
+   }
+   return curr;
+}
+
+/*
+   Looks up the first limit characters of path in ft's hierarchy, as
+   FT_traversePath does, for the functions that only read the tree:
+   no locks are taken, and each directory's children are searched in
+   the snapshot of them published last. In a concurrent tree, the
+   caller must be inside ft's epoch, which keeps everything reached
+   from being freed, until it is done with the result.
+*/
+static Node_T FT_lookupPath(FT_T ft, const char* path, size_t limit,
+                            boolean *isFile, boolean *foundFullPath) {
+   Node_T curr;
+   Node_T child;
+   File_T file;
+   const char* name;
+   const char* end;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+   assert(isFile != NULL);
+   assert(foundFullPath != NULL);
+
+   *foundFullPath = FALSE;
+   *isFile = FALSE;
+
+   curr = __atomic_load_n(&ft->root, __ATOMIC_ACQUIRE);
+   if(!FT_isRootOf(curr, path, limit))
+      return NULL;
+
+   end = path + strlen(Node_getName(curr));
+   while(end < path + limit) {
+      name = end + 1;
+      child = Node_findChild(curr, name, &file);
+      if(child == NULL) {
+         /* a file can only match the last component of the path */
+         if(file != NULL) {
+            *isFile = TRUE;
+            *foundFullPath =
+               (boolean) (name + strcspn(name, "/") == path + limit);
          }
+         return curr;
       }
-      return curr;
+      curr = child;
+      end = name + strcspn(name, "/");
    }
-   return NULL;
+
+   *foundFullPath = TRUE;
+   return curr;
 }
 
 /*
-   Inserts a new path into the tree rooted at parent, or, if
-   parent is NULL, as the root of the data structure.
+   Returns a new directory named by the component of path at dir,
+   beneath parent, as Node_create does, with a lock if ft is
+   concurrent, or NULL if there is an allocation error.
+*/
+static Node_T FT_createNode(FT_T ft, const char* dir, Node_T parent) {
+   Node_T new;
+
+   assert(ft != NULL);
+
+   new = Node_create(dir, parent, ft->slab);
+   if(new != NULL && ft->rootLock != NULL &&
+      !Node_addLock(new, ft->arena, ft->epoch)) {
+      (void) Node_destroy(new, ft->arena);
+      return NULL;
+   }
+   return new;
+}
 
-   If a node representing path already exists, returns ALREADY_IN_TREE
+/*
+   Inserts the directories named by the first limit characters of
+   path into ft's tree beneath parent, or, if parent is NULL, as the
+   root of the data structure. parent must be a directory whose path
+   is the first prefix characters of path, a proper prefix of them,
+   locked exclusively (or, if parent is NULL, ft's root pointer must
+   be), and path[limit] must be a slash or the end of path. If pLast
+   is not NULL, stores the last new directory in *pLast.
 
    If there is an allocation error in creating any of the new nodes or
    their fields, returns MEMORY_ERROR
 
-   If there is an error linking any of the new nodes,
-   returns PARENT_CHILD_ERROR
+   If there is an error linking any of the new nodes,
+   returns PARENT_CHILD_ERROR
+
+   Otherwise, returns SUCCESS
+*/
+static int FT_insertRestOfPath(FT_T ft, const char* path, size_t limit,
+                               Node_T parent, size_t prefix,
+                               Node_T* pLast) {
+
+   Node_T curr = parent;
+   Node_T firstNew = NULL;
+   Node_T new;
+   const char* dirToken = path;
+   int result;
+   size_t newCount = 0;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   /* if root is not NULL, curr must be a descendent of root */
+   if(curr == NULL) {
+      if(ft->root != NULL) {
+         return CONFLICTING_PATH;
+      }
+   }
+   /* skip past the parent's path and the slash after it */
+   else
+      dirToken += prefix + 1;
+
+   /* iterate through, create, and link subsequent directories from
+      current until the full path is reached, naming each one by the
+      component of path it starts at. If an error occurs, revert back
+      to the initial file tree. The new directories are not reachable
+      until the first is linked, so they need not be locked. */
+   for(;;) {
+      new = FT_createNode(ft, dirToken, curr);
+
+      if(new == NULL) {
+         if(firstNew != NULL)
+            (void) Node_destroy(firstNew, ft->arena);
+         return MEMORY_ERROR;
+      }
+
+      newCount++;
+
+      /* link new nodes to each other, but not to parent in case
+         of any error */
+      if(firstNew == NULL)
+         firstNew = new;
+      else {
+         if((result = Node_linkChild(curr, new, ft->arena,
+                                     ft->threshold, ft->ordered))
+            != SUCCESS) {
+            (void) Node_destroy(new, ft->arena);
+            (void) Node_destroy(firstNew, ft->arena);
+            return result;
+         }
+      }
+
+      curr = new;
+      dirToken += strcspn(dirToken, "/");
+      if(dirToken == path + limit)
+         break;
+      dirToken++;
+   }
+
+   if(parent == NULL)
+      __atomic_store_n(&ft->root, firstNew, __ATOMIC_RELEASE);
+   /* connect the extended path to the parent node */
+   else if((result = Node_linkChild(parent, firstNew, ft->arena,
+                                    ft->threshold, ft->ordered))
+           != SUCCESS) {
+      (void) Node_destroy(firstNew, ft->arena);
+      return result;
+   }
+
+   FT_addCount(ft, newCount);
+   FT_indexDirs(ft, curr, parent, path, limit);
+
+   if(pLast != NULL)
+      *pLast = curr;
+   return SUCCESS;
+}
+
+/*
+   Waits for every writer that is still inside the hierarchy rooted at
+   n, which is locked exclusively and already unlinked from ft's tree,
+   to leave it. Since each writer holds a directory's lock before
+   releasing its parent's, locking every directory exclusively from
+   the top down leaves no writer behind. Readers hold no locks, and
+   are waited for instead by retiring the hierarchy to ft's epoch.
+   Returns the number of directories and files in the hierarchy.
+*/
+static size_t FT_drain(FT_T ft, Node_T n) {
+   Node_T child;
+   size_t c;
+   size_t count;
+
+   assert(ft != NULL);
+   assert(n != NULL);
+
+   count = 1;
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_getDirChild(n, c);
+      if(child == NULL)
+         count++;
+      else {
+         Node_lockExclusive(child);
+         count += FT_drain(ft, child);
+         Node_unlock(child);
+      }
+   }
+   return count;
+}
+
+/*
+   Returns TRUE if the directory n has a subdirectory, and FALSE if its
+   children are all files. Costs at most a look at each child, which
+   is no more than destroying them does.
+*/
+static boolean FT_hasSubdirectory(Node_T n) {
+   size_t c;
+
+   assert(n != NULL);
+
+   for(c = 0; c < Node_getNumChildren(n); c++)
+      if(Node_getDirChild(n, c) != NULL)
+         return TRUE;
+   return FALSE;
+}
+
+/*
+   Destroys the directory n, which has been unlinked from the tree ft,
+   and its files, and adds those of its child directories that have
+   subdirectories of their own to ft's pool, to be destroyed in turn
+   by whichever workers are free. Run by the pool's workers. Leaf
+   directories are destroyed on the spot, as is one child with
+   subdirectories, so that neither wide leaves nor long chains cost a
+   trip through the pool for every directory.
+*/
+static void FT_destroyInPool(void* n, void* ft) {
+   Node_T child;
+   Node_T next;
+   size_t c;
+   size_t count = 0;
+   Arena_T arena = ((FT_T) ft)->arena;
+
+   assert(n != NULL);
+   assert(ft != NULL);
+
+   while(n != NULL) {
+      next = NULL;
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         child = Node_getDirChild(n, c);
+         if(child == NULL)
+            continue;
+         if(!FT_hasSubdirectory(child))
+            count += Node_destroyShallow(child, arena);
+         else if(next == NULL)
+            next = child;
+         else if(!Pool_add(((FT_T) ft)->pool, child))
+            count += Node_destroy(child, arena);
+      }
+      count += Node_destroyShallow(n, arena);
+      n = next;
+   }
+
+   /* a concurrent tree counted the hierarchy out as it drained it */
+   if(((FT_T) ft)->epoch == NULL)
+      FT_subtractCount(ft, count);
+}
+
+/*
+   Destroys the hierarchy rooted at n, which is no longer reachable in
+   ft, by handing it to ft's pool if it has one, and otherwise at
+   once. Returns the number of nodes destroyed at once.
+*/
+static size_t FT_destroyHierarchy(FT_T ft, Node_T n) {
+   assert(ft != NULL);
+   assert(n != NULL);
+
+   if(ft->pool != NULL && Pool_add(ft->pool, n))
+      return 0;
+   if(ft->pending != NULL && DynArray_add(ft->pending, n))
+      return 0;
+   return Node_destroy(n, ft->arena);
+}
+
+/*
+   Frees up to ft's budget of nodes from the hierarchies pending
+   removal in ft, if there are any. Called by each operation on ft.
+   The most recently removed directory is taken apart from its last
+   child back, one file or subdirectory at a time, so that each
+   step is cheap however wide the directory: a file is freed, a
+   subdirectory is moved onto the stack, and a directory left with no
+   children is freed. Each step counts against the budget.
+*/
+static void FT_freeSome(FT_T ft) {
+   Node_T n;
+   Node_T child;
+   File_T file;
+   size_t steps;
+   size_t length;
+   size_t numChildren;
+   size_t freed = 0;
+
+   assert(ft != NULL);
+
+   if(ft->pending == NULL)
+      return;
+
+   for(steps = 0; steps < ft->budget; steps++) {
+      length = DynArray_getLength(ft->pending);
+      if(length == 0)
+         break;
+      n = DynArray_get(ft->pending, length - 1);
+
+      numChildren = Node_getNumChildren(n);
+      if(numChildren > 0 &&
+         (file = Node_getFileChild(n, numChildren - 1)) != NULL) {
+         (void) File_unlinkChild(n, file);
+         File_destroy(file);
+         freed++;
+      }
+      else if(numChildren > 0) {
+         child = Node_getDirChild(n, numChildren - 1);
+         (void) Node_unlinkChild(n, child);
+         if(!DynArray_add(ft->pending, child))
+            freed += Node_destroy(child, ft->arena);
+      }
+      else {
+         (void) DynArray_removeAt(ft->pending, length - 1);
+         freed += Node_destroyShallow(n, ft->arena);
+      }
+   }
+   FT_subtractCount(ft, freed);
+}
+
+/*
+   Destroys the hierarchy rooted at n, which was pending removal from
+   a tree without an arena when the tree was freed. extra is unused.
+*/
+static void FT_destroyPending(void* n, void* extra) {
+   assert(n != NULL);
+
+   (void) extra;
+   (void) Node_destroy(n, NULL);
+}
+
+/* see ft.h for specification */
+void FT_setFreeBudgetIn(FT_T ft, size_t budget)
+{
+   assert(ft != NULL);
+
+   ft->budget = budget;
+}
+
+/* see ft.h for specification */
+void FT_setFanOutThresholdIn(FT_T ft, size_t threshold)
+{
+   assert(ft != NULL);
+
+   ft->threshold = threshold;
+}
+
+/* see ft.h for specification */
+void FT_setFanOutOrderedIn(FT_T ft, boolean ordered)
+{
+   assert(ft != NULL);
+
+   ft->ordered = ordered;
+}
+
+/*
+   Destroys the hierarchy rooted at n, which was retired to the epoch
+   of the tree ft once no reader could reach it.
+*/
+static void FT_destroyRetired(void* n, void* ft) {
+   assert(n != NULL);
+   assert(ft != NULL);
+
+   (void) FT_destroyHierarchy(ft, n);
+}
+
+/*
+   Destroys the file f, which was retired to the epoch of the tree ft
+   once no reader could reach it.
+*/
+static void FT_destroyRetiredFile(void* f, void* ft) {
+   assert(f != NULL);
+
+   (void) ft;
+   File_destroy(f);
+}
+
+/*
+   Frees the frozen copy frozen, once no reader could still be using
+   it. extra is unused.
+*/
+static void FT_freeFrozen(void* frozen, void* extra) {
+   (void) extra;
+   Frozen_free(frozen);
+}
+
+/*
+   Thaws ft, if it is frozen, so that reads go back to its live
+   hierarchy. Called by each function that may change the tree,
+   before it does.
+*/
+static void FT_thaw(FT_T ft) {
+   Frozen_T frozen;
+
+   assert(ft != NULL);
+
+   if(__atomic_load_n(&ft->frozen, __ATOMIC_RELAXED) == NULL)
+      return;
+   frozen = __atomic_exchange_n(&ft->frozen, NULL, __ATOMIC_ACQ_REL);
+   if(frozen != NULL)
+      Epoch_retire(ft->epoch, frozen, FT_freeFrozen, NULL);
+}
+
+/*
+   Returns the frozen copy of ft's hierarchy, or NULL if ft is not
+   frozen. In a concurrent tree, the caller must be inside ft's epoch
+   until it is done with the copy.
+*/
+static Frozen_T FT_getFrozen(FT_T ft) {
+   assert(ft != NULL);
+
+   return __atomic_load_n(&ft->frozen, __ATOMIC_ACQUIRE);
+}
+
+/*
+   Looks up path in frozen, as FT_findFile does in a live hierarchy,
+   except that for a file it stores its contents in *pContents and
+   their length in *pLength.
+*/
+static int FT_findFrozen(Frozen_T frozen, const char* path,
+                         void** pContents, size_t* pLength) {
+   size_t entry;
+
+   assert(frozen != NULL);
+   assert(path != NULL);
+   assert(pContents != NULL);
+   assert(pLength != NULL);
+
+   if(!Frozen_find(frozen, path, &entry))
+      return NO_SUCH_PATH;
+   if(!Frozen_isFile(frozen, entry))
+      return NOT_A_FILE;
+   *pContents = Frozen_getContents(frozen, entry);
+   *pLength = Frozen_getLength(frozen, entry);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_insertDirIn(FT_T ft, const char *path)
+{
+   Node_T curr;
+   size_t length;
+   size_t prefix = 0;
+   int result;
+   boolean isFile = FALSE;
+   boolean foundFullPath = FALSE;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+   FT_thaw(ft);
+
+   /* writers stay inside the epoch too, so that the ancestors of the
+      directory they hold are not freed under them if they are removed
+      meanwhile */
+   Epoch_enter(ft->epoch);
+   length = strlen(path);
+   curr = FT_traversePath(ft, path, length, &isFile, &foundFullPath,
+                          &prefix);
+
+   if(foundFullPath)
+      result = ALREADY_IN_TREE;
+   else if(isFile)
+      result = NOT_A_DIRECTORY;
+   else if(curr == NULL && ft->root != NULL)
+      result = CONFLICTING_PATH;
+   else
+      result = FT_insertRestOfPath(ft, path, length, curr, prefix,
+                                   NULL);
+
+   FT_unlock(ft, curr);
+   Epoch_leave(ft->epoch);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsDirIn(FT_T ft, const char *path)
+{
+   Frozen_T frozen;
+   void *contents;
+   size_t length;
+   boolean found;
+   boolean isFile = FALSE;
+   boolean foundFullPath = FALSE;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+
+   Epoch_enter(ft->epoch);
+   frozen = FT_getFrozen(ft);
+   if(frozen != NULL)
+      found = (boolean) (FT_findFrozen(frozen, path, &contents, &length)
+                         == NOT_A_FILE);
+   else if(ft->dirIndex != NULL)
+      found = (boolean) SymTable_contains(ft->dirIndex, path);
+   else {
+      (void) FT_lookupPath(ft, path, strlen(path), &isFile,
+                           &foundFullPath);
+      found = (boolean) (foundFullPath && !isFile);
+   }
+   Epoch_leave(ft->epoch);
+
+   return found;
+}
+
+/*
+   Unlinks the directory path from ft's tree, as FT_rmDirIn does, and
+   stores it in *pRemoved. In a concurrent tree, the caller must be
+   inside ft's epoch, and is left to retire the directory, once it has
+   left; otherwise it is destroyed here.
+   Returns the status that FT_rmDirIn would.
+*/
+static int FT_unlinkDir(FT_T ft, const char *path, Node_T *pRemoved)
+{
+   Node_T curr, parent;
+   File_T file;
+   const char* lastSlash;
+   int result;
+   boolean isFile = FALSE;
+   boolean foundFullPath = FALSE;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+   assert(pRemoved != NULL);
+
+   if(ft->dirIndex != NULL) {
+      curr = SymTable_get(ft->dirIndex, path);
+      if(curr == NULL) {
+         if(SymTable_contains(ft->fileIndex, path))
+            return NOT_A_DIRECTORY;
+         return NO_SUCH_PATH;
+      }
+      parent = Node_getParent(curr);
+   }
+   else {
+      /* lock the parent of the directory exclusively, which for the
+         root is the root pointer */
+      lastSlash = strrchr(path, '/');
+      if(lastSlash == NULL) {
+         parent = NULL;
+         FT_lock(ft, NULL, TRUE);
+         curr = ft->root;
+         if(curr == NULL || strcmp(Node_getName(curr), path)) {
+            FT_unlock(ft, NULL);
+            return NO_SUCH_PATH;
+         }
+      }
+      else {
+         parent = FT_traversePath(ft, path, (size_t) (lastSlash - path),
+                                  &isFile, &foundFullPath, NULL);
+         if(!foundFullPath || isFile) {
+            FT_unlock(ft, parent);
+            return NO_SUCH_PATH;
+         }
+         curr = Node_findChild(parent, lastSlash + 1, &file);
+         if(curr == NULL) {
+            result = (file != NULL) ? NOT_A_DIRECTORY : NO_SUCH_PATH;
+            FT_unlock(ft, parent);
+            return result;
+         }
+      }
+      FT_lock(ft, curr, TRUE);
+   }
+
+   /* unlinking from a concurrent tree's parent can fail for want of
+      memory, leaving everything as it was */
+   if(parent == NULL)
+      __atomic_store_n(&ft->root, NULL, __ATOMIC_RELEASE);
+   else if((result = Node_unlinkChild(parent, curr)) != SUCCESS) {
+      FT_unlock(ft, curr);
+      FT_unlock(ft, parent);
+      return result;
+   }
+   FT_unindexHierarchy(ft, curr, path);
+   FT_unlock(ft, parent);
+
+   if(ft->epoch == NULL)
+      FT_subtractCount(ft, FT_destroyHierarchy(ft, curr));
+   else {
+      /* once unlinked, the hierarchy can only be left, not entered */
+      FT_subtractCount(ft, FT_drain(ft, curr));
+      FT_unlock(ft, curr);
+      *pRemoved = curr;
+   }
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_rmDirIn(FT_T ft, const char *path)
+{
+   Node_T removed = NULL;
+   int result;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+   FT_thaw(ft);
+
+   Epoch_enter(ft->epoch);
+   result = FT_unlinkDir(ft, path, &removed);
+   Epoch_leave(ft->epoch);
+
+   /* writers still inside may hold a directory beneath it until the
+      epoch moves on, as may readers */
+   if(removed != NULL)
+      Epoch_retire(ft->epoch, removed, FT_destroyRetired, ft);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertFileIn(FT_T ft, const char *path, void *contents,
+                    size_t length)
+{
+   File_T file;
+   Node_T locked;
+   Node_T current;
+   const char *lastOccurance;
+   size_t prefix = 0;
+   int result;
+   boolean isFile = FALSE;
+   boolean foundFullPath = FALSE;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+   FT_thaw(ft);
+
+   /* the parent directory's path runs up to the last slash */
+   lastOccurance = strrchr(path, '/');
+
+   if(lastOccurance == NULL)
+      return CONFLICTING_PATH;
+
+   /* search for the parent directory of the target file */
+   Epoch_enter(ft->epoch);
+   locked = FT_traversePath(ft, path, (size_t) (lastOccurance - path),
+                            &isFile, &foundFullPath, &prefix);
+   current = locked;
+
+   /* the path terminates at a prefix file */
+   result = SUCCESS;
+   if(isFile)
+      result = NOT_A_DIRECTORY;
+
+   /* if the full parent path doesn't exist, insert it and continue
+      down to the parent directory once created */
+   else if(!foundFullPath) {
+      if(current == NULL && ft->root != NULL)
+         result = CONFLICTING_PATH;
+      else
+         result = FT_insertRestOfPath(ft, path,
+                                      (size_t) (lastOccurance - path),
+                                      current, prefix, &current);
+   }
+
+   /* check if the parent directory already has a child with the name */
+   lastOccurance++;
+   if(result == SUCCESS) {
+      if(Node_findChild(current, lastOccurance, &file) != NULL ||
+         file != NULL)
+         result = ALREADY_IN_TREE;
+      else if((file = File_create(lastOccurance, current, contents,
+                                  length, ft->slab)) == NULL)
+         result = MEMORY_ERROR;
+      else if((result = File_linkChild(current, file, ft->arena,
+                                       ft->threshold, ft->ordered))
+              != SUCCESS)
+         File_destroy(file);
+      else {
+         FT_addCount(ft, 1);
+         FT_indexFile(ft, file, path);
+      }
+   }
+
+   FT_unlock(ft, locked);
+   Epoch_leave(ft->epoch);
+   return result;
+}
+
+/*
+   Compares the paths path1 and path2 one component at a time, as
+   strcmp would except that a slash sorts before every other character,
+   so that a directory comes directly before the entries beneath it and
+   siblings come in the order that a directory keeps its children.
+*/
+static int FT_comparePaths(const char* path1, const char* path2) {
+   int c1, c2;
+
+   assert(path1 != NULL);
+   assert(path2 != NULL);
+
+   while(*path1 == *path2 && *path1 != '\0') {
+      path1++;
+      path2++;
+   }
+
+   c1 = (*path1 == '/') ? 1 : (*path1 == '\0') ? 0 :
+        (int) (unsigned char) *path1 + 1;
+   c2 = (*path2 == '/') ? 1 : (*path2 == '\0') ? 0 :
+        (int) (unsigned char) *path2 + 1;
+   return c1 - c2;
+}
+
+/*
+   Compares the paths that the elements of a paths array that ppPath1
+   and ppPath2 point to hold, as FT_comparePaths does, for sorting an
+   array of pointers to the elements.
+*/
+static int FT_comparePathPtrs(const void* ppPath1,
+                              const void* ppPath2) {
+   assert(ppPath1 != NULL);
+   assert(ppPath2 != NULL);
+
+   return FT_comparePaths(**(char** const*) ppPath1,
+                          **(char** const*) ppPath2);
+}
+
+/*
+   Adds directory n, whose full path is the first length characters of
+   path, to the path index, if there is one, copying the path into
+   *pBuffer, which holds *pSize characters, to terminate it.
+*/
+static void FT_indexPrefix(FT_T ft, Node_T n, const char* path,
+                           size_t length, char** pBuffer,
+                           size_t* pSize) {
+   assert(n != NULL);
+   assert(path != NULL);
+
+   if(ft->dirIndex == NULL)
+      return;
+
+   if(!FT_reserve(pBuffer, pSize, length + 1)) {
+      FT_dropIndex(ft);
+      return;
+   }
+   memcpy(*pBuffer, path, length);
+   (*pBuffer)[length] = '\0';
+   if(!SymTable_put(ft->dirIndex, *pBuffer, n))
+      FT_dropIndex(ft);
+}
+
+/*
+   Removes the hierarchy rooted at firstNew, whose full path is the
+   first length characters of path, from the tree, after an insertion
+   that created it fails part way. *pBuffer, which holds *pSize
+   characters, is used to terminate the path.
+*/
+static void FT_undoInsertion(FT_T ft, Node_T firstNew, const char* path,
+                             size_t length, char** pBuffer,
+                             size_t* pSize) {
+   assert(firstNew != NULL);
+   assert(path != NULL);
+
+   if(ft->dirIndex != NULL) {
+      if(FT_reserve(pBuffer, pSize, length + 1)) {
+         memcpy(*pBuffer, path, length);
+         (*pBuffer)[length] = '\0';
+         FT_unindexHierarchy(ft, firstNew, *pBuffer);
+      }
+      else
+         FT_dropIndex(ft);
+   }
+
+   if(Node_getParent(firstNew) == NULL)
+      ft->root = NULL;
+   else
+      (void) Node_unlinkChild(Node_getParent(firstNew), firstNew);
+   FT_subtractCount(ft, Node_destroy(firstNew, ft->arena));
+}
+
+/*
+   Inserts one entry of FT_insertMany: the directory path, if isFile is
+   FALSE, or the file path with contents of size length bytes, if
+   isFile is TRUE. prev is the previous entry, or NULL, and *pCurr is a
+   directory whose path is the first *pCurrLength characters of prev,
+   or NULL (with *pCurrLength 0) if there is no previous entry. The
+   descent starts from the deepest ancestor of *pCurr that path shares,
+   rather than from the root, and afterwards *pCurr and *pCurrLength
+   are left at the directory deepest down path. *pBuffer, holding
+   *pSize characters, is used to build paths for the index.
+   Returns the status that FT_insertDir or FT_insertFile would.
+*/
+static int FT_insertNext(FT_T ft, const char* path, boolean isFile,
+                         void* contents, size_t length,
+                         const char* prev, Node_T* pCurr,
+                         size_t* pCurrLength, char** pBuffer,
+                         size_t* pSize) {
+   Node_T curr = *pCurr;
+   size_t currLength = *pCurrLength;
+   Node_T firstNew = NULL;
+   size_t firstNewLength = 0;
+   Node_T new;
+   File_T file;
+   const char* lastSlash;
+   const char* name;
+   size_t pathLength;
+   size_t parentLength;
+   size_t nameLength;
+   size_t shared = 0;
+   int result;
+
+   assert(path != NULL);
+
+   FT_thaw(ft);
+
+   pathLength = strlen(path);
+   lastSlash = strrchr(path, '/');
+   parentLength = (lastSlash == NULL) ? 0 : (size_t) (lastSlash - path);
+
+   /* climb from the previous entry's directory to the deepest one that
+      is also an ancestor of this entry */
+   if(prev != NULL)
+      while(shared < currLength && path[shared] == prev[shared])
+         shared++;
+   while(curr != NULL &&
+         (lastSlash == NULL || currLength > shared ||
+          currLength > parentLength || path[currLength] != '/')) {
+      currLength -= strlen(Node_getName(curr));
+      curr = Node_getParent(curr);
+      if(curr != NULL)
+         currLength--;
+   }
+
+   /* descend to the new entry's parent, creating directories on the
+      way, and then to the entry itself if it is a directory */
+   result = SUCCESS;
+   while(result == SUCCESS) {
+      if(curr == NULL) {
+         if(isFile && lastSlash == NULL)
+            return CONFLICTING_PATH;
+         name = path;
+      }
+      else if(currLength == parentLength && isFile)
+         break;
+      else if(currLength == pathLength)
+         break;
+      else
+         name = path + currLength + 1;
+      nameLength = strcspn(name, "/");
+
+      if(curr == NULL && ft->root != NULL) {
+         /* the first component must name the root */
+         if(strncmp(name, Node_getName(ft->root), nameLength) ||
+            Node_getName(ft->root)[nameLength] != '\0')
+            return CONFLICTING_PATH;
+         if(name[nameLength] == '\0')
+            result = ALREADY_IN_TREE;
+         new = ft->root;
+      }
+      else if(curr != NULL &&
+              (new = Node_findChild(curr, name, &file)) != NULL) {
+         if(name[nameLength] == '\0')
+            result = ALREADY_IN_TREE;
+      }
+      else if(curr != NULL && file != NULL) {
+         result = (name[nameLength] == '\0') ? ALREADY_IN_TREE :
+                                               NOT_A_DIRECTORY;
+         break;
+      }
+      else {
+         new = Node_create(name, curr, ft->slab);
+         if(new == NULL) {
+            result = MEMORY_ERROR;
+            break;
+         }
+         if(curr == NULL)
+            ft->root = new;
+         else if((result = Node_linkChild(curr, new, ft->arena,
+                                          ft->threshold, ft->ordered))
+                 != SUCCESS) {
+            (void) Node_destroy(new, ft->arena);
+            break;
+         }
+         FT_addCount(ft, 1);
+         if(firstNew == NULL) {
+            firstNew = new;
+            firstNewLength = (size_t) (name - path) + nameLength;
+         }
+         FT_indexPrefix(ft, new, path,
+                        (size_t) (name - path) + nameLength,
+                        pBuffer, pSize);
+      }
+
+      curr = new;
+      currLength = (size_t) (name - path) + nameLength;
+   }
+
+   if(result == SUCCESS && isFile) {
+      name = lastSlash + 1;
+      if(Node_findChild(curr, name, &file) != NULL || file != NULL)
+         result = ALREADY_IN_TREE;
+      else if((file = File_create(name, curr, contents, length,
+                                  ft->slab)) == NULL)
+         result = MEMORY_ERROR;
+      else if((result = File_linkChild(curr, file, ft->arena,
+                                       ft->threshold, ft->ordered))
+              != SUCCESS)
+         File_destroy(file);
+      else {
+         FT_addCount(ft, 1);
+         FT_indexFile(ft, file, path);
+      }
+   }
+
+   if(result != SUCCESS) {
+      if(firstNew != NULL)
+         FT_undoInsertion(ft, firstNew, path, firstNewLength, pBuffer,
+                          pSize);
+      return result;
+   }
+
+   *pCurr = curr;
+   *pCurrLength = currLength;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_insertManyIn(FT_T ft, char **paths, void **contents,
+                    size_t *lengths, size_t n)
+{
+   char*** sorted = NULL;
+   char* buffer = NULL;
+   size_t size = 0;
+   Node_T curr = NULL;
+   size_t currLength = 0;
+   const char* prev = NULL;
+   size_t i, e;
+   int result = SUCCESS;
+
+   assert(ft != NULL);
+   assert(paths != NULL || n == 0);
+   assert(contents == NULL || lengths != NULL);
+
+   FT_freeSome(ft);
+
+   /* sort pointers to the entries, unless they are already in order */
+   for(i = 1; i < n; i++)
+      if(FT_comparePaths(paths[i - 1], paths[i]) > 0)
+         break;
+   if(i < n) {
+      sorted = malloc(n * sizeof(char**));
+      if(sorted == NULL)
+         return MEMORY_ERROR;
+      for(i = 0; i < n; i++)
+         sorted[i] = &paths[i];
+      qsort(sorted, n, sizeof(char**), FT_comparePathPtrs);
+   }
+
+   for(i = 0; i < n && result == SUCCESS; i++) {
+      e = (sorted == NULL) ? i : (size_t) (sorted[i] - paths);
+      assert(paths[e] != NULL);
+      /* other threads may change the tree between entries, so each
+         one is inserted from the root, under the usual locks */
+      if(ft->rootLock != NULL && contents == NULL)
+         result = FT_insertDirIn(ft, paths[e]);
+      else if(ft->rootLock != NULL)
+         result = FT_insertFileIn(ft, paths[e], contents[e],
+                                  lengths[e]);
+      else if(contents == NULL)
+         result = FT_insertNext(ft, paths[e], FALSE, NULL, 0, prev,
+                                &curr, &currLength, &buffer, &size);
+      else
+         result = FT_insertNext(ft, paths[e], TRUE, contents[e],
+                                lengths[e], prev, &curr, &currLength,
+                                &buffer, &size);
+      prev = paths[e];
+   }
+
+   free(sorted);
+   free(buffer);
+   return result;
+}
+
+/*
+   Looks up the file at path, storing it in *pFile.
+   Returns SUCCESS if found, NO_SUCH_PATH if path does not exist,
+   or NOT_A_FILE if path is a directory.
+   If pLocked is NULL, the lookup takes no locks, as FT_lookupPath
+   does, and the caller must be inside ft's epoch. Otherwise, the
+   lookup is a writer's: whatever the result, *pLocked is set to the
+   directory left locked exclusively, which guards the file until the
+   caller releases it with FT_unlock(ft, *pLocked).
+*/
+static int FT_findFile(FT_T ft, const char *path, File_T *pFile,
+                       Node_T *pLocked)
+{
+   Node_T parent;
+   boolean isFile = FALSE;
+   boolean foundFullPath = FALSE;
+
+   assert(path != NULL);
+   assert(pFile != NULL);
+
+   if(pLocked != NULL)
+      *pLocked = NULL;
+   if(ft->fileIndex != NULL) {
+      *pFile = SymTable_get(ft->fileIndex, path);
+      if(*pFile != NULL)
+         return SUCCESS;
+      if(SymTable_contains(ft->dirIndex, path))
+         return NOT_A_FILE;
+      return NO_SUCH_PATH;
+   }
+
+   if(pLocked == NULL)
+      parent = FT_lookupPath(ft, path, strlen(path), &isFile,
+                             &foundFullPath);
+   else {
+      parent = FT_traversePath(ft, path, strlen(path), &isFile,
+                               &foundFullPath, NULL);
+      *pLocked = parent;
+   }
+
+   if(!foundFullPath)
+      return NO_SUCH_PATH;
+
+   if(!isFile)
+      return NOT_A_FILE;
+
+   /* without a lock, the file may have been removed meanwhile */
+   *pFile = Node_findFileChild(parent, strrchr(path, '/') + 1);
+   if(*pFile == NULL)
+      return NO_SUCH_PATH;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+boolean FT_containsFileIn(FT_T ft, const char *path)
+{
+   Frozen_T frozen;
+   File_T file;
+   void *contents;
+   size_t length;
+   int result;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+
+   Epoch_enter(ft->epoch);
+   frozen = FT_getFrozen(ft);
+   if(frozen != NULL)
+      result = FT_findFrozen(frozen, path, &contents, &length);
+   else
+      result = FT_findFile(ft, path, &file, NULL);
+   Epoch_leave(ft->epoch);
+   return (boolean) (result == SUCCESS);
+}
+
+/* see ft.h for specification */
+int FT_rmFileIn(FT_T ft, const char *path)
+{
+   File_T file;
+   Node_T locked;
+   int result;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+   FT_thaw(ft);
+
+   Epoch_enter(ft->epoch);
+   result = FT_findFile(ft, path, &file, &locked);
+   if(result == SUCCESS)
+      result = File_unlinkChild(File_getParent(file), file);
+   if(result == SUCCESS) {
+      if(ft->fileIndex != NULL)
+         (void) SymTable_remove(ft->fileIndex, path);
+      FT_subtractCount(ft, 1);
+   }
+   FT_unlock(ft, locked);
+   Epoch_leave(ft->epoch);
+
+   /* readers may still hold the file until the epoch moves on */
+   if(result == SUCCESS)
+      Epoch_retire(ft->epoch, file, FT_destroyRetiredFile, ft);
+   return result;
+}
+
+/* see ft.h for specification */
+void *FT_getFileContentsIn(FT_T ft, const char *path)
+{
+   Frozen_T frozen;
+   File_T file;
+   void *contents = NULL;
+   size_t length;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+
+   Epoch_enter(ft->epoch);
+   frozen = FT_getFrozen(ft);
+   if(frozen != NULL) {
+      if(FT_findFrozen(frozen, path, &contents, &length) != SUCCESS)
+         contents = NULL;
+   }
+   else if(FT_findFile(ft, path, &file, NULL) == SUCCESS)
+      contents = File_getContents(file);
+   Epoch_leave(ft->epoch);
+
+   return contents;
+}
+
+/* see ft.h for specification */
+void *FT_replaceFileContentsIn(FT_T ft, const char *path,
+                               void *newContents, size_t newLength)
+{
+   File_T file;
+   Node_T locked;
+   void *oldContents = NULL;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+
+   FT_freeSome(ft);
+   FT_thaw(ft);
+
+   Epoch_enter(ft->epoch);
+   if(FT_findFile(ft, path, &file, &locked) == SUCCESS)
+      oldContents = File_replaceContents(file, newContents, newLength);
+
+   FT_unlock(ft, locked);
+   Epoch_leave(ft->epoch);
+   return oldContents;
+}
+
+/* see ft.h for specification */
+int FT_statIn(FT_T ft, const char *path, boolean *type,
+              size_t *length)
+{
+   Frozen_T frozen;
+   File_T file;
+   void *contents;
+   size_t fileLength = 0;
+   int result;
+
+   assert(ft != NULL);
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
+
+   FT_freeSome(ft);
+
+   Epoch_enter(ft->epoch);
+   frozen = FT_getFrozen(ft);
+   if(frozen != NULL)
+      result = FT_findFrozen(frozen, path, &contents, &fileLength);
+   else {
+      result = FT_findFile(ft, path, &file, NULL);
+      if(result == SUCCESS)
+         fileLength = File_getContentLength(file);
+   }
+   if(result == NOT_A_FILE) {
+      *type = FALSE;
+      result = SUCCESS;
+   }
+   else if(result == SUCCESS) {
+      *type = TRUE;
+      *length = fileLength;
+   }
+   Epoch_leave(ft->epoch);
+
+   return result;
+}
+
+/* The most worker threads that a tree's pool is given. */
+enum { FT_MAX_RECLAIMERS = 8 };
+
+/*
+   Returns the number of worker threads to give a tree's pool: one per
+   processor online, up to FT_MAX_RECLAIMERS.
+*/
+static size_t FT_reclaimers(void) {
+   long online;
+
+   online = sysconf(_SC_NPROCESSORS_ONLN);
+   if(online < 1)
+      return 1;
+   if(online > FT_MAX_RECLAIMERS)
+      return FT_MAX_RECLAIMERS;
+   return (size_t) online;
+}
+
+/*
+   Returns a new slab for ft's nodes and files, shared if ft is, with
+   a table of their names attached, or NULL if there is an allocation
+   error.
+*/
+static Slab_T FT_newSlab(FT_T ft) {
+   Slab_T slab;
+   Names_T names;
+   boolean shared;
+
+   assert(ft != NULL);
+
+   shared = (boolean) (ft->rootLock != NULL || ft->pool != NULL);
+   slab = Slab_new(shared);
+   if(slab == NULL)
+      return NULL;
+   names = Names_new(slab, shared);
+   if(names == NULL) {
+      Slab_free(slab);
+      return NULL;
+   }
+   Slab_setClient(slab, names);
+   return slab;
+}
+
+/*
+   Frees slab, which may be NULL, made by FT_newSlab, and its table of
+   names, with every record and name still in it.
+*/
+static void FT_freeSlab(Slab_T slab) {
+   if(slab == NULL)
+      return;
+
+   Names_free(Slab_getClient(slab));
+   Slab_free(slab);
+}
+
+/* see ft.h for specification */
+FT_T FT_new(unsigned int options)
+{
+   FT_T ft;
+
+   ft = malloc(sizeof(struct FT));
+   if(ft == NULL)
+      return NULL;
+
+   ft->root = NULL;
+   ft->count = 0;
+   ft->rootLock = NULL;
+   ft->epoch = NULL;
+   ft->dirIndex = NULL;
+   ft->fileIndex = NULL;
+   ft->arena = NULL;
+   ft->slab = NULL;
+   ft->pool = NULL;
+   ft->pending = NULL;
+   ft->budget = FT_FREE_BUDGET;
+   ft->threshold = __atomic_load_n(&fanOutThreshold, __ATOMIC_RELAXED);
+   ft->ordered = __atomic_load_n(&fanOutOrdered, __ATOMIC_RELAXED);
+   ft->frozen = NULL;
+
+   if(options & FT_CONCURRENT) {
+      ft->rootLock = malloc(sizeof(pthread_rwlock_t));
+      if(ft->rootLock == NULL) {
+         free(ft);
+         return NULL;
+      }
+      if(pthread_rwlock_init(ft->rootLock, NULL) != 0) {
+         free(ft->rootLock);
+         free(ft);
+         return NULL;
+      }
+      ft->epoch = Epoch_new();
+      if(ft->epoch == NULL) {
+         FT_free(ft);
+         return NULL;
+      }
+   }
+
+   /* a single index would serialize every writer, so a concurrent
+      tree goes without one */
+   if((options & FT_PATH_INDEX) && ft->rootLock == NULL) {
+      ft->dirIndex = SymTable_new();
+      ft->fileIndex = SymTable_new();
+      if(ft->dirIndex == NULL || ft->fileIndex == NULL) {
+         FT_free(ft);
+         return NULL;
+      }
+   }
+
+   if(options & FT_PARALLEL_FREE) {
+      ft->pool = Pool_new(FT_reclaimers(), FT_destroyInPool, ft);
+      if(ft->pool == NULL) {
+         FT_free(ft);
+         return NULL;
+      }
+   }
+
+   /* a concurrent tree already frees outside its readers' way, and a
+      pool frees sooner, so pending removals are for plain trees */
+   if((options & FT_INCREMENTAL_FREE) && ft->rootLock == NULL &&
+      ft->pool == NULL) {
+      ft->pending = DynArray_new(0);
+      if(ft->pending == NULL) {
+         FT_free(ft);
+         return NULL;
+      }
+   }
+
+   /* the pool's workers release what they free to the arena while
+      other threads allocate from it */
+   if(options & FT_ARENA) {
+      if(ft->rootLock != NULL || ft->pool != NULL)
+         ft->arena = Arena_newShared();
+      else
+         ft->arena = Arena_new();
+      if(ft->arena == NULL) {
+         FT_free(ft);
+         return NULL;
+      }
+   }
+
+   /* every tree's nodes come from a slab, shared as the arena is,
+      and their names from the table attached to it */
+   ft->slab = FT_newSlab(ft);
+   if(ft->slab == NULL) {
+      FT_free(ft);
+      return NULL;
+   }
+
+   return ft;
+}
+
+/* see ft.h for specification */
+void FT_free(FT_T ft)
+{
+   if(ft == NULL)
+      return;
+
+   /* what is still retired goes first, back to the arena if any */
+   Epoch_free(ft->epoch);
+
+   /* and then what is still pending, unless the arena takes it */
+   if(ft->pending != NULL) {
+      if(ft->arena == NULL)
+         DynArray_map(ft->pending, FT_destroyPending, NULL);
+      DynArray_free(ft->pending);
+      ft->pending = NULL;
+   }
+
+   /* with an arena, the whole hierarchy goes with its chunks, once the
+      pool is done with what it is still freeing */
+   if(ft->arena == NULL && ft->root != NULL)
+      (void) FT_destroyHierarchy(ft, ft->root);
+   Pool_free(ft->pool);
+   Arena_free(ft->arena);
+   FT_freeSlab(ft->slab);
+   Frozen_free(ft->frozen);
+
+   FT_dropIndex(ft);
+   if(ft->rootLock != NULL) {
+      (void) pthread_rwlock_destroy(ft->rootLock);
+      free(ft->rootLock);
+   }
+   free(ft);
+}
+
+/* see ft.h for specification */
+int FT_compactIn(FT_T ft)
+{
+   Node_T copy;
+   Node_T old;
+   Slab_T slab;
+   Slab_T oldSlab;
+   char* buffer;
+   size_t size;
+   size_t length;
+
+   assert(ft != NULL);
+
+   /* whatever is waiting to be freed is still in the old slab, so it
+      goes first */
+   Epoch_flush(ft->epoch);
+   if(ft->pool != NULL)
+      Pool_wait(ft->pool);
+   if(ft->pending != NULL)
+      while((length = DynArray_getLength(ft->pending)) > 0)
+         FT_subtractCount(ft, Node_destroy(
+            DynArray_removeAt(ft->pending, length - 1), ft->arena));
+
+   if(ft->root == NULL)
+      return SUCCESS;
+
+   slab = FT_newSlab(ft);
+   if(slab == NULL)
+      return MEMORY_ERROR;
+   copy = Node_copy(ft->root, slab, ft->arena, ft->threshold,
+                    ft->ordered);
+   if(copy == NULL) {
+      FT_freeSlab(slab);
+      return MEMORY_ERROR;
+   }
+
+   /* the index keeps its paths, which now lead to the copies */
+   if(ft->dirIndex != NULL) {
+      size = strlen(Node_getName(copy)) + 1;
+      buffer = malloc(size);
+      if(buffer == NULL)
+         FT_dropIndex(ft);
+      else {
+         strcpy(buffer, Node_getName(copy));
+         if(!FT_reindexFrom(ft, copy, &buffer, &size, size - 1))
+            FT_dropIndex(ft);
+         free(buffer);
+      }
+   }
+
+   old = ft->root;
+   oldSlab = ft->slab;
+   __atomic_store_n(&ft->root, copy, __ATOMIC_RELEASE);
+   ft->slab = slab;
+
+   /* the old nodes go with their slab, but their children sets must
+      be freed, or released to the arena, one by one */
+   (void) Node_destroy(old, ft->arena);
+   FT_freeSlab(oldSlab);
+   return SUCCESS;
+}
+
+/*
+   Adds the directory n, whose parent is the entry parent of frozen,
+   and everything beneath it to frozen, in the order in which
+   FT_toString lists them: n, then its files, then each of its
+   subdirectories with everything beneath it. *pNext is the number of
+   entries in frozen so far, and is advanced past those added.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_freezeFrom(Frozen_T frozen, Node_T n, size_t parent,
+                             size_t* pNext) {
+   Node_T child;
+   File_T f;
+   size_t self;
+   size_t c;
+
+   assert(frozen != NULL);
+   assert(n != NULL);
+   assert(pNext != NULL);
+
+   self = (*pNext)++;
+   if(!Frozen_add(frozen, parent, Node_getName(n), FALSE, NULL, 0))
+      return FALSE;
+
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      f = Node_getFileChild(n, c);
+      if(f == NULL)
+         continue;
+      (*pNext)++;
+      if(!Frozen_add(frozen, self, File_getName(f), TRUE,
+                     File_getContents(f), File_getContentLength(f)))
+         return FALSE;
+   }
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_getDirChild(n, c);
+      if(child != NULL && !FT_freezeFrom(frozen, child, self, pNext))
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/* see ft.h for specification */
+int FT_freezeIn(FT_T ft)
+{
+   Frozen_T frozen;
+   size_t next = 0;
+
+   assert(ft != NULL);
+
+   if(ft->frozen != NULL)
+      return SUCCESS;
+
+   frozen = Frozen_new();
+   if(frozen == NULL)
+      return MEMORY_ERROR;
+   if((ft->root != NULL && !FT_freezeFrom(frozen, ft->root, 0, &next))
+      || !Frozen_finish(frozen)) {
+      Frozen_free(frozen);
+      return MEMORY_ERROR;
+   }
+
+   __atomic_store_n(&ft->frozen, frozen, __ATOMIC_RELEASE);
+   return SUCCESS;
+}
+
+/*
+   Appends a slash, if slash is TRUE, and then name to the path of
+   *pLength characters in *pBuffer, which holds *pSize characters,
+   growing the buffer as necessary and keeping it '\0'-terminated.
+   Updates *pLength to the new length of the path.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_appendName(char** pBuffer, size_t* pSize,
+                             size_t* pLength, const char* name,
+                             boolean slash) {
+   size_t nameLength;
+
+   assert(pLength != NULL);
+   assert(name != NULL);
+
+   nameLength = strlen(name);
+   if(!FT_reserve(pBuffer, pSize, *pLength + nameLength + 2))
+      return FALSE;
+
+   if(slash)
+      (*pBuffer)[(*pLength)++] = '/';
+   memcpy(*pBuffer + *pLength, name, nameLength + 1);
+   *pLength += nameLength;
+   return TRUE;
+}
+
+/*
+   Returns the first of n's subdirectories whose identifier is c or
+   more, skipping over the files among them, or NULL if there is none.
+*/
+static Node_T FT_nextDirChild(Node_T n, size_t c) {
+   Node_T child = NULL;
+
+   assert(n != NULL);
+
+   for(; child == NULL && c < Node_getNumChildren(n); c++)
+      child = Node_getDirChild(n, c);
+   return child;
+}
+
+/*
+   Calls (*callback)(line, length, ctx) for each directory and file of
+   the hierarchy of ft rooted at top, as FT_forEachLine does, where
+   each line is the path from top down. top must be locked shared by
+   the caller, and the directories beneath it are locked shared in
+   turn by the walk, which releases them all before returning.
+   Returns the status that FT_forEachLine would.
+*/
+static int FT_walk(FT_T ft, Node_T top,
+                   int (*callback)(const char* line, size_t length,
+                                   void* ctx),
+                   void* ctx) {
+   Node_T n = top;
+   Node_T next;
+   File_T f;
+   size_t c;
+   char* path = NULL;
+   size_t size = 0;
+   size_t length = 0;
+   int result = SUCCESS;
+
+   assert(ft != NULL);
+   assert(top != NULL);
+   assert(callback != NULL);
+
+   if(!FT_appendName(&path, &size, &length, Node_getName(n), FALSE))
+      return MEMORY_ERROR;
+
+   /* walk the hierarchy in pre-order without recursion, keeping only
+      the path of the current directory, which is extended by one name
+      on the way down and cut back by one name on the way up; each
+      directory on the current path is held locked shared, so that
+      nothing on it can be removed during the walk */
+   while(result == SUCCESS) {
+      result = (*callback)(path, length, ctx);
+
+      /* n's files come first, picked out from among its children */
+      for(c = 0; result == SUCCESS &&
+                 c < Node_getNumChildren(n); c++) {
+         f = Node_getFileChild(n, c);
+         if(f == NULL)
+            continue;
+         if(!FT_appendName(&path, &size, &length, File_getName(f),
+                           TRUE))
+            result = MEMORY_ERROR;
+         else {
+            result = (*callback)(path, length, ctx);
+            length -= strlen(File_getName(f)) + 1;
+         }
+      }
+      if(result != SUCCESS)
+         break;
+
+      /* the next directory is n's first subdirectory, if it has one,
+         or else the next sibling of n or of its nearest ancestor
+         below top that has one */
+      next = FT_nextDirChild(n, 0);
+      while(next == NULL && n != top) {
+         (void) Node_hasDirChild(Node_getParent(n), Node_getName(n),
+                                 &c);
+         length -= strlen(Node_getName(n)) + 1;
+         FT_unlock(ft, n);
+         n = Node_getParent(n);
+         next = FT_nextDirChild(n, c + 1);
+      }
+      if(next == NULL)
+         break;
+
+      FT_lock(ft, next, FALSE);
+      n = next;
+      if(!FT_appendName(&path, &size, &length, Node_getName(n), TRUE))
+         result = MEMORY_ERROR;
+   }
+
+   /* release whatever is still held below top */
+   while(n != top) {
+      next = Node_getParent(n);
+      FT_unlock(ft, n);
+      n = next;
+   }
+
+   free(path);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_forEachLineIn(FT_T ft,
+                     int (*callback)(const char* line, size_t length,
+                                     void* ctx),
+                     void* ctx)
+{
+   Frozen_T frozen;
+   Node_T root;
+   char* path;
+   int result = SUCCESS;
+
+   assert(ft != NULL);
+   assert(callback != NULL);
+
+   /* a frozen copy lists itself, in a single pass over its entries */
+   Epoch_enter(ft->epoch);
+   frozen = FT_getFrozen(ft);
+   if(frozen != NULL) {
+      path = malloc(Frozen_getMaxPathLength(frozen) + 1);
+      if(path == NULL)
+         result = MEMORY_ERROR;
+      else
+         result = Frozen_map(frozen, path, callback, ctx);
+      free(path);
+   }
+   Epoch_leave(ft->epoch);
+   if(frozen != NULL)
+      return result;
+
+   FT_lock(ft, NULL, FALSE);
+   root = ft->root;
+   if(root != NULL) {
+      FT_lock(ft, root, FALSE);
+      result = FT_walk(ft, root, callback, ctx);
+      FT_unlock(ft, root);
+   }
+   FT_unlock(ft, NULL);
+
+   return result;
+}
+
+/*
+   Writes line to stream, the FILE* that ctx points to, followed by a
+   newline, for FT_write.
+   Returns SUCCESS, or EOF if there is a write error.
+*/
+static int FT_writeLine(const char* line, size_t length, void* ctx) {
+   FILE* stream = ctx;
+
+   assert(line != NULL);
+   assert(stream != NULL);
+
+   if(fwrite(line, 1, length, stream) != length ||
+      putc('\n', stream) == EOF)
+      return EOF;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_writeIn(FT_T ft, FILE* stream)
+{
+   assert(ft != NULL);
+   assert(stream != NULL);
+
+   return FT_forEachLineIn(ft, FT_writeLine, (void*) stream);
+}
+
+/* The number of characters for which a string being built by
+   FT_toString first has room. */
+enum { FT_STRING_MIN = 256 };
+
+/*
+   A string being built by FT_toString, which holds length characters
+   so far, in room for capacity.
+*/
+struct FT_string {
+   char* chars;
+   size_t length;
+   size_t capacity;
+};
+
+/*
+   Appends line and a newline to *pString, the struct FT_string that
+   ctx points to, doubling its room as often as it needs to, always
+   leaving room for a final '\0'. The listing is not measured
+   beforehand, since in a concurrent tree or a forest it may grow
+   between two passes. Returns SUCCESS, or MEMORY_ERROR if there is an
+   allocation error.
+*/
+static int FT_appendLine(const char* line, size_t length, void* ctx) {
+   struct FT_string* pString = ctx;
+   char* chars;
+   size_t capacity;
+
+   assert(line != NULL);
+   assert(pString != NULL);
+
+   capacity = pString->capacity;
+   while(capacity - pString->length < length + 2)
+      capacity *= 2;
+   if(capacity != pString->capacity) {
+      chars = realloc(pString->chars, capacity);
+      if(chars == NULL)
+         return MEMORY_ERROR;
+      pString->chars = chars;
+      pString->capacity = capacity;
+   }
+
+   memcpy(pString->chars + pString->length, line, length);
+   pString->length += length;
+   pString->chars[pString->length++] = '\n';
+   return SUCCESS;
+}
+
+/*
+   Calls (*callback)(line, length, ctx) for each line of the listing of
+   snapshot, if it is not NULL, or else of forest, if it is not NULL,
+   or else of ft.
+*/
+static int FT_forEachLineOf(FT_T ft, FT_Forest_T forest,
+                            FT_Snapshot_T snapshot,
+                            int (*callback)(const char* line,
+                                            size_t length, void* ctx),
+                            void* ctx) {
+   if(snapshot != NULL)
+      return FT_forEachLineInSnapshot(snapshot, callback, ctx);
+   if(forest != NULL)
+      return FT_forEachLineInForest(forest, callback, ctx);
+   return FT_forEachLineIn(ft, callback, ctx);
+}
+
+/*
+   Returns the listing of snapshot, if it is not NULL, or else of
+   forest, if it is not NULL, or else of ft, as a new string, or NULL
+   if there is an allocation error.
+*/
+static char *FT_buildString(FT_T ft, FT_Forest_T forest,
+                            FT_Snapshot_T snapshot) {
+   struct FT_string string;
+
+   /* copy the listing in as it goes, in a single pass */
+   string.chars = malloc(FT_STRING_MIN);
+   if(string.chars == NULL)
+      return NULL;
+   string.length = 0;
+   string.capacity = FT_STRING_MIN;
+
+   if(FT_forEachLineOf(ft, forest, snapshot, FT_appendLine,
+                       (void*) &string) != SUCCESS) {
+      free(string.chars);
+      return NULL;
+   }
+
+   string.chars[string.length] = '\0';
+   return string.chars;
+}
+
+/* see ft.h for specification */
+char *FT_toStringIn(FT_T ft)
+{
+   assert(ft != NULL);
+
+   return FT_buildString(ft, NULL, NULL);
+}
+
+/*
+   The changes that can be submitted to an FT_Queue_T.
+*/
+enum FT_operation {
+   FT_OP_INSERT_DIR, FT_OP_INSERT_FILE, FT_OP_RM_DIR, FT_OP_RM_FILE,
+   FT_OP_REPLACE_CONTENTS
+};
+
+/*
+   A change submitted to a queue, which lives on the stack of the
+   thread that submitted it until the applier has applied it.
+*/
+struct FT_request {
+   /* the change, with its arguments */
+   enum FT_operation operation;
+   const char* path;
+   void* contents;
+   size_t length;
+
+   /* the results: the status, or for FT_OP_REPLACE_CONTENTS, the old
+      contents, and whether the change has been applied */
+   int status;
+   void* oldContents;
+   boolean done;
+
+   /* the request submitted before this one, in the queue's pending
+      stack */
+   struct FT_request* next;
+};
+
+/*
+   A queue of changes to a tree, and the thread applying them.
+*/
+struct FT_queue {
+   /* the tree the changes are applied to */
+   FT_T ft;
+
+   /* the requests submitted since the applier last took them, most
+      recent first, which submitters push without locking */
+   struct FT_request* pending;
+
+   /* the mutex and conditions by which the applier waits for requests
+      and submitters wait for their requests to be applied */
+   pthread_mutex_t lock;
+   pthread_cond_t submitted;
+   pthread_cond_t applied;
+
+   /* TRUE once FT_freeQueue has asked the applier to stop */
+   boolean stopping;
+
+   /* the applier, and its array for sorting a batch of requests */
+   pthread_t applier;
+   struct FT_request** batch;
+   size_t batchSize;
+};
+
+/*
+   Compares the paths of the requests that pRequest1 and pRequest2
+   point to, as FT_comparePaths does, for sorting a batch.
+*/
+static int FT_compareRequests(const void* pRequest1,
+                              const void* pRequest2) {
+   assert(pRequest1 != NULL);
+   assert(pRequest2 != NULL);
+
+   return FT_comparePaths(
+             (*(struct FT_request* const*) pRequest1)->path,
+             (*(struct FT_request* const*) pRequest2)->path);
+}
+
+/*
+   Applies the requests of batch, a list linked through next, to
+   queue's tree. The requests are sorted by path first, if there is
+   memory to, so that each insertion into a tree without FT_CONCURRENT
+   can be reached from the one before, as in FT_insertMany. Concurrent
+   trees may have other writers, so there each request is applied on
+   its own, under the usual locks.
+*/
+static void FT_applyBatch(struct FT_queue* queue,
+                          struct FT_request* batch) {
+   FT_T ft;
+   struct FT_request* request;
+   struct FT_request** larger;
+   Node_T curr = NULL;
+   size_t currLength = 0;
+   const char* prev = NULL;
+   char* buffer = NULL;
+   size_t size = 0;
+   size_t n = 0;
+   size_t i;
+
+   assert(queue != NULL);
+
+   ft = queue->ft;
+   for(request = batch; request != NULL; request = request->next)
+      n++;
+   if(n > queue->batchSize) {
+      larger = realloc(queue->batch, n * sizeof(struct FT_request*));
+      if(larger != NULL) {
+         queue->batch = larger;
+         queue->batchSize = n;
+      }
+   }
+
+   /* the requests of a batch were all submitted concurrently, so
+      they may be applied in any order; without memory to sort them,
+      they are applied as they are stacked */
+   if(n <= queue->batchSize) {
+      i = 0;
+      for(request = batch; request != NULL; request = request->next)
+         queue->batch[i++] = request;
+      qsort(queue->batch, n, sizeof(struct FT_request*),
+            FT_compareRequests);
+   }
+
+   request = batch;
+   for(i = 0; i < n; i++) {
+      if(n <= queue->batchSize)
+         request = queue->batch[i];
+      else if(i > 0)
+         request = request->next;
+
+      switch(request->operation) {
+         case FT_OP_INSERT_DIR:
+         case FT_OP_INSERT_FILE:
+            if(ft->rootLock != NULL)
+               request->status =
+                  (request->operation == FT_OP_INSERT_DIR) ?
+                  FT_insertDirIn(ft, request->path) :
+                  FT_insertFileIn(ft, request->path,
+                                  request->contents, request->length);
+            else {
+               request->status =
+                  FT_insertNext(ft, request->path,
+                                (boolean) (request->operation ==
+                                           FT_OP_INSERT_FILE),
+                                request->contents, request->length,
+                                prev, &curr, &currLength, &buffer,
+                                &size);
+               if(request->status == SUCCESS)
+                  prev = request->path;
+            }
+            break;
+         case FT_OP_RM_DIR:
+            request->status = FT_rmDirIn(ft, request->path);
+            /* the directory reached last may be gone */
+            curr = NULL;
+            currLength = 0;
+            prev = NULL;
+            break;
+         case FT_OP_RM_FILE:
+            request->status = FT_rmFileIn(ft, request->path);
+            break;
+         case FT_OP_REPLACE_CONTENTS:
+            request->oldContents =
+               FT_replaceFileContentsIn(ft, request->path,
+                                        request->contents,
+                                        request->length);
+            request->status = SUCCESS;
+            break;
+      }
+   }
+
+   free(buffer);
+}
+
+/*
+   The applier thread of the queue pvQueue, which takes the pending
+   requests in batches, applies them, and wakes their submitters,
+   until FT_freeQueue asks it to stop and no requests remain.
+*/
+static void* FT_runQueue(void* pvQueue) {
+   struct FT_queue* queue = pvQueue;
+   struct FT_request* batch;
+   struct FT_request* request;
+
+   assert(queue != NULL);
+
+   for(;;) {
+      (void) pthread_mutex_lock(&queue->lock);
+      while(!queue->stopping &&
+            __atomic_load_n(&queue->pending, __ATOMIC_ACQUIRE) == NULL)
+         (void) pthread_cond_wait(&queue->submitted, &queue->lock);
+      (void) pthread_mutex_unlock(&queue->lock);
+
+      batch = __atomic_exchange_n(&queue->pending, NULL,
+                                  __ATOMIC_ACQUIRE);
+      if(batch == NULL)
+         break;
+
+      FT_applyBatch(queue, batch);
+
+      (void) pthread_mutex_lock(&queue->lock);
+      while(batch != NULL) {
+         request = batch;
+         batch = batch->next;
+         request->done = TRUE;
+      }
+      (void) pthread_cond_broadcast(&queue->applied);
+      (void) pthread_mutex_unlock(&queue->lock);
+   }
+   return NULL;
+}
+
+/*
+   Submits request to queue and waits for the applier to apply it.
+*/
+static void FT_submit(FT_Queue_T queue, struct FT_request* request) {
+   struct FT_request* head;
+
+   assert(queue != NULL);
+   assert(request != NULL);
+   assert(request->path != NULL);
+
+   request->status = SUCCESS;
+   request->oldContents = NULL;
+   request->done = FALSE;
+
+   head = __atomic_load_n(&queue->pending, __ATOMIC_RELAXED);
+   do
+      request->next = head;
+   while(!__atomic_compare_exchange_n(&queue->pending, &head, request,
+                                      TRUE, __ATOMIC_RELEASE,
+                                      __ATOMIC_RELAXED));
+
+   /* the applier only sleeps once the stack is empty */
+   (void) pthread_mutex_lock(&queue->lock);
+   if(head == NULL)
+      (void) pthread_cond_signal(&queue->submitted);
+   while(!request->done)
+      (void) pthread_cond_wait(&queue->applied, &queue->lock);
+   (void) pthread_mutex_unlock(&queue->lock);
+}
+
+/* see ft.h for specification */
+FT_Queue_T FT_newQueue(FT_T ft)
+{
+   struct FT_queue* queue;
+
+   assert(ft != NULL);
+
+   queue = malloc(sizeof(struct FT_queue));
+   if(queue == NULL)
+      return NULL;
+
+   queue->ft = ft;
+   queue->pending = NULL;
+   queue->stopping = FALSE;
+   queue->batch = NULL;
+   queue->batchSize = 0;
+
+   if(pthread_mutex_init(&queue->lock, NULL) != 0) {
+      free(queue);
+      return NULL;
+   }
+   if(pthread_cond_init(&queue->submitted, NULL) != 0) {
+      (void) pthread_mutex_destroy(&queue->lock);
+      free(queue);
+      return NULL;
+   }
+   if(pthread_cond_init(&queue->applied, NULL) != 0) {
+      (void) pthread_cond_destroy(&queue->submitted);
+      (void) pthread_mutex_destroy(&queue->lock);
+      free(queue);
+      return NULL;
+   }
+   if(pthread_create(&queue->applier, NULL, FT_runQueue, queue) != 0) {
+      (void) pthread_cond_destroy(&queue->applied);
+      (void) pthread_cond_destroy(&queue->submitted);
+      (void) pthread_mutex_destroy(&queue->lock);
+      free(queue);
+      return NULL;
+   }
+
+   return queue;
+}
+
+/* see ft.h for specification */
+void FT_freeQueue(FT_Queue_T queue)
+{
+   if(queue == NULL)
+      return;
+
+   (void) pthread_mutex_lock(&queue->lock);
+   queue->stopping = TRUE;
+   (void) pthread_cond_signal(&queue->submitted);
+   (void) pthread_mutex_unlock(&queue->lock);
+   (void) pthread_join(queue->applier, NULL);
+
+   (void) pthread_cond_destroy(&queue->applied);
+   (void) pthread_cond_destroy(&queue->submitted);
+   (void) pthread_mutex_destroy(&queue->lock);
+   free(queue->batch);
+   free(queue);
+}
+
+/* see ft.h for specification */
+int FT_queueInsertDir(FT_Queue_T queue, const char *path)
+{
+   struct FT_request request;
+
+   request.operation = FT_OP_INSERT_DIR;
+   request.path = path;
+   request.contents = NULL;
+   request.length = 0;
+   FT_submit(queue, &request);
+   return request.status;
+}
+
+/* see ft.h for specification */
+int FT_queueInsertFile(FT_Queue_T queue, const char *path,
+                       void *contents, size_t length)
+{
+   struct FT_request request;
+
+   request.operation = FT_OP_INSERT_FILE;
+   request.path = path;
+   request.contents = contents;
+   request.length = length;
+   FT_submit(queue, &request);
+   return request.status;
+}
+
+/* see ft.h for specification */
+int FT_queueRmDir(FT_Queue_T queue, const char *path)
+{
+   struct FT_request request;
+
+   request.operation = FT_OP_RM_DIR;
+   request.path = path;
+   request.contents = NULL;
+   request.length = 0;
+   FT_submit(queue, &request);
+   return request.status;
+}
+
+/* see ft.h for specification */
+int FT_queueRmFile(FT_Queue_T queue, const char *path)
+{
+   struct FT_request request;
+
+   request.operation = FT_OP_RM_FILE;
+   request.path = path;
+   request.contents = NULL;
+   request.length = 0;
+   FT_submit(queue, &request);
+   return request.status;
+}
+
+/* see ft.h for specification */
+void *FT_queueReplaceFileContents(FT_Queue_T queue, const char *path,
+                                  void *newContents, size_t newLength)
+{
+   struct FT_request request;
+
+   request.operation = FT_OP_REPLACE_CONTENTS;
+   request.path = path;
+   request.contents = newContents;
+   request.length = newLength;
+   FT_submit(queue, &request);
+   return request.oldContents;
+}
+
+/*
+   Pins thread to processor cpu, modulo the number of processors
+   online, where the system allows it. Pinning only improves locality,
+   so it is not an error for it to fail.
+*/
+static void FT_pinThread(pthread_t thread, size_t cpu) {
+#ifdef __linux__
+   cpu_set_t set;
+   long online;
+
+   online = sysconf(_SC_NPROCESSORS_ONLN);
+   if(online <= 0)
+      return;
+   CPU_ZERO(&set);
+   CPU_SET((int) (cpu % (size_t) online), &set);
+   (void) pthread_setaffinity_np(thread, sizeof(cpu_set_t), &set);
+#else
+   (void) thread;
+   (void) cpu;
+#endif
+}
+
+/*
+   One shard of a forest.
+*/
+struct FT_shard {
+   /* the shard's tree, whose root is hidden: it has an empty name,
+      and the roots of the forest held by the shard are its children,
+      so that the forest's path p is the tree's path "/p" */
+   FT_T tree;
+
+   /* the queue of the shard's worker, or NULL if it has none */
+   FT_Queue_T queue;
+};
+
+/*
+   A forest: its shards, which never change once it is created.
+*/
+struct FT_forest {
+   size_t count;
+   struct FT_shard* shards;
+};
+
+/* The number of characters of a shard path that fit on the stack. */
+enum { FT_SHARD_PATH_SIZE = 256 };
+
+/*
+   Returns the shard of forest that holds path, as a hash of its first
+   component, through *pShard, and returns path as that shard's tree
+   knows it: a slash and then path. The result is written into buffer,
+   which holds FT_SHARD_PATH_SIZE characters, if it fits, and otherwise
+   into new memory, which FT_freeShardPath frees. Returns NULL if
+   unable to allocate it.
+*/
+static char* FT_shardPath(FT_Forest_T forest, const char* path,
+                          char* buffer, struct FT_shard** pShard) {
+   size_t length;
+   char* shardPath = buffer;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+   assert(buffer != NULL);
+   assert(pShard != NULL);
+
+   *pShard = &forest->shards[Hash_key(path) % forest->count];
+
+   length = strlen(path);
+   if(length + 2 > FT_SHARD_PATH_SIZE) {
+      shardPath = malloc(length + 2);
+      if(shardPath == NULL)
+         return NULL;
+   }
+   shardPath[0] = '/';
+   memcpy(shardPath + 1, path, length + 1);
+   return shardPath;
+}
+
+/*
+   Frees shardPath, a result of FT_shardPath given buffer, if it was
+   allocated.
+*/
+static void FT_freeShardPath(char* shardPath, char* buffer) {
+   if(shardPath != buffer)
+      free(shardPath);
+}
+
+/* see ft.h for specification */
+FT_Forest_T FT_newForest(size_t shards, unsigned int options)
+{
+   struct FT_forest* forest;
+   struct FT_shard* shard;
+   size_t i;
+
+   if(shards == 0)
+      return NULL;
+
+   forest = malloc(sizeof(struct FT_forest));
+   if(forest == NULL)
+      return NULL;
+   forest->shards = calloc(shards, sizeof(struct FT_shard));
+   if(forest->shards == NULL) {
+      free(forest);
+      return NULL;
+   }
+   forest->count = shards;
+
+   for(i = 0; i < shards; i++) {
+      shard = &forest->shards[i];
+      shard->tree = FT_new((options & ~(unsigned int) FT_WORKERS) |
+                           FT_CONCURRENT);
+      if(shard->tree == NULL ||
+         FT_insertDirIn(shard->tree, "") != SUCCESS) {
+         FT_freeForest(forest);
+         return NULL;
+      }
+      if(options & FT_WORKERS) {
+         shard->queue = FT_newQueue(shard->tree);
+         if(shard->queue == NULL) {
+            FT_freeForest(forest);
+            return NULL;
+         }
+         FT_pinThread(shard->queue->applier, i);
+      }
+   }
+
+   return forest;
+}
+
+/* see ft.h for specification */
+void FT_freeForest(FT_Forest_T forest)
+{
+   size_t i;
+
+   if(forest == NULL)
+      return;
+
+   for(i = 0; i < forest->count; i++) {
+      FT_freeQueue(forest->shards[i].queue);
+      FT_free(forest->shards[i].tree);
+   }
+   free(forest->shards);
+   free(forest);
+}
+
+/* see ft.h for specification */
+int FT_insertDirInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   int result;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return MEMORY_ERROR;
+
+   if(shard->queue != NULL)
+      result = FT_queueInsertDir(shard->queue, shardPath);
+   else
+      result = FT_insertDirIn(shard->tree, shardPath);
+
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsDirInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   boolean result;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return FALSE;
+
+   result = FT_containsDirIn(shard->tree, shardPath);
+
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmDirInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   int result;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return MEMORY_ERROR;
+
+   if(shard->queue != NULL)
+      result = FT_queueRmDir(shard->queue, shardPath);
+   else
+      result = FT_rmDirIn(shard->tree, shardPath);
+
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_insertFileInForest(FT_Forest_T forest, const char *path,
+                          void *contents, size_t length)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   int result;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+
+   /* a root must be a directory */
+   if(strchr(path, '/') == NULL)
+      return CONFLICTING_PATH;
+
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return MEMORY_ERROR;
+
+   if(shard->queue != NULL)
+      result = FT_queueInsertFile(shard->queue, shardPath, contents,
+                                  length);
+   else
+      result = FT_insertFileIn(shard->tree, shardPath, contents,
+                               length);
+
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsFileInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   boolean result;
+
+   assert(forest != NULL);
+   assert(path != NULL);
+
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return FALSE;
+
+   result = FT_containsFileIn(shard->tree, shardPath);
 
-   Otherwise, returns SUCCESS
-*/
-static int FT_insertRestOfPath(char* path, Node_T parent) {
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
 
-   Node_T curr = parent;
-   Node_T firstNew = NULL;
-   Node_T new;
-   char* copyPath;
-   char* restPath = path;
-   char* dirToken;
+/* see ft.h for specification */
+int FT_rmFileInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
    int result;
-   size_t newCount = 0;
 
+   assert(forest != NULL);
    assert(path != NULL);
 
-   /* if root is not NULL, curr must be a descendent of root */
-   if(curr == NULL) {
-      if(root != NULL) {
-         return CONFLICTING_PATH;
-      }
-   }
-   /* if paths match, the target already exists */
-   else {
-      if(!strcmp(path, Node_getPath(curr)))
-         return ALREADY_IN_TREE;
-
-      restPath += (strlen(Node_getPath(curr)) + 1);
-   }
-
-   /* create a copy of the path to tokenize */
-   copyPath = malloc(strlen(restPath)+1);
-   if(copyPath == NULL)
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
       return MEMORY_ERROR;
-   strcpy(copyPath, restPath);
-   dirToken = strtok(copyPath, "/");
 
-   /* iterate through, create, and link subsequent directories from 
-      current until the full path is reached. If an error occurs, 
-      revert back to the initial file tree */
-   while(dirToken != NULL) {
-      new = Node_create(dirToken, curr);
+   if(shard->queue != NULL)
+      result = FT_queueRmFile(shard->queue, shardPath);
+   else
+      result = FT_rmFileIn(shard->tree, shardPath);
 
-      if(new == NULL) {
-         if(firstNew != NULL)
-            (void) Node_destroy(firstNew);
-         free(copyPath);
-         return MEMORY_ERROR;
-      }
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
 
-      newCount++;
+/* see ft.h for specification */
+void *FT_getFileContentsInForest(FT_Forest_T forest, const char *path)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   void* contents;
 
-      /* link new nodes to each other, but not to parent in case
-         of any error */
-      if(firstNew == NULL)
-         firstNew = new;
-      else {
-         if((result = Node_linkChild(curr, new)) != SUCCESS) {
-            (void) Node_destroy(new);
-            (void) Node_destroy(firstNew);
-            return result;
-         }
-      }
+   assert(forest != NULL);
+   assert(path != NULL);
 
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return NULL;
 
-      curr = new;
-      dirToken = strtok(NULL, "/");
-   }
+   contents = FT_getFileContentsIn(shard->tree, shardPath);
 
-   free(copyPath);
+   FT_freeShardPath(shardPath, buffer);
+   return contents;
+}
 
-   count += newCount;
+/* see ft.h for specification */
+void *FT_replaceFileContentsInForest(FT_Forest_T forest,
+                                     const char *path,
+                                     void *newContents,
+                                     size_t newLength)
+{
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
+   void* oldContents;
 
-   if(parent == NULL) {
-      root = firstNew;
-      return SUCCESS;
-   }
+   assert(forest != NULL);
+   assert(path != NULL);
 
-   /* connect the extended path to the parent node */
-   if((result = Node_linkChild(parent, firstNew)) != SUCCESS)
-      (void) Node_destroy(firstNew);
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return NULL;
 
+   if(shard->queue != NULL)
+      oldContents = FT_queueReplaceFileContents(shard->queue, shardPath,
+                                                newContents, newLength);
+   else
+      oldContents = FT_replaceFileContentsIn(shard->tree, shardPath,
+                                             newContents, newLength);
 
-   return result;
+   FT_freeShardPath(shardPath, buffer);
+   return oldContents;
 }
 
 /* see ft.h for specification */
-int FT_insertDir(char *path)
+int FT_statInForest(FT_Forest_T forest, const char *path,
+                    boolean *type, size_t *length)
 {
-   Node_T curr;
+   struct FT_shard* shard;
+   char buffer[FT_SHARD_PATH_SIZE];
+   char* shardPath;
    int result;
-   boolean isFile = FALSE;
-   boolean foundFullPath = FALSE;
 
+   assert(forest != NULL);
    assert(path != NULL);
 
-   if(!isInitialized)
-      return INITIALIZATION_ERROR;
-   curr = FT_traversePath(path, root, &isFile, &foundFullPath);
-   if(foundFullPath) {
-            return ALREADY_IN_TREE;
-   }
+   shardPath = FT_shardPath(forest, path, buffer, &shard);
+   if(shardPath == NULL)
+      return MEMORY_ERROR;
+
+   result = FT_statIn(shard->tree, shardPath, type, length);
+
+   FT_freeShardPath(shardPath, buffer);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_forEachLineInForest(FT_Forest_T forest,
+                           int (*callback)(const char* line,
+                                           size_t length, void* ctx),
+                           void* ctx)
+{
+   FT_T tree;
+   Node_T root;
+   Node_T best;
+   size_t* next;
+   size_t i, b = 0;
+   int result = SUCCESS;
+
+   assert(forest != NULL);
+   assert(callback != NULL);
+
+   next = calloc(forest->count, sizeof(size_t));
+   if(next == NULL)
+      return MEMORY_ERROR;
 
-   if (isFile) {  
-         return NOT_A_DIRECTORY;
+   /* hold every hidden root shared, so that the roots beneath them
+      stay put while they are merged in order of name */
+   for(i = 0; i < forest->count; i++) {
+      tree = forest->shards[i].tree;
+      FT_lock(tree, NULL, FALSE);
+      FT_lock(tree, tree->root, FALSE);
    }
 
-   if (curr == NULL) {
-      if (root != NULL) {
-         return CONFLICTING_PATH;
+   while(result == SUCCESS) {
+      best = NULL;
+      for(i = 0; i < forest->count; i++) {
+         root = Node_getDirChild(forest->shards[i].tree->root, next[i]);
+         if(root != NULL && (best == NULL ||
+                             Node_compare(root, best) < 0)) {
+            best = root;
+            b = i;
+         }
       }
+      if(best == NULL)
+         break;
+
+      next[b]++;
+      tree = forest->shards[b].tree;
+      FT_lock(tree, best, FALSE);
+      result = FT_walk(tree, best, callback, ctx);
+      FT_unlock(tree, best);
    }
 
-   result = FT_insertRestOfPath(path, curr);
-
+   for(i = 0; i < forest->count; i++) {
+      tree = forest->shards[i].tree;
+      FT_unlock(tree, tree->root);
+      FT_unlock(tree, NULL);
+   }
+   free(next);
    return result;
 }
 
 /* see ft.h for specification */
-boolean FT_containsDir(char *path)  
+int FT_writeInForest(FT_Forest_T forest, FILE* stream)
 {
-   Node_T curr;
-   boolean isFile = FALSE;
-   boolean foundFullPath = FALSE;
+   assert(forest != NULL);
+   assert(stream != NULL);
 
-   assert(path != NULL);
+   return FT_forEachLineInForest(forest, FT_writeLine, (void*) stream);
+}
 
-   if(!isInitialized)
-      return FALSE;
+/* see ft.h for specification */
+char *FT_toStringInForest(FT_Forest_T forest)
+{
+   assert(forest != NULL);
 
-   curr = FT_traversePath(path, root, &isFile, &foundFullPath);
+   return FT_buildString(NULL, forest, NULL);
+}
 
+/*
+   A snapshot of a tree's hierarchy.
+*/
+struct FT_snapshot {
+   /* the record of the hierarchy */
+   Snapshot_T shape;
+};
 
-   if(curr == NULL || isFile) {
+/*
+   Adds root and everything beneath it to shape, level by level: each
+   directory's files, in order of name, and then its subdirectories,
+   after the children of the directories before it. The directories
+   whose children are still to be added wait in queue.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean FT_snapshotFrom(Snapshot_T shape, Node_T root,
+                               DynArray_T queue) {
+   Node_T n, child;
+   File_T f;
+   size_t i, c;
+
+   assert(shape != NULL);
+   assert(root != NULL);
+   assert(queue != NULL);
+
+   if(!Snapshot_add(shape, Node_getName(root), FALSE, 0,
+                    Node_getNumChildren(root)) ||
+      !DynArray_add(queue, root))
       return FALSE;
-   }
 
-   if(!foundFullPath)
-      return FALSE;
-   
+   for(i = 0; i < DynArray_getLength(queue); i++) {
+      n = DynArray_get(queue, i);
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         f = Node_getFileChild(n, c);
+         if(f != NULL && !Snapshot_add(shape, File_getName(f), TRUE,
+                                       File_getContentLength(f), 0))
+            return FALSE;
+      }
+      for(c = 0; c < Node_getNumChildren(n); c++) {
+         child = Node_getDirChild(n, c);
+         if(child != NULL &&
+            (!Snapshot_add(shape, Node_getName(child), FALSE, 0,
+                           Node_getNumChildren(child)) ||
+             !DynArray_add(queue, child)))
+            return FALSE;
+      }
+   }
    return TRUE;
 }
 
 /* see ft.h for specification */
-int FT_rmDir(char *path)
+FT_Snapshot_T FT_newSnapshot(FT_T ft)
 {
-    Node_T curr, parent;
-    boolean isFile = FALSE;
-    boolean foundFullPath = FALSE;
-
-    assert(path != NULL);
-   
+   FT_Snapshot_T snapshot;
+   DynArray_T queue;
+   boolean built;
 
-    if(!isInitialized)
-      return INITIALIZATION_ERROR;
+   assert(ft != NULL);
 
-    curr = FT_traversePath(path, root, &isFile, &foundFullPath);
+   snapshot = malloc(sizeof(struct FT_snapshot));
+   if(snapshot == NULL)
+      return NULL;
+   snapshot->shape = Snapshot_new();
+   queue = DynArray_new(0);
+   built = snapshot->shape != NULL && queue != NULL &&
+      (ft->root == NULL ||
+       FT_snapshotFrom(snapshot->shape, ft->root, queue)) &&
+      Snapshot_finish(snapshot->shape);
+   if(queue != NULL)
+      DynArray_free(queue);
+
+   if(!built) {
+      FT_freeSnapshot(snapshot);
+      return NULL;
+   }
+   return snapshot;
+}
 
-    if(isFile && foundFullPath) {
-          return NOT_A_DIRECTORY;
-    }
+/* see ft.h for specification */
+void FT_freeSnapshot(FT_Snapshot_T snapshot)
+{
+   if(snapshot == NULL)
+      return;
 
-    if(curr == NULL || isFile) {
-       return NO_SUCH_PATH;
-    }
-      
+   Snapshot_free(snapshot->shape);
+   free(snapshot);
+}
 
-    if(!strcmp(path,Node_getPath(curr))) {
-      parent = Node_getParent(curr);
-      if(parent == NULL)
-         root = NULL;
-      else {
-         Node_unlinkChild(parent, curr);
-      }
+/*
+   Looks up path in snapshot, as FT_findFile does in a live hierarchy,
+   except that for a file it stores the length of its contents in
+   *pLength.
+*/
+static int FT_findSnapshot(FT_Snapshot_T snapshot, const char* path,
+                           size_t* pLength) {
+   size_t entry;
 
-      count -= Node_destroy(curr);
-      return SUCCESS;
-   }
+   assert(snapshot != NULL);
+   assert(path != NULL);
+   assert(pLength != NULL);
 
-   return NO_SUCH_PATH;
+   if(!Snapshot_find(snapshot->shape, path, &entry))
+      return NO_SUCH_PATH;
+   if(!Snapshot_isFile(snapshot->shape, entry))
+      return NOT_A_FILE;
+   *pLength = Snapshot_getLength(snapshot->shape, entry);
+   return SUCCESS;
 }
 
 /* see ft.h for specification */
-int FT_insertFile(char *path, void *contents, size_t length)
+boolean FT_containsDirInSnapshot(FT_Snapshot_T snapshot,
+                                 const char *path)
 {
-    File_T file;
-    Node_T current;
-    char *lastOccurance;
-    char *parentPath;
-    int result;
-    int exists;
-    boolean isFile = FALSE;
-    boolean foundFullPath = FALSE;
-
-    assert(path != NULL);
-    
-    if(!isInitialized)
-      return INITIALIZATION_ERROR;
-
-    /* create a truncated copy of path that represents the parent */
-    lastOccurance = strrchr(path, '/');
+   size_t length;
 
-    if (lastOccurance == NULL) {
-       return CONFLICTING_PATH;
-    }
-
-    parentPath = calloc((size_t)(lastOccurance - path + 1), 1);
+   assert(snapshot != NULL);
+   assert(path != NULL);
 
-    if (parentPath == NULL) {
-       return MEMORY_ERROR;
-    }
+   return (boolean) (FT_findSnapshot(snapshot, path, &length)
+                     == NOT_A_FILE);
+}
 
-    strncpy(parentPath, path, (size_t)(lastOccurance - path));
+/* see ft.h for specification */
+boolean FT_containsFileInSnapshot(FT_Snapshot_T snapshot,
+                                  const char *path)
+{
+   size_t length;
 
-    /* search for the parent directory of the target file */
-    current = FT_traversePath(parentPath, root,
-                              &isFile, &foundFullPath);
+   assert(snapshot != NULL);
+   assert(path != NULL);
 
-    /* the path terminates at a prefix file */
-    if(isFile) {
-       free(parentPath);
-       return NOT_A_DIRECTORY;
-    }
+   return (boolean) (FT_findSnapshot(snapshot, path, &length)
+                     == SUCCESS);
+}
 
-    /* if the full parent path doesn't exist, insert it and continue
-       traversing down to the parent directory once created */
-    if(!foundFullPath) {
-       result = FT_insertRestOfPath(parentPath, current);
-       if (result != SUCCESS) {
-          free(parentPath);
-          return result;
-       }
-       current = FT_traversePath(parentPath, current, &isFile,
-                                 &foundFullPath);
-    }
+/* see ft.h for specification */
+int FT_statInSnapshot(FT_Snapshot_T snapshot, const char *path,
+                      boolean *type, size_t *length)
+{
+   size_t fileLength = 0;
+   int result;
 
-    free(parentPath);
+   assert(snapshot != NULL);
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
 
-    /* check if the parent directory already has a child with path */
-    exists = (Node_hasFileChild(current, path, NULL) ||
-              Node_hasDirChild(current, path, NULL));
+   result = FT_findSnapshot(snapshot, path, &fileLength);
+   if(result == NOT_A_FILE) {
+      *type = FALSE;
+      result = SUCCESS;
+   }
+   else if(result == SUCCESS) {
+      *type = TRUE;
+      *length = fileLength;
+   }
+   return result;
+}
 
-    if (exists) {
-       return ALREADY_IN_TREE;
-    }
+/* see ft.h for specification */
+int FT_forEachLineInSnapshot(FT_Snapshot_T snapshot,
+                             int (*callback)(const char* line,
+                                             size_t length,
+                                             void* ctx),
+                             void* ctx)
+{
+   char* path;
+   int result;
 
-    file = File_create(++lastOccurance, current, contents, length);
+   assert(snapshot != NULL);
+   assert(callback != NULL);
 
-    if(file == NULL) {
-       return MEMORY_ERROR;
-    }
+   path = malloc(Snapshot_getBufferLength(snapshot->shape));
+   if(path == NULL)
+      return MEMORY_ERROR;
+   result = Snapshot_map(snapshot->shape, path, callback, ctx);
+   free(path);
+   return result;
+}
 
-    result = File_linkChild(current, file);
+/* see ft.h for specification */
+int FT_writeInSnapshot(FT_Snapshot_T snapshot, FILE* stream)
+{
+   assert(snapshot != NULL);
+   assert(stream != NULL);
 
-    if (result == SUCCESS)
-       count++;
-    return result;
+   return FT_forEachLineInSnapshot(snapshot, FT_writeLine,
+                                   (void*) stream);
 }
 
 /* see ft.h for specification */
-boolean FT_containsFile(char *path)
+char *FT_toStringInSnapshot(FT_Snapshot_T snapshot)
 {
-    Node_T parent;
-    boolean result;
-    boolean isFile = FALSE;
-    boolean foundFullPath = FALSE;
+   assert(snapshot != NULL);
 
-    assert(path != NULL);
+   return FT_buildString(NULL, NULL, snapshot);
+}
 
-    if(!isInitialized)
-      return FALSE;
-  
-    parent = FT_traversePath(path, root, &isFile, &foundFullPath);
+/* see ft.h for specification */
+int FT_init(void)
+{
+   return FT_initWithOptions(0);
+}
 
-    if (parent == NULL || !foundFullPath || !isFile) {
-      return FALSE;
-    }
+/* see ft.h for specification */
+int FT_initWithOptions(unsigned int options)
+{
+   if(defaultTree != NULL)
+      return INITIALIZATION_ERROR;
 
-    result = Node_hasFileChild(parent, path, NULL);
-    if (result) {
-       return TRUE;
-    }
+   defaultTree = FT_new(options);
+   if(defaultTree == NULL)
+      return MEMORY_ERROR;
 
-    return FALSE;
+   return SUCCESS;
 }
 
 /* see ft.h for specification */
-int FT_rmFile(char *path)
+int FT_destroy(void)
 {
-    File_T curr;
-    Node_T parent;
-    int result;
-    boolean isFile = FALSE;
-    size_t childID = 0;
-    boolean foundFullPath = FALSE;
-
-    assert(path != NULL);
-   
-
-    if(!isInitialized)
+   if(defaultTree == NULL)
       return INITIALIZATION_ERROR;
-  
-    parent = FT_traversePath(path, root, &isFile, &foundFullPath);
 
-    if (parent == NULL || !foundFullPath) {
-        return NO_SUCH_PATH;
-    }
-    if (!isFile)
-       return NOT_A_FILE;
-
-    result = Node_hasFileChild(parent, path, &childID);
-    if (result) {
-       curr = Node_getFileChild(parent, childID);
-       File_unlinkChild(parent, curr);
-       File_destroy(curr);
+   FT_free(defaultTree);
+   defaultTree = NULL;
+   return SUCCESS;
+}
 
-        count--;
-        return SUCCESS;
-     }
-     if (result == -1) {
-        return MEMORY_ERROR;
-     }
+/* see ft.h for specification */
+int FT_setFreeBudget(size_t budget)
+{
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-    return NO_SUCH_PATH;
+   FT_setFreeBudgetIn(defaultTree, budget);
+   return SUCCESS;
 }
 
 /* see ft.h for specification */
-void *FT_getFileContents(char *path)
+void FT_setFanOutThreshold(size_t threshold)
 {
-    File_T curr;
-    Node_T parent;
-    int result;
-    boolean isFile = FALSE;
-    size_t childID = 0;
-    boolean foundFullPath = FALSE;
+   __atomic_store_n(&fanOutThreshold, threshold, __ATOMIC_RELAXED);
+}
 
-    assert(path != NULL);
-   
+/* see ft.h for specification */
+void FT_setFanOutOrdered(boolean ordered)
+{
+   __atomic_store_n(&fanOutOrdered, ordered, __ATOMIC_RELAXED);
+}
 
-    if(!isInitialized)
-      return NULL;
-  
-    parent = FT_traversePath(path, root, &isFile, &foundFullPath);
+/* see ft.h for specification */
+int FT_compact(void)
+{
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-    if (parent == NULL || !foundFullPath || !isFile) {
-        return NULL;
-    }
+   return FT_compactIn(defaultTree);
+}
 
-    result = Node_hasFileChild(parent, path, &childID);
-    if (result) {
-       curr = Node_getFileChild(parent, childID);
-       return File_getContents(curr);
-    }
+/* see ft.h for specification */
+int FT_freeze(void)
+{
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-    return NULL;
+   return FT_freezeIn(defaultTree);
 }
 
 /* see ft.h for specification */
-void *FT_replaceFileContents(char *path, void *newContents,
-                             size_t newLength)
+int FT_insertDir(char *path)
 {
-   File_T curr;
-    Node_T parent;
-    int result;
-    boolean isFile = FALSE;
-    size_t childID = 0;
-    boolean foundFullPath = FALSE;
+   assert(path != NULL);
 
-    assert(path != NULL);
-   
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-    if(!isInitialized)
-      return NULL;
-   
-    parent = FT_traversePath(path, root, &isFile, &foundFullPath);
+   return FT_insertDirIn(defaultTree, path);
+}
 
-    if (parent == NULL || !foundFullPath || !isFile) {
-       return NULL;
-    }
+/* see ft.h for specification */
+boolean FT_containsDir(char *path)
+{
+   assert(path != NULL);
 
-    result = Node_hasFileChild(parent, path, &childID);
-    if (result) {
-       curr = Node_getFileChild(parent, childID);
-       return File_replaceContents(curr, newContents, newLength);
-    }
+   if(defaultTree == NULL)
+      return FALSE;
 
-    return NULL;
+   return FT_containsDirIn(defaultTree, path);
 }
 
 /* see ft.h for specification */
-int FT_stat(char *path, boolean *type, size_t *length)
+int FT_rmDir(char *path)
 {
-    Node_T curr;
-    File_T file;
-    int result;
-    boolean isFile = FALSE;
-    size_t childID = 0;
-    boolean foundFullPath = FALSE;
-
-    assert(path != NULL);
-    assert(type != NULL);
-    assert(length != NULL);
-    
-    if(!isInitialized)
+   assert(path != NULL);
+
+   if(defaultTree == NULL)
       return INITIALIZATION_ERROR;
 
-     
-    curr = FT_traversePath(path, root, &isFile, &foundFullPath);
+   return FT_rmDirIn(defaultTree, path);
+}
 
-    if (!foundFullPath) {
-        return NO_SUCH_PATH;
-    }
+/* see ft.h for specification */
+int FT_insertFile(char *path, void *contents, size_t length)
+{
+   assert(path != NULL);
 
-    if (!strcmp(path, Node_getPath(curr))) {
-       *type = FALSE;
-       return SUCCESS;
-    }
-    else {
-       result = Node_hasFileChild(curr, path, &childID);
-       if (result) {
-          file = Node_getFileChild(curr, childID);
-          *type = TRUE;
-          *length = File_getContentLength(file);
-          return SUCCESS;
-       }
-       if (result == -1)
-          return MEMORY_ERROR;
-    }
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-    return NO_SUCH_PATH;
+   return FT_insertFileIn(defaultTree, path, contents, length);
 }
 
 /* see ft.h for specification */
-int FT_init(void)
+int FT_insertMany(char **paths, void **contents, size_t *lengths,
+                  size_t n)
 {
-   if(isInitialized)
+   if(defaultTree == NULL)
       return INITIALIZATION_ERROR;
-   isInitialized = 1;
-   root = NULL;
-   count = 0;
-   return SUCCESS;
+
+   return FT_insertManyIn(defaultTree, paths, contents, lengths, n);
 }
 
 /* see ft.h for specification */
-int FT_destroy(void)
+boolean FT_containsFile(char *path)
 {
-   if(!isInitialized)
-      return INITIALIZATION_ERROR;
-
-   if (root != NULL) {
-       count -= Node_destroy(root);
-   }
+   assert(path != NULL);
 
-   root = NULL;
-   isInitialized = 0;
-   return SUCCESS;
+   if(defaultTree == NULL)
+      return FALSE;
 
+   return FT_containsFileIn(defaultTree, path);
 }
 
-/*
-   Performs a pre-order traversal of the tree rooted at n,
-   inserting each payload to DynArray_T d beginning at index i.
-   Returns the next unused index in d after the insertion(s).
-*/
-static size_t FT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
-   size_t c;
+/* see ft.h for specification */
+int FT_rmFile(char *path)
+{
+   assert(path != NULL);
 
-   assert(d != NULL);
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-   if(n != NULL) {
-      (void) DynArray_set(d, i++, Node_getPath(n));
-      for(c = 0; c < Node_getNumChildren(n, TRUE); c++) {
-         (void) DynArray_set(d, i++,
-                             File_getPath(Node_getFileChild(n, c)));
-      }
-      for(c = 0; c < Node_getNumChildren(n, FALSE); c++) {
-         i = FT_preOrderTraversal(Node_getDirChild(n, c), d, i);
-      }
-   }
+   return FT_rmFileIn(defaultTree, path);
+}
+
+/* see ft.h for specification */
+void *FT_getFileContents(char *path)
+{
+   assert(path != NULL);
+
+   if(defaultTree == NULL)
+      return NULL;
 
-   return i;
+   return FT_getFileContentsIn(defaultTree, path);
 }
 
-/*
-   Alternate version of strlen that uses pAcc as an in-out parameter
-   to accumulate a string length, rather than returning the length of
-   str, and also always adds one more in addition to str's length.
-*/
-static void FT_strlenAccumulate(char* str, size_t* pAcc) {
-   assert(str != NULL);
-   assert(pAcc != NULL);
+/* see ft.h for specification */
+void *FT_replaceFileContents(char *path, void *newContents,
+                             size_t newLength)
+{
+   assert(path != NULL);
+
+   if(defaultTree == NULL)
+      return NULL;
 
-   if(str != NULL)
-      *pAcc += (strlen(str) + 1);
+   return FT_replaceFileContentsIn(defaultTree, path, newContents,
+                                   newLength);
 }
 
+/* see ft.h for specification */
+int FT_stat(char *path, boolean *type, size_t *length)
+{
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
 
-/*
-   Alternate version of strcat that inverts the typical argument
-   order, appending str onto acc, and also always adds a newline at
-   the end of the concatenated string.
-*/
-static void FT_strcatAccumulate(char* str, char* acc) {
-   assert(str != NULL);
-   assert(acc != NULL);
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-   if(str != NULL)
-      strcat(acc, str); strcat(acc, "\n");
+   return FT_statIn(defaultTree, path, type, length);
 }
 
 /* see ft.h for specification */
-char *FT_toString(void)
+int FT_forEachLine(int (*callback)(const char* line, size_t length,
+                                   void* ctx),
+                   void* ctx)
 {
-   DynArray_T nodes;
-   size_t totalStrlen = 1;
-   char* result = NULL;
+   assert(callback != NULL);
 
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-   if(!isInitialized)
-      return NULL;
+   return FT_forEachLineIn(defaultTree, callback, ctx);
+}
 
-   nodes = DynArray_new(count);
-   if (nodes == NULL) {
-      return NULL;
-   }
+/* see ft.h for specification */
+int FT_write(FILE* stream)
+{
+   assert(stream != NULL);
 
-   (void) FT_preOrderTraversal(root, nodes, 0);
+   if(defaultTree == NULL)
+      return INITIALIZATION_ERROR;
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strlenAccumulate,
-                (void*) &totalStrlen);
+   return FT_writeIn(defaultTree, stream);
+}
 
-   result = malloc(totalStrlen);
-   if(result == NULL) {
-      DynArray_free(nodes);
+/* see ft.h for specification */
+char *FT_toString(void)
+{
+   if(defaultTree == NULL)
       return NULL;
-   }
-   *result = '\0';
 
-   DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate,
-                (void *) result);
-
-   DynArray_free(nodes);
-   return result;
+   return FT_toStringIn(defaultTree);
 }
@@ -13,8 +13,19 @@
 */
 
 #include <stddef.h>
+#include <stdio.h>
 #include "a4def.h"
 
+/*
+  The FT_* functions below operate on a single File Tree that belongs
+  to the module, which must first be put in an initialized state with
+  FT_init. Each of them has an FT_*In counterpart that operates instead
+  on a File Tree given by an FT_T handle, so that a program can hold
+  any number of independent trees. The counterparts are declared at
+  the end of this file.
+*/
+typedef struct FT *FT_T;
+
 /*
    Inserts a new directory into the tree at path, if possible.
    Returns SUCCESS if the new directory is inserted.
@@ -39,6 +50,9 @@ boolean FT_containsDir(char *path);
   Returns INITIALIZATION_ERROR if not in an initialized state.
   Returns NOT_A_DIRECTORY if path exists but is a file not a directory.
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
+  Returns MEMORY_ERROR, in a tree with FT_CONCURRENT, if unable to
+  allocate the copy of the parent's children without the directory,
+  in which case nothing is removed.
 */
 int FT_rmDir(char *path);
 
@@ -56,6 +70,29 @@ int FT_rmDir(char *path);
 */
 int FT_insertFile(char *path, void *contents, size_t length);
 
+/*
+  Inserts n new entries at once: the directories paths[0..n), if
+  contents is NULL, or else the files paths[0..n), where file
+  paths[i] has contents[i] of size lengths[i] bytes.
+  The entries are inserted in sorted order, as if by FT_insertDir or
+  FT_insertFile, but each one is reached from where the previous one
+  was inserted rather than from the root, and new children are
+  appended to their directories in order. The paths are sorted first
+  if they are not already in order, so passing them sorted (each
+  directory directly followed by the entries beneath it, and siblings
+  in strcmp order) saves the sort and its memory.
+  Returns SUCCESS if every entry is inserted.
+  Otherwise, stops at the first entry, in sorted order, that cannot be
+  inserted, leaving the entries before it in the tree, and returns
+  what FT_insertDir or FT_insertFile would return for it, or
+  MEMORY_ERROR if unable to allocate space to sort the paths.
+  Returns INITIALIZATION_ERROR if not in an initialized state.
+  In a tree with FT_CONCURRENT, other threads may change the tree
+  between entries, so each entry is inserted from the root instead.
+*/
+int FT_insertMany(char **paths, void **contents, size_t *lengths,
+                  size_t n);
+
 /*
   Returns TRUE if the tree contains the full path parameter as a
   file and FALSE otherwise.
@@ -68,6 +105,9 @@ boolean FT_containsFile(char *path);
   Returns INITIALIZATION_ERROR if not in an initialized state.
   Returns NOT_A_FILE if path exists but is a directory not a file.
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
+  Returns MEMORY_ERROR, in a tree with FT_CONCURRENT, if unable to
+  allocate the copy of the parent's children without the file, in
+  which case nothing is removed.
 */
 int FT_rmFile(char *path);
 
@@ -111,6 +151,157 @@ int FT_stat(char *path, boolean *type, size_t *length);
 */
 int FT_init(void);
 
+/*
+  Options for FT_initWithOptions, which may be combined with |.
+
+  FT_PATH_INDEX: also maintain a hash index of the full path of every
+  directory and file, so that FT_containsDir, FT_containsFile, FT_stat,
+  FT_getFileContents, FT_replaceFileContents, FT_rmDir and FT_rmFile
+  find existing paths in constant expected time instead of traversing
+  from the root. The index costs about one binding and one copy of the
+  full path per directory and file. If the index cannot be updated for
+  lack of memory, it is discarded and lookups fall back to traversal.
+
+  FT_ARENA: allocate every directory, file, name and child array from
+  an arena of large chunks instead of individually from the heap, so
+  that FT_destroy frees the whole tree a chunk at a time rather than
+  node by node. Memory released by FT_rmDir and FT_rmFile is kept for
+  reuse by later insertions, and returned to the heap by FT_destroy.
+
+  FT_CONCURRENT: allow any number of threads to call the functions on
+  the tree at the same time. Each directory gets a reader-writer lock
+  guarding its children and their files: insertions and removals hold
+  an exclusive lock only on the directory they change, so operations
+  on different directories proceed in parallel, and listings hold
+  shared locks on the directories they pass through. Lookups
+  (FT_containsDir, FT_containsFile, FT_getFileContents and FT_stat)
+  take no locks at all: children are changed by replacing a copy of
+  the directory's children, and whatever is replaced or removed is
+  freed only once every lookup that might still be using it is done.
+  FT_PATH_INDEX is ignored with this option, since every insertion and
+  removal would have to serialize on the index. FT_destroy, FT_free
+  and the FT_init functions must still not overlap any other call.
+
+  FT_WORKERS: for FT_newForest only, give each shard of the forest a
+  worker thread, pinned to a processor where the system allows it,
+  through whose queue every change to the shard is applied.
+
+  FT_PARALLEL_FREE: free directories on a pool of worker threads, one
+  per processor up to a small limit, instead of on the calling thread.
+  FT_rmDir returns as soon as the directory is unlinked, in time
+  proportional to its depth, and leaves its hierarchy to be freed in
+  the background; each worker frees a directory and hands its
+  subdirectories to whichever workers are free, so a large hierarchy
+  is split among all of them. FT_destroy frees the tree the same way,
+  and waits for the pool to finish. In a tree with FT_CONCURRENT,
+  FT_rmDir must still visit the hierarchy to wait out writers inside
+  it, but leaves the freeing to the pool.
+
+  FT_INCREMENTAL_FREE: free removed directories a few nodes at a time,
+  on the calling thread, with no extra threads. FT_rmDir returns as
+  soon as the directory is unlinked, and the hierarchy beneath it
+  waits on a stack; every later call of FT_insertDir, FT_insertFile,
+  FT_insertMany, FT_rmDir, FT_rmFile, FT_containsDir, FT_containsFile,
+  FT_getFileContents, FT_replaceFileContents or FT_stat first frees
+  at most a budget of nodes from it, 64 unless set by FT_setFreeBudget,
+  so that no call pauses for long. FT_destroy frees what remains. The
+  tree behaves in every other way as if the hierarchy were gone at
+  once. Ignored with FT_CONCURRENT or FT_PARALLEL_FREE. With
+  FT_PATH_INDEX, as with FT_PARALLEL_FREE, FT_rmDir still removes the
+  hierarchy's paths from the index before it returns.
+*/
+enum { FT_PATH_INDEX = 0x1, FT_ARENA = 0x2, FT_CONCURRENT = 0x4,
+       FT_WORKERS = 0x8, FT_PARALLEL_FREE = 0x10,
+       FT_INCREMENTAL_FREE = 0x20 };
+
+/*
+  Sets the data structure to initialized status, as FT_init does,
+  with the combination of FT_* options given by options.
+  Returns INITIALIZATION_ERROR if already initialized,
+  MEMORY_ERROR if unable to allocate the structures for options,
+  and SUCCESS otherwise.
+*/
+int FT_initWithOptions(unsigned int options);
+
+/*
+  Sets to budget the most nodes of removed directories that each call
+  frees in a tree with FT_INCREMENTAL_FREE. With a budget of 0, they
+  are only freed by FT_destroy. Has no effect on other trees.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_setFreeBudget(size_t budget);
+
+/*
+  Sets to threshold the number of files, or of subdirectories, beyond
+  which a directory also keeps a hash table of them, 512 unless set,
+  so that finding, adding and removing one of a very wide directory's
+  children takes constant expected time rather than time proportional
+  to their number. Its children are then sorted only when listed. A
+  directory that shrinks to half the threshold drops its table. A
+  threshold of 0 keeps no tables. Is the default threshold of the
+  trees created from then on, by FT_init, FT_initWithOptions and
+  FT_new, each of which may be given another by
+  FT_setFanOutThresholdIn. Has no effect on trees with FT_CONCURRENT,
+  whose directories always stay sorted so that lookups need no locks.
+*/
+void FT_setFanOutThreshold(size_t threshold);
+
+/*
+  Sets whether a directory that grows beyond the fan-out threshold
+  moves its files, or subdirectories, to a B+tree, if ordered is TRUE,
+  rather than keeping a hash table of them, as it does by default.
+  The B+tree finds, adds and removes a child in time logarithmic in
+  their number, and keeps them in order, so that listing a directory
+  never sorts it and stepping to the next child, as FT_toString and
+  FT_forEachLine do, takes logarithmic time too. Is, like the
+  threshold, the default of the trees created from then on, each of
+  which may be given another by FT_setFanOutOrderedIn. Has no effect
+  on trees with FT_CONCURRENT.
+*/
+void FT_setFanOutOrdered(boolean ordered);
+
+/*
+  Moves every directory and file of the data structure, with its
+  name, into fresh memory, laid out in the order in which FT_toString
+  lists them, with the contents and lengths of the files, which
+  listings and most lookups do not read, placed apart after all of
+  them. After a long run of insertions and removals has scattered the
+  tree, this lets listings and lookups read memory in order. Removed
+  directories still waiting to be freed are freed first. The contents
+  themselves, owned by the client, do not move. No other call may
+  overlap this one, even with FT_CONCURRENT.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  MEMORY_ERROR if unable to allocate the new memory, in which case the
+  tree is unchanged, and SUCCESS otherwise.
+*/
+int FT_compact(void);
+
+/*
+  Freezes the data structure: packs a read-only copy of its hierarchy
+  into a few arrays, with each directory's children laid out as an
+  implicit binary search tree in breadth-first order, and serves every
+  lookup and listing (FT_containsDir, FT_containsFile,
+  FT_getFileContents, FT_stat, FT_forEachLine, FT_write and
+  FT_toString) from the copy, which finds a path by hashing it once,
+  with a minimal perfect hash of every full path in the tree that
+  takes a few bits per path, and lists the tree in one pass over its
+  entries. Without memory for the hash, the copy searches each
+  directory on the path in turn, without a hard-to-predict branch per
+  child compared. The copy is made in time and memory
+  proportional to the size of the tree, which is kept as it is. The
+  next call that may change the tree (FT_insertDir, FT_insertFile,
+  FT_insertMany, FT_rmDir, FT_rmFile or FT_replaceFileContents)
+  thaws it, whether or not it does change it, discarding the copy, so
+  a tree that is built once and then only read is best frozen once it
+  is built. Freezing a frozen tree does nothing. No call that may
+  change the tree may overlap this one, even with FT_CONCURRENT.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  MEMORY_ERROR if unable to allocate the copy, in which case the tree
+  is not frozen, and SUCCESS otherwise.
+*/
+int FT_freeze(void);
+
 /*
   Removes all contents of the data structure and
   returns it to uninitialized status.
@@ -129,4 +320,239 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/*
+  Calls (*callback)(line, length, ctx) once for each directory and
+  file, in the same order as they are listed by FT_toString, where
+  line is the full path and length is its length. line is owned by
+  the tree and is only valid during the call.
+  The walk uses memory for one path at a time, however large the tree.
+  If callback returns anything but SUCCESS, the walk stops there and
+  that status is returned. callback must not modify the tree.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  MEMORY_ERROR if unable to allocate space for a path,
+  and SUCCESS otherwise.
+*/
+int FT_forEachLine(int (*callback)(const char* line, size_t length,
+                                   void* ctx),
+                   void* ctx);
+
+/*
+  Writes the listing that FT_toString returns to stream, as it walks
+  the tree, without building the listing in memory.
+  Returns EOF if there is a write error, and otherwise the statuses
+  of FT_forEachLine.
+*/
+int FT_write(FILE* stream);
+
+/*
+  Returns a new, empty File Tree with the combination of FT_* options
+  given by options, as for FT_initWithOptions, or NULL if unable to
+  allocate it. Trees share no state, so different trees may be used
+  from different threads at the same time.
+*/
+FT_T FT_new(unsigned int options);
+
+/*
+  Frees ft and its whole hierarchy. ft may be NULL, in which case
+  nothing is freed. The contents of its files are owned by the client
+  and are not freed.
+*/
+void FT_free(FT_T ft);
+
+/*
+  Sets to threshold the fan-out threshold of ft, as
+  FT_setFanOutThreshold sets it for trees yet to be created, leaving
+  other trees as they are. A directory that already has more than a
+  few children keeps the threshold it had until it shrinks to a few
+  again, or until ft is compacted.
+*/
+void FT_setFanOutThresholdIn(FT_T ft, size_t threshold);
+
+/*
+  Sets whether the directories of ft that grow beyond its fan-out
+  threshold are ordered, as FT_setFanOutOrdered sets it for trees yet
+  to be created, leaving other trees as they are. A directory that
+  already has more than a few children keeps the choice it had until
+  it shrinks to a few again, or until ft is compacted.
+*/
+void FT_setFanOutOrderedIn(FT_T ft, boolean ordered);
+
+/*
+  The following functions behave as the functions above of the same
+  name without the In suffix, but on the tree ft, which must not be
+  NULL. Since ft is always initialized, they never return
+  INITIALIZATION_ERROR.
+*/
+int FT_insertDirIn(FT_T ft, const char *path);
+boolean FT_containsDirIn(FT_T ft, const char *path);
+int FT_rmDirIn(FT_T ft, const char *path);
+int FT_insertFileIn(FT_T ft, const char *path, void *contents,
+                    size_t length);
+int FT_insertManyIn(FT_T ft, char **paths, void **contents,
+                    size_t *lengths, size_t n);
+boolean FT_containsFileIn(FT_T ft, const char *path);
+int FT_rmFileIn(FT_T ft, const char *path);
+void *FT_getFileContentsIn(FT_T ft, const char *path);
+void *FT_replaceFileContentsIn(FT_T ft, const char *path,
+                               void *newContents, size_t newLength);
+int FT_statIn(FT_T ft, const char *path, boolean *type,
+              size_t *length);
+int FT_forEachLineIn(FT_T ft,
+                     int (*callback)(const char* line, size_t length,
+                                     void* ctx),
+                     void* ctx);
+int FT_writeIn(FT_T ft, FILE* stream);
+char *FT_toStringIn(FT_T ft);
+void FT_setFreeBudgetIn(FT_T ft, size_t budget);
+int FT_compactIn(FT_T ft);
+int FT_freezeIn(FT_T ft);
+
+/*
+  An FT_Queue_T is a front end through which any number of threads
+  submit changes to a tree, to be applied by a single thread that the
+  queue runs. The applier takes every change submitted since its last
+  batch, sorts the batch by path, and applies it in that order, so
+  that random changes from many threads become sorted runs over the
+  tree: in a tree without FT_CONCURRENT, each insertion is reached
+  from the one before, as in FT_insertMany, without taking any lock.
+  A tree without FT_CONCURRENT must not otherwise be used while it has
+  a queue. A concurrent tree may still be used directly as well, and
+  then its queue applies each change on its own, under the usual
+  locks.
+*/
+typedef struct FT_queue *FT_Queue_T;
+
+/*
+  Returns a new queue of changes to ft, with its applier thread
+  started, or NULL if unable to allocate it or start the thread.
+*/
+FT_Queue_T FT_newQueue(FT_T ft);
+
+/*
+  Stops queue's applier and frees queue, but not its tree. No
+  submission may overlap the call. queue may be NULL, in which case
+  nothing is freed.
+*/
+void FT_freeQueue(FT_Queue_T queue);
+
+/*
+  The following functions submit a change to queue's tree and wait for
+  it to be applied, returning what FT_insertDirIn, FT_insertFileIn,
+  FT_rmDirIn, FT_rmFileIn and FT_replaceFileContentsIn, respectively,
+  returned for it. The changes of any threads waiting at the same time
+  may be applied in any order.
+*/
+int FT_queueInsertDir(FT_Queue_T queue, const char *path);
+int FT_queueInsertFile(FT_Queue_T queue, const char *path,
+                       void *contents, size_t length);
+int FT_queueRmDir(FT_Queue_T queue, const char *path);
+int FT_queueRmFile(FT_Queue_T queue, const char *path);
+void *FT_queueReplaceFileContents(FT_Queue_T queue, const char *path,
+                                  void *newContents, size_t newLength);
+
+/*
+  An FT_Forest_T is a File Tree with any number of roots: where a tree
+  returns CONFLICTING_PATH for a path whose first component does not
+  name its root, a forest creates a new root. The roots are spread
+  over a fixed number of shards by a hash of their names, and each
+  shard is an independent concurrent tree, with its own locks and, if
+  FT_ARENA is given, its own arena, so that threads working beneath
+  roots in different shards share no memory. The forest may be used
+  by any number of threads at once.
+*/
+typedef struct FT_forest *FT_Forest_T;
+
+/*
+  Returns a new, empty forest of shards shards, each created with the
+  FT_* options given by options and FT_CONCURRENT, or NULL if shards
+  is 0 or if unable to allocate the forest or start its workers.
+*/
+FT_Forest_T FT_newForest(size_t shards, unsigned int options);
+
+/*
+  Frees forest, with all of its shards. No other call on forest may
+  overlap this one. forest may be NULL, in which case nothing is
+  freed.
+*/
+void FT_freeForest(FT_Forest_T forest);
+
+/*
+  The following functions behave as the FT_*In functions of the same
+  name without InForest, on the tree of the shard holding the first
+  component of path, except that any first component names a root,
+  and that those that would return a status or NULL may also do so
+  with MEMORY_ERROR or NULL when unable to allocate a copy of a path
+  longer than a few hundred characters. As for a tree, a root must be
+  a directory. The listing of a forest lists each root's hierarchy in
+  turn, in order of the roots' names, whichever shards they are in.
+*/
+int FT_insertDirInForest(FT_Forest_T forest, const char *path);
+boolean FT_containsDirInForest(FT_Forest_T forest, const char *path);
+int FT_rmDirInForest(FT_Forest_T forest, const char *path);
+int FT_insertFileInForest(FT_Forest_T forest, const char *path,
+                          void *contents, size_t length);
+boolean FT_containsFileInForest(FT_Forest_T forest, const char *path);
+int FT_rmFileInForest(FT_Forest_T forest, const char *path);
+void *FT_getFileContentsInForest(FT_Forest_T forest, const char *path);
+void *FT_replaceFileContentsInForest(FT_Forest_T forest,
+                                     const char *path,
+                                     void *newContents,
+                                     size_t newLength);
+int FT_statInForest(FT_Forest_T forest, const char *path,
+                    boolean *type, size_t *length);
+int FT_forEachLineInForest(FT_Forest_T forest,
+                           int (*callback)(const char* line,
+                                           size_t length, void* ctx),
+                           void* ctx);
+int FT_writeInForest(FT_Forest_T forest, FILE* stream);
+char *FT_toStringInForest(FT_Forest_T forest);
+
+/*
+  An FT_Snapshot_T is a read-only record of a tree's hierarchy as it
+  was when the snapshot was taken, for archiving: the shape of the
+  hierarchy is kept in a little over 2 bits per directory or file, as
+  a bit sequence that holds, level by level, each one's number of
+  children in unary and is walked by counting bits; one more bit per
+  entry marks the files; and the names are front-coded, each stored
+  as what it adds to the one before it, with the lengths of the files
+  among them. The contents of the files are not kept. Lookups and
+  listings read the snapshot as it is, without unpacking it. A
+  snapshot is independent of its tree, which may change or be freed
+  once it is taken, and may be read by any number of threads at once.
+*/
+typedef struct FT_snapshot *FT_Snapshot_T;
+
+/*
+  Returns a new snapshot of ft's hierarchy, or NULL if unable to
+  allocate it. No call that may change ft may overlap this one, even
+  with FT_CONCURRENT.
+*/
+FT_Snapshot_T FT_newSnapshot(FT_T ft);
+
+/*
+  Frees snapshot. snapshot may be NULL, in which case nothing is
+  freed.
+*/
+void FT_freeSnapshot(FT_Snapshot_T snapshot);
+
+/*
+  The following functions behave as the FT_*In functions of the same
+  name without InSnapshot, on the hierarchy recorded in snapshot. A
+  listing needs memory for one path at a time; lookups allocate
+  nothing.
+*/
+boolean FT_containsDirInSnapshot(FT_Snapshot_T snapshot,
+                                 const char *path);
+boolean FT_containsFileInSnapshot(FT_Snapshot_T snapshot,
+                                  const char *path);
+int FT_statInSnapshot(FT_Snapshot_T snapshot, const char *path,
+                      boolean *type, size_t *length);
+int FT_forEachLineInSnapshot(FT_Snapshot_T snapshot,
+                             int (*callback)(const char* line,
+                                             size_t length,
+                                             void* ctx),
+                             void* ctx);
+int FT_writeInSnapshot(FT_Snapshot_T snapshot, FILE* stream);
+char *FT_toStringInSnapshot(FT_Snapshot_T snapshot);
+
 #endif
@@ -0,0 +1,330 @@
+/*--------------------------------------------------------------------*/
+/* ft_alloc_client.c                                                  */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ft.h"
+
+/* The number of calls to malloc, calloc and realloc so far, and the
+   number of calls to free. This client must be linked with
+   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free so that
+   the FT's calls are routed through the wrappers below. */
+static size_t allocations;
+static size_t frees;
+
+/* While failing is nonzero, every call to malloc, calloc and realloc
+   fails. */
+static int failing;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+/* Counts and forwards a call to malloc, unless failing. */
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  if(failing)
+    return NULL;
+  return __real_malloc(size);
+}
+
+/* Counts and forwards a call to calloc, unless failing. */
+void *__wrap_calloc(size_t nmemb, size_t size) {
+  allocations++;
+  if(failing)
+    return NULL;
+  return __real_calloc(nmemb, size);
+}
+
+/* Counts and forwards a call to realloc, unless failing. */
+void *__wrap_realloc(void *ptr, size_t size) {
+  allocations++;
+  if(failing)
+    return NULL;
+  return __real_realloc(ptr, size);
+}
+
+/* Counts and forwards a call to free. */
+void __wrap_free(void *ptr) {
+  frees++;
+  __real_free(ptr);
+}
+
+/* The number of nodes in the tree that insertWide inserts with a
+   width of 10, counting the directory r. */
+enum { WIDE_NODES = 1 + 10 + 100 + 1000 + 1000 };
+
+/* Inserts a tree of width^3 directories, each holding one file, all
+   beneath the directory r. */
+static void insertWide(const char* r, int width) {
+  char path[64];
+  int i, j, k;
+
+  for(i = 0; i < width; i++)
+    for(j = 0; j < width; j++)
+      for(k = 0; k < width; k++) {
+        sprintf(path, "%s/%d/%d/%d", r, i, j, k);
+        assert(FT_insertDir(path) == SUCCESS);
+        sprintf(path, "%s/%d/%d/%d/F", r, i, j, k);
+        assert(FT_insertFile(path, NULL, 0) == SUCCESS);
+      }
+}
+
+/* Performs every read-only lookup on a tree holding a/b/c, a/b/F and
+   a/d/G, on paths that exist, that do not exist, that run through a
+   file, and that are outside of the root. */
+static void lookUpEverything(void) {
+  boolean b;
+  size_t l;
+
+  assert(FT_containsDir("a") == TRUE);
+  assert(FT_containsDir("a/b/c") == TRUE);
+  assert(FT_containsDir("a/b/F") == FALSE);
+  assert(FT_containsDir("a/b/x") == FALSE);
+  assert(FT_containsDir("a/b/F/x") == FALSE);
+  assert(FT_containsDir("b/b/c") == FALSE);
+  assert(FT_containsFile("a/b/F") == TRUE);
+  assert(FT_containsFile("a/d/G") == TRUE);
+  assert(FT_containsFile("a/b/c") == FALSE);
+  assert(FT_containsFile("a/b/G") == FALSE);
+  assert(FT_containsFile("a/b/F/G") == FALSE);
+  assert(FT_containsFile("ab/b/F") == FALSE);
+  assert(FT_stat("a/b/F", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 4);
+  assert(FT_stat("a/b", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  assert(FT_stat("a/b/x", &b, &l) == NO_SUCH_PATH);
+  assert(FT_stat("a/b/F/x", &b, &l) == NO_SUCH_PATH);
+  assert(!strcmp(FT_getFileContents("a/b/F"), "abc"));
+  assert(FT_getFileContents("a/d/G") == NULL);
+  assert(FT_getFileContents("a/b") == NULL);
+  assert(FT_getFileContents("a/x/G") == NULL);
+}
+
+/* Inserts n files and n directories into the directory a of ft, and
+   returns the number of allocations made doing so. */
+static size_t insertFlat(FT_T ft, int n) {
+  char path[64];
+  size_t before;
+  int i;
+
+  before = allocations;
+  for(i = 0; i < n; i++) {
+    sprintf(path, "a/%d", i);
+    assert(FT_insertDirIn(ft, path) == SUCCESS);
+    sprintf(path, "a/F%d", i);
+    assert(FT_insertFileIn(ft, path, NULL, 0) == SUCCESS);
+  }
+  return allocations - before;
+}
+
+/* Tests that the FT's read operations make no heap allocations, with
+   and without a path index and in a frozen tree, that freezing a tree
+   makes only a few, that a snapshot is taken with a few and read
+   with none, that an arena-backed tree is removed without
+   freeing each node and destroyed with a few calls to free, and that
+   a tree freeing removals incrementally frees no more than its
+   budget on any call, that a concurrent tree's removals fail whole
+   without memory, and that a tree's own fan-out threshold and order
+   apply to it alone. Returns 0. */
+int main(void) {
+  size_t before;
+  size_t nodeFrees;
+  size_t calls;
+  size_t plain;
+  size_t hashed;
+  size_t ordered;
+  size_t l;
+  boolean b;
+  char path[64];
+  int i;
+  FT_T ft;
+  FT_T ft2;
+  FT_Snapshot_T snapshot;
+
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/F", "abc", 4) == SUCCESS);
+  assert(FT_insertFile("a/d/G", NULL, 0) == SUCCESS);
+  before = allocations;
+  for(i = 0; i < 100; i++)
+    lookUpEverything();
+  assert(allocations == before);
+  assert(FT_destroy() == SUCCESS);
+
+  assert(FT_initWithOptions(FT_PATH_INDEX) == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/F", "abc", 4) == SUCCESS);
+  assert(FT_insertFile("a/d/G", NULL, 0) == SUCCESS);
+  before = allocations;
+  for(i = 0; i < 100; i++)
+    lookUpEverything();
+  assert(allocations == before);
+  assert(FT_destroy() == SUCCESS);
+
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/F", "abc", 4) == SUCCESS);
+  assert(FT_insertFile("a/d/G", NULL, 0) == SUCCESS);
+  assert(FT_freeze() == SUCCESS);
+  before = allocations;
+  for(i = 0; i < 100; i++)
+    lookUpEverything();
+  assert(allocations == before);
+  assert(FT_destroy() == SUCCESS);
+
+  fprintf(stderr, "No allocations in %d rounds of lookups\n", 3 * i);
+
+  /* freezing a tree packs it into a few arrays, grown by doubling,
+     rather than allocating anything per node */
+  assert(FT_init() == SUCCESS);
+  insertWide("a", 10);
+  before = allocations;
+  assert(FT_freeze() == SUCCESS);
+  assert((allocations - before) * 20 < WIDE_NODES);
+  fprintf(stderr, "%lu allocations freezing a tree of %d nodes\n",
+          (unsigned long) (allocations - before), (int) WIDE_NODES);
+  assert(FT_destroy() == SUCCESS);
+
+  /* so is a snapshot, which is then read without allocating */
+  assert((ft = FT_new(0)) != NULL);
+  for(i = 0; i < 1000; i++) {
+    sprintf(path, "a/%d/%d/%d/F", i / 100, i / 10 % 10, i % 10);
+    assert(FT_insertFileIn(ft, path, NULL, (size_t) i) == SUCCESS);
+  }
+  before = allocations;
+  assert((snapshot = FT_newSnapshot(ft)) != NULL);
+  assert((allocations - before) * 20 < WIDE_NODES);
+  fprintf(stderr, "%lu allocations taking a snapshot of %d nodes\n",
+          (unsigned long) (allocations - before), (int) WIDE_NODES);
+  FT_free(ft);
+  before = allocations;
+  for(i = 0; i < 1000; i++) {
+    sprintf(path, "a/%d/%d/%d/F", i / 100, i / 10 % 10, i % 10);
+    assert(FT_statInSnapshot(snapshot, path, &b, &l) == SUCCESS);
+    assert(b == TRUE && l == (size_t) i);
+    assert(FT_containsDirInSnapshot(snapshot, path) == FALSE);
+    sprintf(path, "a/%d/%d/%d/G", i / 100, i / 10 % 10, i % 10);
+    assert(FT_containsFileInSnapshot(snapshot, path) == FALSE);
+  }
+  assert(allocations == before);
+  FT_freeSnapshot(snapshot);
+
+  /* without an arena, destroying the tree frees every block that is
+     not in its slab */
+  assert(FT_init() == SUCCESS);
+  insertWide("a", 10);
+  before = frees;
+  assert(FT_destroy() == SUCCESS);
+  nodeFrees = frees - before;
+
+  /* with one, removal recycles blocks and destruction frees chunks */
+  assert(FT_initWithOptions(FT_ARENA) == SUCCESS);
+  insertWide("a", 10);
+  before = frees;
+  assert(FT_rmDir("a/5") == SUCCESS);
+  assert(frees == before);
+  before = allocations;
+  for(i = 0; i < 100; i++) {
+    sprintf(path, "a/5/%d/%d", i / 10, i % 10);
+    assert(FT_insertDir(path) == SUCCESS);
+  }
+  assert(allocations == before);
+  before = frees;
+  assert(FT_destroy() == SUCCESS);
+  assert((frees - before) * 100 < WIDE_NODES);
+
+  fprintf(stderr, "%lu frees destroying the tree without an arena, "
+          "%lu with one\n", (unsigned long) nodeFrees,
+          (unsigned long) (frees - before));
+
+  /* removal frees nothing, and each later call frees a few nodes, of
+     up to six blocks each, until nothing is left; as nodes go back to
+     the slab, not every call frees a block, so the calls are counted
+     up to the last one that does */
+  assert(FT_initWithOptions(FT_INCREMENTAL_FREE) == SUCCESS);
+  assert(FT_setFreeBudget(4) == SUCCESS);
+  insertWide("a", 10);
+  before = frees;
+  assert(FT_rmDir("a/5") == SUCCESS);
+  assert(frees == before);
+  calls = 0;
+  for(i = 0; i < 1000; i++) {
+    before = frees;
+    assert(FT_containsDir("a/5") == FALSE);
+    assert(frees - before <= 4 * 6);
+    if(frees != before)
+      calls = (size_t) i + 1;
+  }
+  assert(calls > 0 && calls < 1000);
+  assert(FT_destroy() == SUCCESS);
+
+  fprintf(stderr, "%lu calls to free a removed directory of 211 "
+          "nodes, 4 at a time\n", (unsigned long) calls);
+
+  /* in a concurrent tree, a removal that cannot copy its parent's
+     children fails whole, rather than change the set that lookups are
+     searching */
+  assert((ft = FT_new(FT_CONCURRENT)) != NULL);
+  for(i = 0; i < 10; i++) {
+    sprintf(path, "a/%d", i);
+    assert(FT_insertDirIn(ft, path) == SUCCESS);
+    sprintf(path, "a/F%d", i);
+    assert(FT_insertFileIn(ft, path, NULL, 0) == SUCCESS);
+  }
+  failing = 1;
+  assert(FT_rmDirIn(ft, "a/5") == MEMORY_ERROR);
+  assert(FT_rmFileIn(ft, "a/F5") == MEMORY_ERROR);
+  failing = 0;
+  for(i = 0; i < 10; i++) {
+    sprintf(path, "a/%d", i);
+    assert(FT_containsDirIn(ft, path) == TRUE);
+    sprintf(path, "a/F%d", i);
+    assert(FT_containsFileIn(ft, path) == TRUE);
+  }
+  assert(FT_rmDirIn(ft, "a/5") == SUCCESS);
+  assert(FT_rmFileIn(ft, "a/F5") == SUCCESS);
+  assert(FT_containsDirIn(ft, "a/5") == FALSE);
+  assert(FT_containsFileIn(ft, "a/F5") == FALSE);
+  FT_free(ft);
+
+  fprintf(stderr, "Removals without memory for a copy leave the "
+          "tree whole\n");
+
+  /* a wide directory of a tree given a low threshold keeps a hash
+     table, or a B+tree if the tree is ordered, which costs
+     allocations that the other trees never make */
+  assert((ft = FT_new(0)) != NULL);
+  plain = insertFlat(ft, 100);
+  FT_free(ft);
+  assert((ft = FT_new(0)) != NULL);
+  assert((ft2 = FT_new(0)) != NULL);
+  FT_setFanOutThresholdIn(ft, 4);
+  hashed = insertFlat(ft, 100);
+  assert(hashed > plain);
+  assert(insertFlat(ft2, 100) == plain);
+  FT_free(ft);
+  FT_free(ft2);
+  assert((ft = FT_new(0)) != NULL);
+  assert((ft2 = FT_new(0)) != NULL);
+  FT_setFanOutThresholdIn(ft, 4);
+  FT_setFanOutOrderedIn(ft, TRUE);
+  FT_setFanOutOrderedIn(ft2, TRUE);
+  ordered = insertFlat(ft, 100);
+  assert(ordered > plain && ordered != hashed);
+  assert(insertFlat(ft2, 100) == plain);
+  FT_free(ft);
+  FT_free(ft2);
+
+  fprintf(stderr, "%lu allocations for a directory of 200 entries, "
+          "%lu with a threshold of 4, %lu ordered\n",
+          (unsigned long) plain, (unsigned long) hashed,
+          (unsigned long) ordered);
+  return 0;
+}
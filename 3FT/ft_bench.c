@@ -0,0 +1,281 @@
+/*--------------------------------------------------------------------*/
+/* ft_bench.c                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <malloc.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ft.h"
+
+/* The number of leaf directories in the benchmarks, and how many of
+   them share each parent. */
+enum { LEAVES = 100000, PER_PARENT = 100 };
+
+/* The number of distinct packages in the node_modules benchmark, and
+   how many of them each package has in its own node_modules. */
+enum { PACKAGES = 20000, DEPENDENCIES = 4 };
+
+/* The names of the files that every package of the node_modules
+   benchmark holds, and of those that its lib directory holds. */
+static const char* packageFiles[] = {
+  "package.json", "index.js", "README.md", "LICENSE", "CHANGELOG.md"
+};
+static const char* libFiles[] = {
+  "index.js", "utils.js", "types.d.ts"
+};
+
+/* The number of times the traversal benchmark times each operation,
+   and a prime that scatters the order of its insertions. */
+enum { REPEATS = 5, SCATTER = 7919 };
+
+/* Returns the number of bytes of heap in use, including the
+   allocator's own overhead for each block and the blocks large
+   enough to be mapped on their own. */
+static size_t heapInUse(void) {
+  struct mallinfo2 info;
+
+  info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+/* Inserts LEAVES leaf directories, PER_PARENT to a parent, as in a
+   typical tree, where most directories are leaves, and prints the
+   heap each directory takes, allocator overhead included. */
+static void benchDirectoryBytes(void) {
+  char path[64];
+  size_t before;
+  size_t i;
+  int result;
+
+  result = FT_init();
+  assert(result == SUCCESS);
+  result = FT_insertDir("r");
+  assert(result == SUCCESS);
+
+  before = heapInUse();
+  for(i = 0; i < LEAVES; i++) {
+    sprintf(path, "r/%lu/%lu", (unsigned long) (i / PER_PARENT),
+            (unsigned long) (i % PER_PARENT));
+    result = FT_insertDir(path);
+    assert(result == SUCCESS);
+  }
+  printf("%.1f bytes per directory\n",
+         (double) (heapInUse() - before) /
+         (double) (LEAVES + LEAVES / PER_PARENT));
+
+  result = FT_destroy();
+  assert(result == SUCCESS);
+  (void) result;
+}
+
+/* Writes into path the path of the file in leaf directory i of the
+   traversal benchmark. */
+static void leafFile(char* path, size_t i) {
+  sprintf(path, "r/%lu/%lu/F", (unsigned long) (i / PER_PARENT),
+          (unsigned long) (i % PER_PARENT));
+}
+
+/* Returns the seconds that REPEATS listings of the tree take. */
+static double timeListings(void) {
+  clock_t start;
+  char* listing;
+  int r;
+
+  start = clock();
+  for(r = 0; r < REPEATS; r++) {
+    listing = FT_toString();
+    assert(listing != NULL);
+    free(listing);
+  }
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Returns the seconds that REPEATS lookups of every file of the
+   traversal benchmark take. */
+static double timeLookups(void) {
+  clock_t start;
+  char path[64];
+  size_t i;
+  int r;
+
+  start = clock();
+  for(r = 0; r < REPEATS; r++)
+    for(i = 0; i < LEAVES; i++) {
+      leafFile(path, i);
+      if(!FT_containsFile(path))
+        abort();
+    }
+  return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Inserts LEAVES leaf directories, each holding a file, in scattered
+   order, then removes every other parent and inserts its leaves
+   again, so that the nodes lie scattered across memory, as after a
+   long run of changes, and prints how long listings and lookups take
+   before and after FT_compact lays the tree out in order, and once
+   FT_freeze has packed it. */
+static void benchTraversal(void) {
+  char path[64];
+  size_t i;
+  size_t j;
+  int result;
+
+  result = FT_init();
+  assert(result == SUCCESS);
+
+  for(j = 0; j < LEAVES; j++) {
+    i = j * SCATTER % LEAVES;
+    leafFile(path, i);
+    result = FT_insertFile(path, NULL, 0);
+    assert(result == SUCCESS);
+  }
+  for(i = 0; i < LEAVES / PER_PARENT; i += 2) {
+    sprintf(path, "r/%lu", (unsigned long) i);
+    result = FT_rmDir(path);
+    assert(result == SUCCESS);
+  }
+  for(j = 0; j < LEAVES; j++) {
+    i = j * SCATTER % LEAVES;
+    if(i / PER_PARENT % 2 != 0)
+      continue;
+    leafFile(path, i);
+    result = FT_insertFile(path, NULL, 0);
+    assert(result == SUCCESS);
+  }
+
+  printf("scattered: %.3f s listing, %.3f s looking up\n",
+         timeListings(), timeLookups());
+  result = FT_compact();
+  assert(result == SUCCESS);
+  printf("compacted: %.3f s listing, %.3f s looking up\n",
+         timeListings(), timeLookups());
+  result = FT_freeze();
+  assert(result == SUCCESS);
+  printf("frozen:    %.3f s listing, %.3f s looking up\n",
+         timeListings(), timeLookups());
+
+  result = FT_destroy();
+  assert(result == SUCCESS);
+  (void) result;
+}
+
+/* Takes a snapshot of a tree of LEAVES leaf directories, each holding
+   a file, and prints the heap that each directory or file takes in
+   the tree and in the snapshot, allocator overhead included, and how
+   long REPEATS lookups of every file take in the snapshot. */
+static void benchSnapshot(void) {
+  FT_T ft;
+  FT_Snapshot_T snapshot;
+  clock_t start;
+  char path[64];
+  size_t before;
+  size_t treeBytes;
+  size_t entries;
+  size_t i;
+  int r;
+  int result;
+
+  before = heapInUse();
+  ft = FT_new(0);
+  assert(ft != NULL);
+  for(i = 0; i < LEAVES; i++) {
+    leafFile(path, i);
+    result = FT_insertFileIn(ft, path, NULL, i);
+    assert(result == SUCCESS);
+  }
+  treeBytes = heapInUse() - before;
+  entries = 1 + LEAVES / PER_PARENT + 2 * LEAVES;
+
+  before = heapInUse();
+  snapshot = FT_newSnapshot(ft);
+  assert(snapshot != NULL);
+  printf("%.1f bytes per entry in a tree, %.2f in its snapshot\n",
+         (double) treeBytes / (double) entries,
+         (double) (heapInUse() - before) / (double) entries);
+  FT_free(ft);
+
+  start = clock();
+  for(r = 0; r < REPEATS; r++)
+    for(i = 0; i < LEAVES; i++) {
+      leafFile(path, i);
+      if(!FT_containsFileInSnapshot(snapshot, path))
+        abort();
+    }
+  printf("snapshot:  %.3f s looking up\n",
+         (double) (clock() - start) / CLOCKS_PER_SEC);
+
+  FT_freeSnapshot(snapshot);
+  (void) result;
+}
+
+/* Inserts into ft the package numbered package of the node_modules
+   benchmark beneath the directory dir, with its files and its lib
+   directory, and with its dependencies beneath it if nested is TRUE.
+   Returns the number of directories and files inserted, not counting
+   dir/node_modules. */
+static size_t insertPackage(FT_T ft, const char* dir, size_t package,
+                            boolean nested) {
+  char path[256];
+  size_t length;
+  size_t count = 2;
+  size_t i;
+  int result;
+
+  length = (size_t) sprintf(path, "%s/node_modules/package-%lu", dir,
+                            (unsigned long) package);
+  for(i = 0; i < sizeof(packageFiles) / sizeof(packageFiles[0]); i++) {
+    sprintf(path + length, "/%s", packageFiles[i]);
+    result = FT_insertFileIn(ft, path, NULL, 0);
+    assert(result == SUCCESS);
+    count++;
+  }
+  for(i = 0; i < sizeof(libFiles) / sizeof(libFiles[0]); i++) {
+    sprintf(path + length, "/lib/%s", libFiles[i]);
+    result = FT_insertFileIn(ft, path, NULL, 0);
+    assert(result == SUCCESS);
+    count++;
+  }
+
+  /* its own node_modules, if any, and the packages beneath it */
+  path[length] = '\0';
+  if(nested)
+    count++;
+  for(i = 1; nested && i <= DEPENDENCIES; i++)
+    count += insertPackage(ft, path, (package * 7 + i) % PACKAGES,
+                           FALSE);
+  (void) result;
+  return count;
+}
+
+/* Inserts a tree laid out as npm lays out node_modules, where the
+   same few file names and a limited set of package names recur
+   throughout, and prints the heap that each directory or file takes,
+   allocator overhead included. */
+static void benchNodeModules(void) {
+  FT_T ft;
+  size_t before;
+  size_t entries = 2;
+  size_t i;
+
+  before = heapInUse();
+  ft = FT_new(0);
+  assert(ft != NULL);
+  for(i = 0; i < PACKAGES; i++)
+    entries += insertPackage(ft, "app", i, TRUE);
+  printf("%.1f bytes per entry in a node_modules tree of %lu\n",
+         (double) (heapInUse() - before) / (double) entries,
+         (unsigned long) entries);
+  FT_free(ft);
+}
+
+int main(void) {
+  benchDirectoryBytes();
+  benchTraversal();
+  benchSnapshot();
+  benchNodeModules();
+  return 0;
+}
@@ -10,13 +10,42 @@
 #include <string.h>
 #include "ft.h"
 
+/* Counts line in *pLeft lines left to see, where pLeft is the int*
+   that ctx points to, and stops the walk with NO_SUCH_PATH once there
+   are none left. */
+static int countDown(const char* line, size_t length, void* ctx) {
+  int* pLeft = ctx;
+
+  assert(strlen(line) == length);
+  if(--*pLeft == 0)
+    return NO_SUCH_PATH;
+  return SUCCESS;
+}
+
+/* The length of a name longer than a chunk of a tree's slab holds. */
+enum { LONG_NAME = 70000 };
+
+/* Entries for the bulk loading tests, deliberately out of order. */
+static char* manyDirs[] = { "a/b-c", "a/b/c", "a" };
+static char* manyFiles[] = { "a/b/G", "a/b-c/I", "a/b/F", "a/b/c/H" };
+static void* manyContents[] = { "G", "I", "F", "H" };
+static size_t manyLengths[] = { 2, 2, 2, 2 };
+static char* badDirs[] = { "a/x", "b/c", "a/d", "a/b/F/x" };
+
 /* Tests the FT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
    Returns 0. */
 int main(void) {
   char* temp;
+  char* temp2;
   boolean b;
   size_t l;
+  size_t k;
+  int i;
+  FILE* stream;
+  FT_T ft1, ft2;
+  FT_Forest_T forest;
+  FT_Snapshot_T snapshot;
   char arr[1000] = {'\0'};
 
   /* Before the data structure is initialized, insert*, remove*,
@@ -197,7 +226,466 @@ int main(void) {
   assert(FT_containsDir("a") == FALSE);
   assert(FT_containsFile("a") == FALSE);
   assert((temp = FT_toString()) == NULL);
-  
+
+  /* with a path index, lookups and removals behave exactly as they
+     do without one, including on removed subtrees */
+  assert(FT_initWithOptions(FT_PATH_INDEX) == SUCCESS);
+  assert(FT_initWithOptions(FT_PATH_INDEX) == INITIALIZATION_ERROR);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/F", "index", 6) == SUCCESS);
+  assert(FT_insertFile("a/b/c/G", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/b") == ALREADY_IN_TREE);
+  assert(FT_insertDir("b") == CONFLICTING_PATH);
+  assert(FT_insertDir("a/b/F/x") == NOT_A_DIRECTORY);
+  assert(FT_containsDir("a/b/c") == TRUE);
+  assert(FT_containsDir("a/b/F") == FALSE);
+  assert(FT_containsFile("a/b/F") == TRUE);
+  assert(FT_containsFile("a/b/c") == FALSE);
+  assert(!strcmp(FT_getFileContents("a/b/F"), "index"));
+  assert(FT_stat("a/b/F", &b, &l) == SUCCESS);
+  assert(b == TRUE);
+  assert(l == 6);
+  assert(FT_stat("a/b", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  assert(FT_stat("a/b/x", &b, &l) == NO_SUCH_PATH);
+  assert(FT_rmDir("a/b/F") == NOT_A_DIRECTORY);
+  assert(FT_rmFile("a/b/c") == NOT_A_FILE);
+  assert(FT_rmDir("a/b") == SUCCESS);
+  assert(FT_containsDir("a/b/c") == FALSE);
+  assert(FT_containsFile("a/b/c/G") == FALSE);
+  assert(FT_rmFile("a/b/F") == NO_SUCH_PATH);
+  assert(FT_containsDir("a") == TRUE);
+  assert(FT_insertDir("a/b") == SUCCESS);
+  assert(FT_containsDir("a/b") == TRUE);
+  assert(FT_destroy() == SUCCESS);
+
+  /* with an arena, memory from removed subtrees is reused, and the
+     tree can be torn down and rebuilt repeatedly */
+  for(i = 0; i < 3; i++) {
+    assert(FT_initWithOptions(FT_ARENA | FT_PATH_INDEX) == SUCCESS);
+    assert(FT_insertDir("a/b/c") == SUCCESS);
+    assert(FT_insertFile("a/b/F", "arena", 6) == SUCCESS);
+    assert(FT_insertDir("a/d/CHILD1DIR/CHILD2DIR") == SUCCESS);
+    assert(FT_rmDir("a/d") == SUCCESS);
+    assert(FT_containsDir("a/d/CHILD1DIR") == FALSE);
+    assert(FT_insertDir("a/d/CHILD3DIR") == SUCCESS);
+    assert(FT_rmFile("a/b/F") == SUCCESS);
+    assert(FT_insertFile("a/b/G", "arena", 6) == SUCCESS);
+    assert(!strcmp(FT_getFileContents("a/b/G"), "arena"));
+    assert(FT_containsDir("a/d/CHILD3DIR") == TRUE);
+    assert(FT_containsFile("a/b/F") == FALSE);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/b\na/b/G\na/b/c\n"
+                         "a/d\na/d/CHILD3DIR\n"));
+    free(temp);
+    assert(FT_destroy() == SUCCESS);
+  }
+
+  /* with a pool freeing removed directories in the background, they
+     are gone as soon as FT_rmDir returns, and their paths can be
+     reused while the pool is still freeing them */
+  for(i = 0; i < 2; i++) {
+    assert(FT_initWithOptions(FT_PARALLEL_FREE | (i ? FT_ARENA : 0))
+           == SUCCESS);
+    assert(FT_insertDir("a/b/c/d") == SUCCESS);
+    assert(FT_insertDir("a/b/e") == SUCCESS);
+    assert(FT_insertFile("a/b/F", "pool", 5) == SUCCESS);
+    assert(FT_insertDir("a/x/y") == SUCCESS);
+    assert(FT_rmDir("a/b") == SUCCESS);
+    assert(FT_containsDir("a/b/c") == FALSE);
+    assert(FT_containsFile("a/b/F") == FALSE);
+    assert(FT_insertDir("a/b/c") == SUCCESS);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/b\na/b/c\na/x\na/x/y\n"));
+    free(temp);
+    assert(FT_rmDir("a") == SUCCESS);
+    assert(FT_insertDir("a") == SUCCESS);
+    assert(FT_destroy() == SUCCESS);
+  }
+
+  /* with removals freed a few nodes at a time, a removed directory
+     is gone at once, and its path can be reused before it is freed */
+  for(i = 0; i < 3; i++) {
+    assert(FT_setFreeBudget(1) == INITIALIZATION_ERROR);
+    assert(FT_initWithOptions(FT_INCREMENTAL_FREE |
+                              (i == 2 ? FT_ARENA : 0)) == SUCCESS);
+    assert(FT_setFreeBudget((size_t) i) == SUCCESS);
+    assert(FT_insertDir("a/b/c/d") == SUCCESS);
+    assert(FT_insertFile("a/b/c/F", "slow", 5) == SUCCESS);
+    assert(FT_insertFile("a/b/G", NULL, 0) == SUCCESS);
+    assert(FT_insertDir("a/b/e") == SUCCESS);
+    assert(FT_rmDir("a/b") == SUCCESS);
+    assert(FT_containsDir("a/b") == FALSE);
+    assert(FT_containsFile("a/b/c/F") == FALSE);
+    assert(FT_insertFile("a/b", "new", 4) == SUCCESS);
+    assert(FT_rmDir("a/b") == NOT_A_DIRECTORY);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/b\n"));
+    free(temp);
+    assert(FT_rmDir("a") == SUCCESS);
+    assert(FT_containsFile("a/b") == FALSE);
+    assert(FT_destroy() == SUCCESS);
+  }
+
+  /* a directory wider than the fan-out threshold is hashed, or kept
+     in a B+tree, yet is still listed in order, and stays consistent
+     as it shrinks back below the threshold */
+  FT_setFanOutThreshold(4);
+  for(l = 0; l < 2; l++) {
+    FT_setFanOutOrdered((boolean) l);
+    assert(FT_init() == SUCCESS);
+    for(i = 9; i >= 0; i--) {
+      sprintf(arr, "a/d%d/x", i);
+      assert(FT_insertDir(arr) == SUCCESS);
+      sprintf(arr, "a/F%d", i);
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+    }
+    assert(FT_insertDir("a/F3") == ALREADY_IN_TREE);
+    assert(FT_insertFile("a/d3", NULL, 0) == ALREADY_IN_TREE);
+    assert(FT_containsDir("a/d7/x") == TRUE);
+    assert(FT_rmDir("a/d4") == SUCCESS);
+    assert(FT_rmFile("a/F9") == SUCCESS);
+    assert(FT_insertDir("a/d10") == SUCCESS);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/F0\na/F1\na/F2\na/F3\na/F4\na/F5\n"
+                         "a/F6\na/F7\na/F8\na/d0\na/d0/x\na/d1\n"
+                         "a/d1/x\na/d10\na/d2\na/d2/x\na/d3\na/d3/x\n"
+                         "a/d5\na/d5/x\na/d6\na/d6/x\na/d7\na/d7/x\n"
+                         "a/d8\na/d8/x\na/d9\na/d9/x\n"));
+    free(temp);
+    for(i = 0; i < 9; i++) {
+      sprintf(arr, "a/d%d", i);
+      assert(FT_rmDir(arr) == (i == 4 ? NO_SUCH_PATH : SUCCESS));
+    }
+    assert(FT_containsDir("a/d9/x") == TRUE);
+    assert(FT_containsDir("a/d8") == FALSE);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/F0\na/F1\na/F2\na/F3\na/F4\na/F5\na/F6\n"
+                         "a/F7\na/F8\na/d10\na/d9\na/d9/x\n"));
+    free(temp);
+    assert(FT_destroy() == SUCCESS);
+  }
+  FT_setFanOutOrdered(FALSE);
+  FT_setFanOutThreshold(512);
+
+  /* files and directories whose names interleave share one set of
+     children, yet files are still listed first */
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertFile("a/m", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/b") == SUCCESS);
+  assert(FT_insertFile("a/c", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/z/y") == SUCCESS);
+  assert(FT_insertDir("a/m") == ALREADY_IN_TREE);
+  assert(FT_insertDir("a/c/x") == NOT_A_DIRECTORY);
+  assert(FT_rmDir("a/c") == NOT_A_DIRECTORY);
+  assert(FT_rmFile("a/b") == NOT_A_FILE);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "a\na/c\na/m\na/b\na/z\na/z/y\n"));
+  free(temp);
+  assert(FT_destroy() == SUCCESS);
+
+  /* compacting a tree leaves it as it was, whether it has an index
+     and an arena, locks, or removals waiting to be freed, and with
+     directories both narrow and wider than the fan-out threshold */
+  assert(FT_compact() == INITIALIZATION_ERROR);
+  FT_setFanOutThreshold(4);
+  for(i = 0; i < 4; i++) {
+    assert(FT_initWithOptions(i == 1 ? FT_PATH_INDEX | FT_ARENA :
+                              i == 2 ? FT_CONCURRENT :
+                              i == 3 ? FT_INCREMENTAL_FREE : 0)
+           == SUCCESS);
+    assert(FT_insertDir("a/b/c") == SUCCESS);
+    assert(FT_insertDir("a/x/y/z") == SUCCESS);
+    for(l = 0; l < 6; l++) {
+      sprintf(arr, "a/w/F%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, "wide", 5) == SUCCESS);
+    }
+    assert(FT_insertFile("a/b/F", "compact", 8) == SUCCESS);
+    assert(FT_rmDir("a/x") == SUCCESS);
+    assert(FT_compact() == SUCCESS);
+    assert(!strcmp(FT_getFileContents("a/b/F"), "compact"));
+    assert(FT_stat("a/w/F5", &b, &l) == SUCCESS);
+    assert(b == TRUE && l == 5);
+    assert(FT_containsDir("a/x") == FALSE);
+    assert(FT_containsDir("a/b/c") == TRUE);
+    assert(FT_insertDir("a/b/d") == SUCCESS);
+    assert(FT_rmFile("a/w/F0") == SUCCESS);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, "a\na/b\na/b/F\na/b/c\na/b/d\na/w\n"
+                         "a/w/F1\na/w/F2\na/w/F3\na/w/F4\na/w/F5\n"));
+    free(temp);
+    assert(FT_destroy() == SUCCESS);
+  }
+  FT_setFanOutThreshold(512);
+
+  /* a frozen tree answers every read as the live tree did, including
+     in directories whose names share long prefixes, until a change
+     thaws it */
+  assert(FT_freeze() == INITIALIZATION_ERROR);
+  for(i = 0; i < 3; i++) {
+    assert(FT_initWithOptions(i == 1 ? FT_PATH_INDEX :
+                              i == 2 ? FT_CONCURRENT : 0) == SUCCESS);
+    assert(FT_freeze() == SUCCESS);
+    assert(FT_containsDir("a") == FALSE);
+    assert((temp = FT_toString()) != NULL);
+    assert(!strcmp(temp, ""));
+    free(temp);
+    assert(FT_insertDir("a/b") == SUCCESS);
+    for(l = 0; l < 40; l += 2) {
+      sprintf(arr, "a/shared_prefix_%02lu", (unsigned long) l);
+      assert(FT_insertFile(arr, "frozen", 7) == SUCCESS);
+      sprintf(arr, "a/d%lu", (unsigned long) l);
+      assert(FT_insertDir(arr) == SUCCESS);
+    }
+    assert((temp = FT_toString()) != NULL);
+    assert(FT_freeze() == SUCCESS);
+    assert(FT_freeze() == SUCCESS);
+    assert((temp2 = FT_toString()) != NULL);
+    assert(!strcmp(temp, temp2));
+    free(temp);
+    free(temp2);
+    for(l = 0; l < 40; l++) {
+      sprintf(arr, "a/shared_prefix_%02lu", (unsigned long) l);
+      assert(FT_containsFile(arr) == (l % 2 == 0));
+      assert(FT_containsDir(arr) == FALSE);
+      assert(FT_stat(arr, &b, &k) == (l % 2 == 0 ? SUCCESS
+                                                  : NO_SUCH_PATH));
+      sprintf(arr, "a/d%lu", (unsigned long) l);
+      assert(FT_containsDir(arr) == (l % 2 == 0));
+    }
+    assert(!strcmp(FT_getFileContents("a/shared_prefix_38"), "frozen"));
+    assert(FT_stat("a/shared_prefix_38", &b, &k) == SUCCESS);
+    assert(b == TRUE && k == 7);
+    assert(FT_stat("a/b", &b, &k) == SUCCESS);
+    assert(b == FALSE);
+    assert(FT_getFileContents("a/b") == NULL);
+    assert(FT_containsFile("a/shared_prefix_38/x") == FALSE);
+    assert(FT_containsDir("a/shared_prefix_") == FALSE);
+    assert(FT_containsDir("a/") == FALSE);
+    assert(FT_containsDir("b") == FALSE);
+    assert(FT_containsDir("a/b") == TRUE);
+    assert(FT_insertDir("a/b") == ALREADY_IN_TREE);
+    assert(FT_insertDir("a/b/c") == SUCCESS);
+    assert(FT_containsDir("a/b/c") == TRUE);
+    assert(FT_freeze() == SUCCESS);
+    assert(FT_replaceFileContents("a/shared_prefix_00", "thawed", 7)
+           != NULL);
+    assert(!strcmp(FT_getFileContents("a/shared_prefix_00"),
+                   "thawed"));
+    assert(FT_freeze() == SUCCESS);
+    assert(FT_rmDir("a/b") == SUCCESS);
+    assert(FT_containsDir("a/b/c") == FALSE);
+    assert(FT_destroy() == SUCCESS);
+  }
+
+  /* the streamed listing matches FT_toString, and the walk can be
+     stopped early */
+  assert(FT_write(stderr) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_write(stderr) == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/F", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("a/G", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/d") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "a\na/G\na/b\na/b/F\na/b/c\na/d\n"));
+  assert((stream = tmpfile()) != NULL);
+  assert(FT_write(stream) == SUCCESS);
+  assert((size_t) ftell(stream) == strlen(temp));
+  rewind(stream);
+  assert(fread(arr, 1, sizeof(arr), stream) == strlen(temp));
+  assert(!strncmp(arr, temp, strlen(temp)));
+  fclose(stream);
+  free(temp);
+  i = 4;
+  assert(FT_forEachLine(countDown, &i) == NO_SUCH_PATH);
+  assert(i == 0);
+  i = 100;
+  assert(FT_forEachLine(countDown, &i) == SUCCESS);
+  assert(i == 94);
+  assert(FT_destroy() == SUCCESS);
+
+  /* bulk loads match the equivalent single insertions in sorted
+     order, whether or not the input is sorted, and stop at the first
+     entry that cannot be inserted */
+  assert(FT_insertMany(manyDirs, NULL, NULL, 3)
+         == INITIALIZATION_ERROR);
+  assert(FT_initWithOptions(FT_PATH_INDEX) == SUCCESS);
+  assert(FT_insertMany(manyDirs, NULL, NULL, 0) == SUCCESS);
+  assert(FT_insertMany(manyDirs, NULL, NULL, 3) == SUCCESS);
+  assert(FT_insertMany(manyFiles, manyContents, manyLengths, 4)
+         == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "a\na/b\na/b/F\na/b/G\na/b/c\na/b/c/H\n"
+                       "a/b-c\na/b-c/I\n"));
+  free(temp);
+  assert(!strcmp(FT_getFileContents("a/b/c/H"), "H"));
+  assert(FT_stat("a/b-c/I", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 2);
+  assert(FT_insertMany(manyDirs, NULL, NULL, 3) == ALREADY_IN_TREE);
+  assert(FT_insertMany(badDirs, NULL, NULL, 3) == CONFLICTING_PATH);
+  assert(FT_containsDir("a/d") == TRUE);
+  assert(FT_containsDir("a/x") == TRUE);
+  assert(FT_insertMany(badDirs + 3, NULL, NULL, 1) == NOT_A_DIRECTORY);
+  assert(FT_containsDir("a/b/F/x") == FALSE);
+  assert(FT_insertMany(manyFiles, manyContents, manyLengths, 1)
+         == ALREADY_IN_TREE);
+  assert(FT_destroy() == SUCCESS);
+
+  /* trees created with FT_new are independent of each other and of
+     the tree behind the FT_* functions */
+  assert((ft1 = FT_new(0)) != NULL);
+  assert((ft2 = FT_new(FT_PATH_INDEX | FT_ARENA)) != NULL);
+  assert(FT_insertDirIn(ft1, "a/b") == SUCCESS);
+  assert(FT_insertDirIn(ft2, "x/y") == SUCCESS);
+  assert(FT_insertFileIn(ft2, "x/y/F", "two", 4) == SUCCESS);
+  assert(FT_insertDirIn(ft1, "x") == CONFLICTING_PATH);
+  assert(FT_containsDirIn(ft1, "a/b") == TRUE);
+  assert(FT_containsDirIn(ft2, "a/b") == FALSE);
+  assert(FT_containsFileIn(ft2, "x/y/F") == TRUE);
+  assert(!strcmp(FT_getFileContentsIn(ft2, "x/y/F"), "two"));
+  assert(FT_statIn(ft1, "a", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  assert(FT_containsDir("a/b") == FALSE);
+  assert((temp = FT_toStringIn(ft2)) != NULL);
+  assert(!strcmp(temp, "x\nx/y\nx/y/F\n"));
+  free(temp);
+  assert(FT_rmDirIn(ft1, "a") == SUCCESS);
+  assert(FT_containsDirIn(ft1, "a") == FALSE);
+  assert(FT_insertDirIn(ft1, "x") == SUCCESS);
+  FT_free(ft1);
+  assert(FT_containsFileIn(ft2, "x/y/F") == TRUE);
+  FT_free(ft2);
+  FT_free(NULL);
+
+  /* a snapshot lists and answers lookups as its tree did when it was
+     taken, whatever becomes of the tree, including for names that
+     share prefixes across blocks of front-coded names */
+  assert((ft1 = FT_new(0)) != NULL);
+  assert((snapshot = FT_newSnapshot(ft1)) != NULL);
+  assert(FT_containsDirInSnapshot(snapshot, "a") == FALSE);
+  assert((temp = FT_toStringInSnapshot(snapshot)) != NULL);
+  assert(!strcmp(temp, ""));
+  free(temp);
+  FT_freeSnapshot(snapshot);
+  assert(FT_insertDirIn(ft1, "a/b/c") == SUCCESS);
+  assert(FT_insertDirIn(ft1, "a/bb") == SUCCESS);
+  assert(FT_insertDirIn(ft1, "a/b-c/d") == SUCCESS);
+  assert(FT_insertFileIn(ft1, "a/b/c/F", NULL, 300) == SUCCESS);
+  assert(FT_insertFileIn(ft1, "a/ab", NULL, 1) == SUCCESS);
+  for(l = 0; l < 40; l += 2) {
+    sprintf(arr, "a/bb/shared_prefix_%02lu", (unsigned long) l);
+    assert(FT_insertFileIn(ft1, arr, NULL, l) == SUCCESS);
+    sprintf(arr, "a/bb/shared_prefix_%02lu_d/x", (unsigned long) l);
+    assert(FT_insertDirIn(ft1, arr) == SUCCESS);
+  }
+  assert((temp = FT_toStringIn(ft1)) != NULL);
+  assert((snapshot = FT_newSnapshot(ft1)) != NULL);
+  assert(FT_rmDirIn(ft1, "a/bb") == SUCCESS);
+  assert((temp2 = FT_toStringInSnapshot(snapshot)) != NULL);
+  assert(!strcmp(temp, temp2));
+  free(temp);
+  free(temp2);
+  FT_free(ft1);
+  for(l = 0; l < 40; l++) {
+    sprintf(arr, "a/bb/shared_prefix_%02lu", (unsigned long) l);
+    assert(FT_containsFileInSnapshot(snapshot, arr) == (l % 2 == 0));
+    assert(FT_containsDirInSnapshot(snapshot, arr) == FALSE);
+    assert(FT_statInSnapshot(snapshot, arr, &b, &k)
+           == (l % 2 == 0 ? SUCCESS : NO_SUCH_PATH));
+    assert(l % 2 != 0 || (b == TRUE && k == l));
+    sprintf(arr, "a/bb/shared_prefix_%02lu_d/x", (unsigned long) l);
+    assert(FT_containsDirInSnapshot(snapshot, arr) == (l % 2 == 0));
+  }
+  assert(FT_statInSnapshot(snapshot, "a/b/c/F", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 300);
+  assert(FT_statInSnapshot(snapshot, "a/b-c", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  assert(FT_containsFileInSnapshot(snapshot, "a/ab") == TRUE);
+  assert(FT_containsDirInSnapshot(snapshot, "a/b/c") == TRUE);
+  assert(FT_containsDirInSnapshot(snapshot, "a/b/c/F") == FALSE);
+  assert(FT_containsFileInSnapshot(snapshot, "a/b/c/F/x") == FALSE);
+  assert(FT_containsDirInSnapshot(snapshot, "a/b-") == FALSE);
+  assert(FT_containsDirInSnapshot(snapshot, "a/bbb") == FALSE);
+  assert(FT_containsDirInSnapshot(snapshot, "a/") == FALSE);
+  assert(FT_containsDirInSnapshot(snapshot, "b") == FALSE);
+  assert(FT_statInSnapshot(snapshot, "a/a", &b, &l) == NO_SUCH_PATH);
+  i = 4;
+  assert(FT_forEachLineInSnapshot(snapshot, countDown, &i)
+         == NO_SUCH_PATH);
+  assert(i == 0);
+  FT_freeSnapshot(snapshot);
+  FT_freeSnapshot(NULL);
+
+  /* a forest takes any number of roots, spread over its shards, and
+     lists them in order of name */
+  assert((forest = FT_newForest(3, FT_ARENA)) != NULL);
+  assert(FT_insertDirInForest(forest, "m/n") == SUCCESS);
+  assert(FT_insertDirInForest(forest, "b") == SUCCESS);
+  assert(FT_insertDirInForest(forest, "z/y") == SUCCESS);
+  assert(FT_insertDirInForest(forest, "a") == SUCCESS);
+  assert(FT_insertDirInForest(forest, "c") == SUCCESS);
+  assert(FT_insertDirInForest(forest, "b") == ALREADY_IN_TREE);
+  assert(FT_insertFileInForest(forest, "F", NULL, 0)
+         == CONFLICTING_PATH);
+  assert(FT_insertFileInForest(forest, "m/n/F", "f", 2) == SUCCESS);
+  assert(FT_insertDirInForest(forest, "m/n/F/x") == NOT_A_DIRECTORY);
+  assert(FT_insertFileInForest(forest, "m/G", NULL, 0) == SUCCESS);
+  assert(FT_containsDirInForest(forest, "z/y") == TRUE);
+  assert(FT_containsDirInForest(forest, "y") == FALSE);
+  assert(FT_containsFileInForest(forest, "m/n/F") == TRUE);
+  assert(!strcmp(FT_getFileContentsInForest(forest, "m/n/F"), "f"));
+  assert(!strcmp(FT_replaceFileContentsInForest(forest, "m/n/F",
+                                                "g", 2), "f"));
+  assert(FT_statInForest(forest, "m/n/F", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 2);
+  assert(FT_statInForest(forest, "q", &b, &l) == NO_SUCH_PATH);
+  assert((temp = FT_toStringInForest(forest)) != NULL);
+  assert(!strcmp(temp, "a\nb\nc\nm\nm/G\nm/n\nm/n/F\nz\nz/y\n"));
+  free(temp);
+  assert(FT_rmFileInForest(forest, "m/G") == SUCCESS);
+  assert(FT_rmDirInForest(forest, "m") == SUCCESS);
+  assert(FT_rmDirInForest(forest, "m") == NO_SUCH_PATH);
+  assert(FT_rmDirInForest(forest, "z/y") == SUCCESS);
+  assert((temp = FT_toStringInForest(forest)) != NULL);
+  assert(!strcmp(temp, "a\nb\nc\nz\n"));
+  free(temp);
+  FT_freeForest(forest);
+  FT_freeForest(NULL);
+  assert(FT_newForest(0, 0) == NULL);
+
+  /* a name too long for a chunk of the tree's slab is stored on its
+     own, and is found, listed and removed like any other, again and
+     again, with or without locks */
+  assert((temp = malloc(LONG_NAME + 5)) != NULL);
+  temp[0] = 'a';
+  temp[1] = '/';
+  memset(temp + 2, 'n', LONG_NAME);
+  strcpy(temp + 2 + LONG_NAME, "/F");
+  for(i = 0; i < 2; i++) {
+    assert(FT_initWithOptions(i == 1 ? FT_CONCURRENT : 0) == SUCCESS);
+    for(l = 0; l < 3; l++) {
+      assert(FT_insertFile(temp, "long", 5) == SUCCESS);
+      assert(FT_containsFile(temp) == TRUE);
+      temp[2 + LONG_NAME] = '\0';
+      assert(FT_containsDir(temp) == TRUE);
+      assert(FT_insertDir(temp) == ALREADY_IN_TREE);
+      temp[2 + LONG_NAME] = '/';
+      assert((temp2 = FT_toString()) != NULL);
+      assert(strlen(temp2) == 2 * LONG_NAME + 10);
+      assert(!strncmp(temp2, "a\n", 2));
+      assert(!strncmp(temp2 + 2, temp, LONG_NAME + 2));
+      assert(temp2[LONG_NAME + 4] == '\n');
+      assert(!strncmp(temp2 + LONG_NAME + 5, temp, LONG_NAME + 4));
+      assert(!strcmp(temp2 + 2 * LONG_NAME + 9, "\n"));
+      free(temp2);
+      assert(FT_rmDir("a") == SUCCESS);
+      assert(FT_containsFile(temp) == FALSE);
+    }
+    assert(FT_destroy() == SUCCESS);
+  }
+  free(temp);
+
   return 0;
 }
 
@@ -0,0 +1,476 @@
+/*--------------------------------------------------------------------*/
+/* ft_thread_client.c                                                 */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthreads, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "ft.h"
+
+/* The number of writer threads and of reader threads, and the width
+   of the subtree each writer builds. */
+enum { WRITERS = 8, READERS = 4, WIDTH = 12, ROUNDS = 20 };
+
+/* The tree under test, and a flag telling the readers to stop. */
+static FT_T tree;
+static int done;
+
+/* Counts the lines of a listing into *(size_t*)ctx, checking that
+   every one lies beneath the root. */
+static int countLine(const char* line, size_t length, void* ctx) {
+  assert(line[0] == 'r');
+  assert(strlen(line) == length);
+  (*(size_t*)ctx)++;
+  return SUCCESS;
+}
+
+/* Builds, changes and partly removes the subtree r/w, for the writer
+   w given by pvArg, while also adding entries to the directory r/s
+   that every writer shares. */
+static void *writeTree(void *pvArg) {
+  int w = *(int*)pvArg;
+  char path[64];
+  int round, i, j;
+  boolean type;
+  size_t length;
+
+  for(round = 0; round < ROUNDS; round++) {
+    for(i = 0; i < WIDTH; i++)
+      for(j = 0; j < WIDTH; j++) {
+        sprintf(path, "r/%d/%d/%d", w, i, j);
+        assert(FT_insertDirIn(tree, path) == SUCCESS);
+        sprintf(path, "r/%d/%d/%d/f", w, i, j);
+        assert(FT_insertFileIn(tree, path, path, 1) == SUCCESS);
+        assert(FT_replaceFileContentsIn(tree, path, NULL, 2) == path);
+        assert(FT_statIn(tree, path, &type, &length) == SUCCESS);
+        assert(type == TRUE && length == 2);
+      }
+
+    sprintf(path, "r/s/%d-%d", w, round);
+    assert(FT_insertFileIn(tree, path, NULL, 0) == SUCCESS);
+
+    /* remove all but the last round's subtree, alternating between
+       removing directories whole and removing their files first */
+    if(round + 1 < ROUNDS) {
+      for(i = 0; i < WIDTH; i++) {
+        if(round % 2 == 1) {
+          for(j = 0; j < WIDTH; j++) {
+            sprintf(path, "r/%d/%d/%d/f", w, i, j);
+            assert(FT_rmFileIn(tree, path) == SUCCESS);
+            assert(FT_rmFileIn(tree, path) == NO_SUCH_PATH);
+          }
+        }
+        sprintf(path, "r/%d/%d", w, i);
+        assert(FT_rmDirIn(tree, path) == SUCCESS);
+        assert(FT_containsDirIn(tree, path) == FALSE);
+      }
+    }
+  }
+  return NULL;
+}
+
+/* Checks that string, a listing taken while writers changed the tree,
+   is whole: lines that each start with 'r' and end with a newline.
+   Frees string. */
+static void checkString(char* string) {
+  char* line;
+
+  assert(string != NULL);
+  for(line = string; *line != '\0'; line = strchr(line, '\n') + 1) {
+    assert(line[0] == 'r');
+    assert(strchr(line, '\n') != NULL);
+  }
+  free(string);
+}
+
+/* Looks up, stats and lists the tree until the writers are done. */
+static void *readTree(void *pvArg) {
+  char path[64];
+  size_t lines;
+  boolean type;
+  size_t length;
+  int i = 0;
+
+  (void)pvArg;
+  while(!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+    sprintf(path, "r/%d/%d/%d/f", i % WRITERS, i % WIDTH,
+            (i / WIDTH) % WIDTH);
+    if(FT_containsFileIn(tree, path))
+      (void)FT_getFileContentsIn(tree, path);
+    if(FT_statIn(tree, path, &type, &length) == SUCCESS)
+      assert(type == TRUE);
+    sprintf(path, "r/%d/%d", i % WRITERS, i % WIDTH);
+    if(FT_statIn(tree, path, &type, &length) == SUCCESS)
+      assert(type == FALSE);
+
+    if(i % 256 == 0) {
+      lines = 0;
+      assert(FT_forEachLineIn(tree, countLine, &lines) == SUCCESS);
+      assert(lines >= 2);
+      /* the listing grows as it is copied, which must not overflow */
+      checkString(FT_toStringIn(tree));
+    }
+    i++;
+  }
+  return NULL;
+}
+
+/* Runs the writers and readers on a new tree with options, then
+   checks what the writers left behind. */
+static void run(unsigned int options) {
+  pthread_t writers[WRITERS];
+  pthread_t readers[READERS];
+  int ids[WRITERS];
+  char path[64];
+  size_t lines;
+  int w, i, j;
+
+  tree = FT_new(options);
+  assert(tree != NULL);
+  assert(FT_insertDirIn(tree, "r") == SUCCESS);
+  assert(FT_insertDirIn(tree, "r/s") == SUCCESS);
+  done = 0;
+
+  /* the readers start on a frozen copy, which the first writer thaws
+     from under them */
+  assert(FT_freezeIn(tree) == SUCCESS);
+
+  for(i = 0; i < READERS; i++)
+    assert(pthread_create(&readers[i], NULL, readTree, NULL) == 0);
+  for(w = 0; w < WRITERS; w++) {
+    ids[w] = w;
+    assert(pthread_create(&writers[w], NULL, writeTree,
+                          &ids[w]) == 0);
+  }
+  for(w = 0; w < WRITERS; w++)
+    assert(pthread_join(writers[w], NULL) == 0);
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+  for(i = 0; i < READERS; i++)
+    assert(pthread_join(readers[i], NULL) == 0);
+
+  /* each writer's last round is left, along with the shared files */
+  for(w = 0; w < WRITERS; w++)
+    for(i = 0; i < WIDTH; i++)
+      for(j = 0; j < WIDTH; j++) {
+        sprintf(path, "r/%d/%d/%d/f", w, i, j);
+        assert(FT_containsFileIn(tree, path) == TRUE);
+      }
+  for(w = 0; w < WRITERS; w++)
+    for(i = 0; i < ROUNDS; i++) {
+      sprintf(path, "r/s/%d-%d", w, i);
+      assert(FT_containsFileIn(tree, path) == TRUE);
+    }
+
+  /* r, r/s, and per writer: r/w, its WIDTH directories, and their
+     WIDTH^2 directories and files, plus ROUNDS shared files */
+  lines = 0;
+  assert(FT_forEachLineIn(tree, countLine, &lines) == SUCCESS);
+  assert(lines == 2 + WRITERS * (1 + WIDTH + 2 * WIDTH * WIDTH +
+                                 ROUNDS));
+
+  assert(FT_rmDirIn(tree, "r") == SUCCESS);
+  assert(FT_containsDirIn(tree, "r") == FALSE);
+  FT_free(tree);
+}
+
+/* The number of threads that insert into and remove overlapping
+   nested directories, the depth and width of the hierarchy they share,
+   and the number of changes each makes. */
+enum { NESTERS = 16, NEST_DEPTH = 4, NEST_WIDTH = 3,
+       NEST_STEPS = 20000 };
+
+/* Makes random changes throughout the hierarchy beneath n, for the
+   nester whose number is given by pvArg: inserting a directory or a
+   file deep down, or removing a directory at any depth, so that
+   removals of a directory and of its ancestors overlap insertions
+   beneath them. */
+static void *nest(void *pvArg) {
+  unsigned long seed = (unsigned long)*(int*)pvArg + 1;
+  char path[64];
+  size_t length;
+  size_t size;
+  int step, depth, d, result;
+  boolean type;
+
+  for(step = 0; step < NEST_STEPS; step++) {
+    seed = seed * 1103515245UL + 12345UL;
+    depth = 1 + (int)((seed >> 8) % NEST_DEPTH);
+    length = 1;
+    strcpy(path, "n");
+    for(d = 0; d < depth; d++) {
+      seed = seed * 1103515245UL + 12345UL;
+      length += (size_t)sprintf(path + length, "/%c",
+                                'a' + (int)((seed >> 8) % NEST_WIDTH));
+    }
+
+    switch((seed >> 16) % 4) {
+      case 0:
+        result = FT_insertDirIn(tree, path);
+        assert(result == SUCCESS || result == ALREADY_IN_TREE ||
+               result == NOT_A_DIRECTORY);
+        break;
+      case 1:
+        strcpy(path + length, "/f");
+        result = FT_insertFileIn(tree, path, path, 1);
+        assert(result == SUCCESS || result == ALREADY_IN_TREE ||
+               result == NOT_A_DIRECTORY);
+        break;
+      case 2:
+        result = FT_rmDirIn(tree, path);
+        assert(result == SUCCESS || result == NO_SUCH_PATH);
+        break;
+      default:
+        result = FT_statIn(tree, path, &type, &size);
+        assert(result == SUCCESS || result == NO_SUCH_PATH);
+        assert(result == NO_SUCH_PATH || type == FALSE);
+        break;
+    }
+  }
+  (void)result;
+  return NULL;
+}
+
+/* Checks that the line of a listing of the nested hierarchy names
+   an entry that some nester could have inserted, counting the lines
+   into *(size_t*)ctx. */
+static int checkNested(const char* line, size_t length, void* ctx) {
+  size_t i;
+
+  assert(strlen(line) == length);
+  assert(line[0] == 'n');
+  for(i = 1; i < length; i += 2) {
+    assert(line[i] == '/');
+    assert((line[i + 1] >= 'a' && line[i + 1] < 'a' + NEST_WIDTH) ||
+           (line[i + 1] == 'f' && i + 2 == length));
+  }
+  assert(length <= 2 * (NEST_DEPTH + 1) + 1);
+  (*(size_t*)ctx)++;
+  return SUCCESS;
+}
+
+/* Runs the nesters on a new tree with options, then checks that the
+   hierarchy they leave is well formed and can be removed whole. */
+static void runNested(unsigned int options) {
+  pthread_t nesters[NESTERS];
+  int ids[NESTERS];
+  size_t lines;
+  int i;
+
+  tree = FT_new(options);
+  assert(tree != NULL);
+  assert(FT_insertDirIn(tree, "n") == SUCCESS);
+
+  for(i = 0; i < NESTERS; i++) {
+    ids[i] = i;
+    assert(pthread_create(&nesters[i], NULL, nest, &ids[i]) == 0);
+  }
+  for(i = 0; i < NESTERS; i++)
+    assert(pthread_join(nesters[i], NULL) == 0);
+
+  lines = 0;
+  assert(FT_forEachLineIn(tree, checkNested, &lines) == SUCCESS);
+  assert(lines >= 1);
+  assert(FT_rmDirIn(tree, "n") == SUCCESS);
+  assert(FT_containsDirIn(tree, "n") == FALSE);
+  FT_free(tree);
+}
+
+/* The queue under test, and the number of its submitters that
+   inserted the directory they all race for. */
+static FT_Queue_T queue;
+static int commonWins;
+
+/* Submits, through the queue, the building, changing and partial
+   removal of the subtree q/w, for the submitter w given by pvArg. */
+static void *submit(void *pvArg) {
+  int w = *(int*)pvArg;
+  char path[64];
+  int i, result;
+
+  result = FT_queueInsertDir(queue, "q/common");
+  assert(result == SUCCESS || result == ALREADY_IN_TREE);
+  if(result == SUCCESS)
+    __atomic_add_fetch(&commonWins, 1, __ATOMIC_RELAXED);
+
+  for(i = 0; i < WIDTH * WIDTH; i++) {
+    sprintf(path, "q/%d/%d", w, i);
+    assert(FT_queueInsertDir(queue, path) == SUCCESS);
+    assert(FT_queueInsertDir(queue, path) == ALREADY_IN_TREE);
+    sprintf(path, "q/%d/%d/f", w, i);
+    assert(FT_queueInsertFile(queue, path, path, 1) == SUCCESS);
+    assert(FT_queueReplaceFileContents(queue, path, NULL, 2) == path);
+    if(i % 2 == 1)
+      assert(FT_queueRmFile(queue, path) == SUCCESS);
+    if(i % 3 == 2) {
+      sprintf(path, "q/%d/%d", w, i);
+      assert(FT_queueRmDir(queue, path) == SUCCESS);
+      assert(FT_queueRmDir(queue, path) == NO_SUCH_PATH);
+    }
+  }
+  sprintf(path, "q/%d/x", w);
+  assert(FT_queueInsertFile(queue, path, NULL, 0) == SUCCESS);
+  sprintf(path, "q/%d/x/y", w);
+  assert(FT_queueInsertDir(queue, path) == NOT_A_DIRECTORY);
+  assert(FT_queueInsertDir(queue, "elsewhere") == CONFLICTING_PATH);
+  return NULL;
+}
+
+/* Runs the submitters on a new queue to a tree with options, then
+   checks what they left behind. */
+static void runQueue(unsigned int options) {
+  pthread_t submitters[WRITERS];
+  int ids[WRITERS];
+  char path[64];
+  size_t length;
+  boolean type;
+  int w, i;
+
+  tree = FT_new(options);
+  assert(tree != NULL);
+  queue = FT_newQueue(tree);
+  assert(queue != NULL);
+  commonWins = 0;
+
+  assert(FT_queueInsertDir(queue, "q") == SUCCESS);
+  for(w = 0; w < WRITERS; w++) {
+    ids[w] = w;
+    assert(pthread_create(&submitters[w], NULL, submit,
+                          &ids[w]) == 0);
+  }
+  for(w = 0; w < WRITERS; w++)
+    assert(pthread_join(submitters[w], NULL) == 0);
+  FT_freeQueue(queue);
+
+  assert(commonWins == 1);
+  for(w = 0; w < WRITERS; w++)
+    for(i = 0; i < WIDTH * WIDTH; i++) {
+      sprintf(path, "q/%d/%d", w, i);
+      assert(FT_containsDirIn(tree, path) == (i % 3 != 2));
+      sprintf(path, "q/%d/%d/f", w, i);
+      if(i % 3 != 2 && i % 2 == 0) {
+        assert(FT_statIn(tree, path, &type, &length) == SUCCESS);
+        assert(type == TRUE && length == 2);
+      }
+      else
+        assert(FT_containsFileIn(tree, path) == FALSE);
+    }
+  FT_free(tree);
+}
+
+/* The forest under test. */
+static FT_Forest_T forest;
+
+/* Builds and partly removes roots of the forest for the thread w
+   given by pvArg: w's roots are named w-0, w-1, and so on. */
+static void *plant(void *pvArg) {
+  int w = *(int*)pvArg;
+  char path[64];
+  int i, j;
+
+  for(i = 0; i < WIDTH; i++) {
+    for(j = 0; j < WIDTH; j++) {
+      sprintf(path, "%d-%d/%d", w, i, j);
+      assert(FT_insertDirInForest(forest, path) == SUCCESS);
+      sprintf(path, "%d-%d/%d/f", w, i, j);
+      assert(FT_insertFileInForest(forest, path, NULL, 0) == SUCCESS);
+      assert(FT_containsFileInForest(forest, path) == TRUE);
+    }
+    if(i % 2 == 1) {
+      sprintf(path, "%d-%d", w, i);
+      assert(FT_rmDirInForest(forest, path) == SUCCESS);
+    }
+  }
+  return NULL;
+}
+
+/* The state of a check of a forest's listing: the root of the last
+   line, and the number of lines so far. */
+struct Listing {
+  char root[32];
+  size_t lines;
+};
+
+/* Checks that line, of length length, is listed in order of roots
+   after the last line listed in the Listing ctx, and counts it. */
+static int checkRootOrder(const char* line, size_t length, void* ctx) {
+  struct Listing* listing = ctx;
+  char root[32];
+  size_t rootLength = strcspn(line, "/");
+
+  assert(strlen(line) == length);
+  assert(rootLength < sizeof(root));
+  memcpy(root, line, rootLength);
+  root[rootLength] = '\0';
+  assert(strcmp(listing->root, root) <= 0);
+  strcpy(listing->root, root);
+  listing->lines++;
+  return SUCCESS;
+}
+
+/* Runs threads planting roots in a new forest of shards shards with
+   options, while the forest is listed, then checks what they left. */
+static void runForest(size_t shards, unsigned int options) {
+  pthread_t planters[WRITERS];
+  int ids[WRITERS];
+  struct Listing listing;
+  int w;
+
+  forest = FT_newForest(shards, options);
+  assert(forest != NULL);
+
+  for(w = 0; w < WRITERS; w++) {
+    ids[w] = w;
+    assert(pthread_create(&planters[w], NULL, plant, &ids[w]) == 0);
+  }
+  for(w = 0; w < 20; w++) {
+    listing.root[0] = '\0';
+    listing.lines = 0;
+    assert(FT_forEachLineInForest(forest, checkRootOrder, &listing)
+           == SUCCESS);
+    free(FT_toStringInForest(forest));
+  }
+  for(w = 0; w < WRITERS; w++)
+    assert(pthread_join(planters[w], NULL) == 0);
+
+  /* the even roots remain, each with WIDTH directories and files */
+  listing.root[0] = '\0';
+  listing.lines = 0;
+  assert(FT_forEachLineInForest(forest, checkRootOrder, &listing)
+         == SUCCESS);
+  assert(listing.lines == WRITERS * (WIDTH / 2) * (1 + 2 * WIDTH));
+  FT_freeForest(forest);
+}
+
+int main(void) {
+  run(FT_CONCURRENT);
+  run(FT_CONCURRENT | FT_ARENA);
+  /* the index is ignored by a concurrent tree */
+  run(FT_CONCURRENT | FT_PATH_INDEX);
+  /* removed hierarchies are freed by a pool as the writers go on */
+  run(FT_CONCURRENT | FT_ARENA | FT_PARALLEL_FREE);
+
+  /* removals of a directory and of its ancestors overlap insertions
+     beneath them */
+  runNested(FT_CONCURRENT);
+  runNested(FT_CONCURRENT | FT_ARENA | FT_PARALLEL_FREE);
+
+  runQueue(0);
+  runQueue(FT_PATH_INDEX | FT_ARENA);
+  runQueue(FT_CONCURRENT);
+  runQueue(FT_PARALLEL_FREE);
+
+  runForest(1, 0);
+  runForest(7, FT_ARENA);
+  runForest(4, FT_WORKERS);
+  runForest(3, FT_PARALLEL_FREE);
+
+  fprintf(stderr, "Concurrent File Tree tests passed\n");
+  return 0;
+}
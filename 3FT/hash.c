@@ -0,0 +1,52 @@
+/*--------------------------------------------------------------------*/
+/* hash.c                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "hash.h"
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The FNV-1a offset basis, the hash of no bytes, and the prime by
+   which the hash multiplies for each byte. */
+
+static const size_t uFnvBasis = (size_t)0xcbf29ce484222325UL;
+static const size_t uFnvPrime = (size_t)0x100000001b3UL;
+
+/*--------------------------------------------------------------------*/
+
+size_t Hash_bytes(const char *pc, size_t uLength)
+{
+   return Hash_continue(uFnvBasis, pc, uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Hash_continue(size_t uHash, const char *pc, size_t uLength)
+{
+   assert(pc != NULL || uLength == 0);
+
+   while (uLength-- > 0)
+   {
+      uHash ^= (size_t)(unsigned char)*pc++;
+      uHash *= uFnvPrime;
+   }
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Hash_key(const char *pcKey)
+{
+   size_t uHash = uFnvBasis;
+
+   assert(pcKey != NULL);
+
+   for (; *pcKey != '\0' && *pcKey != '/'; pcKey++)
+   {
+      uHash ^= (size_t)(unsigned char)*pcKey;
+      uHash *= uFnvPrime;
+   }
+   return uHash;
+}
@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------*/
+/* hash.h                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef HASH_INCLUDED
+#define HASH_INCLUDED
+
+#include <stddef.h>
+
+/* The Hash_ functions compute the FNV-1a hash of names and paths,
+   the one hash function that the modules of a tree share.  FNV-1a
+   folds in a byte at a time, so the hash of a string may be built a
+   piece at a time: the hash of a path continues the hash of its
+   parent's path. */
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of the uLength bytes at pc. */
+
+size_t Hash_bytes(const char *pc, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of the bytes that uHash is the hash of, followed by
+   the uLength bytes at pc. */
+
+size_t Hash_continue(size_t uHash, const char *pc, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of pcKey, a name that ends at its first slash, if
+   it has one, as if the name were all that pcKey held. */
+
+size_t Hash_key(const char *pcKey);
+
+#endif
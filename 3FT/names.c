@@ -0,0 +1,292 @@
+/*--------------------------------------------------------------------*/
+/* names.c                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthread_mutex_t, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include "names.h"
+#include "hash.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of buckets with which the table starts, when its first
+   name is interned. */
+
+enum { MIN_BUCKETS = 64 };
+
+/*--------------------------------------------------------------------*/
+
+/* A Name is the record of an interned name, which follows it in the
+   record. */
+
+struct Name
+{
+   /* The slab index of the next Name in the same bucket, or 0. */
+   unsigned int uNext;
+
+   /* The number of uses of the name. */
+   unsigned int uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Names consists of a hash table of Names, chained through their
+   uNext indices. */
+
+struct Names
+{
+   /* The Slab from which the Names come. */
+   Slab_T oSlab;
+
+   /* The slab index of the first Name in each of the uBuckets
+      buckets, or 0, with uBuckets a power of 2, or NULL until the
+      first name is interned. */
+   unsigned int *puBuckets;
+   size_t uBuckets;
+
+   /* The number of distinct names interned. */
+   size_t uLength;
+
+   /* The mutex serializing the use of shared Names, or NULL if the
+      Names are not shared. */
+   pthread_mutex_t *psLock;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name that follows psName. */
+
+static char *Names_text(struct Name *psName)
+{
+   assert(psName != NULL);
+
+   return (char*)(psName + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+Names_T Names_new(Slab_T oSlab, int iShared)
+{
+   Names_T oNames;
+
+   assert(oSlab != NULL);
+
+   oNames = (Names_T)malloc(sizeof(struct Names));
+   if (oNames == NULL)
+      return NULL;
+
+   oNames->oSlab = oSlab;
+   oNames->puBuckets = NULL;
+   oNames->uBuckets = 0;
+   oNames->uLength = 0;
+   oNames->psLock = NULL;
+
+   if (!iShared)
+      return oNames;
+
+   oNames->psLock = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+   if (oNames->psLock == NULL)
+   {
+      free(oNames);
+      return NULL;
+   }
+   if (pthread_mutex_init(oNames->psLock, NULL) != 0)
+   {
+      free(oNames->psLock);
+      free(oNames);
+      return NULL;
+   }
+
+   return oNames;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Names_free(Names_T oNames)
+{
+   if (oNames == NULL)
+      return;
+
+   free(oNames->puBuckets);
+   if (oNames->psLock != NULL)
+   {
+      (void)pthread_mutex_destroy(oNames->psLock);
+      free(oNames->psLock);
+   }
+   free(oNames);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of buckets of oNames, or make its first ones, and
+   move each Name to its new bucket.  Return 1 (TRUE) if successful,
+   or 0 (FALSE) if insufficient memory is available. */
+
+static int Names_grow(Names_T oNames)
+{
+   unsigned int *puBuckets;
+   struct Name *psName;
+   size_t uBuckets;
+   size_t uBucket;
+   size_t u;
+   unsigned int uIndex;
+   unsigned int uNext;
+
+   assert(oNames != NULL);
+
+   uBuckets = 2 * oNames->uBuckets;
+   if (uBuckets < MIN_BUCKETS)
+      uBuckets = MIN_BUCKETS;
+   puBuckets = (unsigned int*)calloc(uBuckets, sizeof(unsigned int));
+   if (puBuckets == NULL)
+      return 0;
+
+   for (u = 0; u < oNames->uBuckets; u++)
+      for (uIndex = oNames->puBuckets[u]; uIndex != 0; uIndex = uNext)
+      {
+         psName = (struct Name*)Slab_at(oNames->oSlab, uIndex);
+         uNext = psName->uNext;
+         uBucket = Hash_bytes(Names_text(psName),
+                              strlen(Names_text(psName))) &
+            (uBuckets - 1);
+         psName->uNext = puBuckets[uBucket];
+         puBuckets[uBucket] = uIndex;
+      }
+
+   free(oNames->puBuckets);
+   oNames->puBuckets = puBuckets;
+   oNames->uBuckets = uBuckets;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Intern pcName, of uLength characters, in oNames, as Names_intern
+   does, once oNames is locked if it is shared. */
+
+static const char *Names_internUnlocked(Names_T oNames,
+                                        const char *pcName,
+                                        size_t uLength)
+{
+   struct Name *psName;
+   size_t uHash;
+   size_t uBucket;
+   unsigned int uIndex;
+
+   assert(oNames != NULL);
+   assert(pcName != NULL);
+
+   uHash = Hash_bytes(pcName, uLength);
+   if (oNames->uBuckets > 0)
+      for (uIndex = oNames->puBuckets[uHash & (oNames->uBuckets - 1)];
+           uIndex != 0; uIndex = psName->uNext)
+      {
+         psName = (struct Name*)Slab_at(oNames->oSlab, uIndex);
+         if (strncmp(Names_text(psName), pcName, uLength) == 0 &&
+             Names_text(psName)[uLength] == '\0')
+         {
+            psName->uCount++;
+            return Names_text(psName);
+         }
+      }
+
+   /* The name is new.  The table grows once it holds as many names
+      as it has buckets. */
+   if (oNames->uLength == oNames->uBuckets && ! Names_grow(oNames))
+      return NULL;
+   psName = (struct Name*)Slab_alloc(oNames->oSlab,
+                                     sizeof(struct Name) + uLength + 1);
+   if (psName == NULL)
+      return NULL;
+   memcpy(Names_text(psName), pcName, uLength);
+   Names_text(psName)[uLength] = '\0';
+   psName->uCount = 1;
+
+   uBucket = uHash & (oNames->uBuckets - 1);
+   psName->uNext = oNames->puBuckets[uBucket];
+   oNames->puBuckets[uBucket] = Slab_indexOf(psName);
+   oNames->uLength++;
+   return Names_text(psName);
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *Names_intern(Names_T oNames, const char *pcName,
+                         size_t uLength)
+{
+   const char *pcInterned;
+
+   assert(oNames != NULL);
+   assert(pcName != NULL);
+
+   if (oNames->psLock == NULL)
+      return Names_internUnlocked(oNames, pcName, uLength);
+
+   (void)pthread_mutex_lock(oNames->psLock);
+   pcInterned = Names_internUnlocked(oNames, pcName, uLength);
+   (void)pthread_mutex_unlock(oNames->psLock);
+   return pcInterned;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pcName of oNames, as Names_release does, once oNames is
+   locked if it is shared. */
+
+static void Names_releaseUnlocked(Names_T oNames, const char *pcName)
+{
+   struct Name *psName;
+   struct Name *psPrevious = NULL;
+   unsigned int *puLink;
+   size_t uLength;
+   unsigned int uIndex;
+
+   assert(oNames != NULL);
+   assert(pcName != NULL);
+
+   psName = (struct Name*)pcName - 1;
+   assert(psName->uCount > 0);
+   if (--psName->uCount > 0)
+      return;
+
+   /* That was its last use, so it leaves its bucket. */
+   uLength = strlen(pcName);
+   uIndex = Slab_indexOf(psName);
+   puLink = &oNames->puBuckets[Hash_bytes(pcName, uLength) &
+                               (oNames->uBuckets - 1)];
+   while (*puLink != uIndex)
+   {
+      assert(*puLink != 0);
+      psPrevious = (struct Name*)Slab_at(oNames->oSlab, *puLink);
+      puLink = &psPrevious->uNext;
+   }
+   *puLink = psName->uNext;
+   oNames->uLength--;
+
+   Slab_release(oNames->oSlab, psName,
+                sizeof(struct Name) + uLength + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Names_release(Names_T oNames, const char *pcName)
+{
+   assert(oNames != NULL);
+   assert(pcName != NULL);
+
+   if (oNames->psLock == NULL)
+   {
+      Names_releaseUnlocked(oNames, pcName);
+      return;
+   }
+
+   (void)pthread_mutex_lock(oNames->psLock);
+   Names_releaseUnlocked(oNames, pcName);
+   (void)pthread_mutex_unlock(oNames->psLock);
+}
@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------*/
+/* names.h                                                            */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef NAMES_INCLUDED
+#define NAMES_INCLUDED
+
+#include <stddef.h>
+#include "slab.h"
+
+/* A Names_T object is a table of interned names: it keeps one copy of
+   each distinct name in use, in records of a Slab_T, however many
+   times it is used, and counts its uses, so that a name is freed with
+   its last.  Since each name has a single copy, two interned names
+   are equal exactly when their addresses are.  An interned name never
+   moves, and may be read without locking by any thread that has
+   learned of it through some other synchronization with the thread
+   that interned it. */
+
+typedef struct Names *Names_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Names_T object, which keeps its names in
+   oSlab, or NULL if insufficient memory is available.  If iShared is
+   1 (TRUE), the Names may be used by several threads at once: its
+   interning and releasing are serialized by a mutex. */
+
+Names_T Names_new(Slab_T oSlab, int iShared);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oNames, but not the names still interned in it, which go with
+   its Slab_T.  oNames may be NULL, in which case nothing is freed. */
+
+void Names_free(Names_T oNames);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the interned copy of the uLength characters at pcName, which
+   contain no '\0', interning it if it is not interned already, and
+   count one more use of it.  Return NULL if insufficient memory is
+   available. */
+
+const char *Names_intern(Names_T oNames, const char *pcName,
+                         size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* Count one use fewer of the interned name pcName of oNames, freeing
+   it if that was its last. */
+
+void Names_release(Names_T oNames, const char *pcName);
+
+#endif
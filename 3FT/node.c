@@ -3,294 +3,1064 @@
 /* Authors: Misrach Ewunetie, Shruti Roy                              */
 /*--------------------------------------------------------------------*/
 
+/* for pthread_rwlock_t, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#include <pthread.h>
 
-#include "dynarray.h"
+#include "childset.h"
+#include "epoch.h"
 #include "file.h"
+#include "names.h"
 #include "node.h"
+#include "slab.h"
+
+/* The most children that a directory keeps within its own node. */
+enum { NODE_INLINE = 3 };
 
 /*
-   A node structure represents a directory in the directory tree
+   What a directory of a tree shared between threads needs, allocated
+   only for such a tree.
+*/
+struct node_sharing {
+   /* the lock guarding the children of this directory and their
+      contents */
+   pthread_rwlock_t lock;
+
+   /* the epoch to which replaced children sets are retired, or NULL
+      if the set is changed in place */
+   Epoch_T epoch;
+};
+
+/*
+   A node structure represents a directory in the directory tree. It
+   comes from the slab of its tree, and its name, the last component
+   of its path, is interned in the names attached to that slab, so
+   that a name shared by many directories and files is kept once.
+   Directories refer to their parents and children, within the node
+   and in its set of children alike, by their indices in that slab,
+   which take half the space of pointers.
 */
 struct node {
-   /* the full path of this directory */
-   char* path;
+   /* the index of the parent directory of this directory
+      0 for the root of the directory tree */
+   unsigned int parent;
+
+   /* while there are at most NODE_INLINE children and this directory
+      has no epoch, the children in order of name, each as made by
+      Node_toEntry, the rest 0, with many NULL */
+   unsigned int few[NODE_INLINE];
 
-   /* the parent directory of this directory
-      NULL for the root of the directory tree */
-   Node_T parent;
+   /* otherwise, the files and subdirectories of this directory
+      together, by name, each as made by Node_toEntry, or NULL while
+      there are none */
+   ChildSet_T many;
 
-   /* the files of this directory
-      stored in sorted order by pathname */
-   DynArray_T fchildren;
+   /* what this directory needs to be shared between threads, or NULL
+      if it is not */
+   struct node_sharing* sharing;
 
-   /* the subdirectories of this directory
-      stored in sorted order by pathname */
-   DynArray_T dchildren;
+   /* the interned name of this directory */
+   const char* name;
 };
 
+/*
+   Returns the file f as it is kept among its parent's children: its
+   address plus one, which is odd, whereas the address of a directory,
+   like that of any allocated block, is even.
+*/
+static void* Node_tagFile(File_T f) {
+   assert(f != NULL);
+
+   return (char*) f + 1;
+}
+
+/*
+   Returns TRUE if child, one of a directory's children, is a file,
+   and FALSE if it is a directory.
+*/
+static boolean Node_isFile(const void* child) {
+   assert(child != NULL);
+
+   return (boolean) (((size_t) child & 1) != 0);
+}
+
+/*
+   Returns the file that child, a file among a directory's children,
+   stands for.
+*/
+static File_T Node_untagFile(const void* child) {
+   assert(child != NULL);
+   assert(Node_isFile(child));
+
+   return (File_T) ((const char*) child - 1);
+}
+
+/*
+   Returns the name of child, one of a directory's children, for its
+   parent's set of children.
+*/
+static const char* Node_getChildName(const void* child) {
+   assert(child != NULL);
+
+   if(Node_isFile(child))
+      return File_getName(Node_untagFile(child));
+   return Node_getName((Node_T) child);
+}
+
+/*
+   Returns child, one of a directory's children, as it is kept within
+   the directory's node: its index shifted left by one, with the low
+   bit set if it is a file.
+*/
+static unsigned int Node_toEntry(const void* child) {
+   assert(child != NULL);
+
+   if(Node_isFile(child))
+      return (Slab_indexOf(Node_untagFile(child)) << 1) | 1;
+   return Slab_indexOf(child) << 1;
+}
+
+/*
+   Returns the child whose entry is entry, which is not 0, among the
+   children of a directory of slab, as a directory or a tagged file.
+*/
+static void* Node_entryIn(Slab_T slab, unsigned int entry) {
+   void* child;
+
+   assert(slab != NULL);
+   assert(entry != 0);
+
+   child = Slab_at(slab, entry >> 1);
+   if((entry & 1) != 0)
+      return Node_tagFile(child);
+   return child;
+}
+
+/*
+   Returns the child of n whose entry within n is entry, which is not
+   0, as a directory or a tagged file.
+*/
+static void* Node_fromEntry(Node_T n, unsigned int entry) {
+   assert(n != NULL);
+
+   return Node_entryIn(Slab_of(n), entry);
+}
+
+/*
+   Returns the name of the child whose entry is entry among the
+   children of a directory of slab, for the directory's set of
+   children.
+*/
+static const char* Node_getEntryName(unsigned int entry, void* slab) {
+   return Node_getChildName(Node_entryIn(slab, entry));
+}
+
+/*
+   Returns n's epoch, or NULL if it has none.
+*/
+static Epoch_T Node_getEpoch(Node_T n) {
+   assert(n != NULL);
+
+   if(n->sharing == NULL)
+      return NULL;
+   return n->sharing->epoch;
+}
+
 /* see node.h for specification */
-Node_T Node_create(const char* dir, Node_T parent){
+Node_T Node_create(const char* dir, Node_T parent, Slab_T slab){
    Node_T new;
-   char* path;
+   size_t length;
+   size_t i;
 
    assert(dir != NULL);
 
-   /* allocates memory for the node and its path */
-   new = malloc(sizeof(struct node));
+   /* allocates memory for the node, and shares its name with every
+      other use of it in the tree */
+   new = Slab_alloc(slab, sizeof(struct node));
    if(new == NULL)
       return NULL;
+   length = strcspn(dir, "/");
+   new->name = Names_intern(Slab_getClient(slab), dir, length);
+   if(new->name == NULL) {
+      Slab_release(slab, new, sizeof(struct node));
+      return NULL;
+   }
 
-   if(parent == NULL)
-      path = malloc(strlen(dir)+1);
-   else
-      path = malloc(strlen(parent->path) + 1 + strlen(dir) + 1);
+   /* sets node fields; the children need no memory until there are
+      more of them than fit in the node */
+   new->parent = (parent == NULL) ? 0 : Slab_indexOf(parent);
+   for(i = 0; i < NODE_INLINE; i++)
+      new->few[i] = 0;
+   new->many = NULL;
+   new->sharing = NULL;
 
-   if(path == NULL) {
-      free(new);
-      return NULL;
+   return new;
+}
+
+/* What Node_forEachChild needs to visit each of a directory's
+   children from the entries in its set: the directory, and the
+   function to call, with its extra argument. */
+struct Node_visit {
+   Node_T n;
+   void (*apply)(void* child, void* extra);
+   void* extra;
+};
+
+/*
+   Calls the function of visit for the child whose entry is entry.
+*/
+static void Node_visitEntry(unsigned int entry, void* visit) {
+   struct Node_visit* pVisit = visit;
+
+   assert(visit != NULL);
+
+   (*pVisit->apply)(Node_fromEntry(pVisit->n, entry), pVisit->extra);
+}
+
+/*
+   Calls (*apply)(child, extra) for each of n's children, in no
+   particular order.
+*/
+static void Node_forEachChild(Node_T n,
+                              void (*apply)(void* child, void* extra),
+                              void* extra) {
+   struct Node_visit visit;
+   size_t i;
+
+   assert(n != NULL);
+   assert(apply != NULL);
+
+   if(n->many != NULL) {
+      visit.n = n;
+      visit.apply = apply;
+      visit.extra = extra;
+      ChildSet_map(n->many, Node_visitEntry, &visit);
    }
+   else
+      for(i = 0; i < NODE_INLINE && n->few[i] != 0; i++)
+         (*apply)(Node_fromEntry(n, n->few[i]), extra);
+}
+
+/* What Node_destroy and Node_destroyShallow need to destroy each
+   child in turn: the arena, and the count of nodes destroyed. */
+struct Node_destruction {
+   Arena_T arena;
+   size_t count;
+};
 
-   /* creates the path using the parent's path and its own name */
-   *path = '\0';
+/*
+   Destroys child, one of a directory's children, and if it is a
+   directory, the hierarchy beneath it, adding the nodes destroyed to
+   the count of destruction.
+*/
+static void Node_destroyChild(void* child, void* destruction) {
+   struct Node_destruction* pDestruction = destruction;
+
+   assert(child != NULL);
+   assert(destruction != NULL);
 
-   if(parent != NULL) {
-      strcpy(path, parent->path);
-      strcat(path, "/");
+   if(Node_isFile(child)) {
+      File_destroy(Node_untagFile(child));
+      pDestruction->count++;
    }
-   strcat(path, dir);
+   else
+      pDestruction->count += Node_destroy(child, pDestruction->arena);
+}
 
-   /* sets node fields */
-   new->path = path;
+/*
+   Destroys child, one of a directory's children, if it is a file,
+   adding it to the count of destruction.
+*/
+static void Node_destroyFile(void* child, void* destruction) {
+   struct Node_destruction* pDestruction = destruction;
 
-   new->parent = parent;
+   assert(child != NULL);
+   assert(destruction != NULL);
+
+   if(Node_isFile(child)) {
+      File_destroy(Node_untagFile(child));
+      pDestruction->count++;
+   }
+}
 
-   new->fchildren = DynArray_new(0);
-   new->dchildren = DynArray_new(0);
+/*
+   Frees n itself, once its children are gone, returning 1 for the
+   count of nodes destroyed.
+*/
+static size_t Node_free(Node_T n, Arena_T arena) {
+   assert(n != NULL);
 
-   /* ensures that children arrays are created successfully */
-   if(new->fchildren == NULL || new->dchildren == NULL) {
-      if (new->dchildren != NULL) {
-          DynArray_free(new->dchildren);
-      }
-      else if (new->fchildren != NULL) {
-          DynArray_free(new->fchildren);
-      }
-      free(new->path);
-      free(new);
-      return NULL;
+   if(n->many != NULL)
+      ChildSet_free(n->many);
+   if(n->sharing != NULL) {
+      (void) pthread_rwlock_destroy(&n->sharing->lock);
+      Arena_release(arena, n->sharing, sizeof(struct node_sharing));
    }
+   Names_release(Slab_getClient(Slab_of(n)), n->name);
+   Slab_release(Slab_of(n), n, sizeof(struct node));
 
-   return new;
+   return 1;
 }
 
 /* see node.h for specification */
-size_t Node_destroy(Node_T n) {
-   size_t i;
-   size_t count = 0;
-   Node_T d;
-   File_T f;
-   
-   assert(n != NULL);
-   
-   for(i = 0; i < DynArray_getLength(n->fchildren); i++)
-   {
-      f = DynArray_get(n->fchildren, i);
-      File_destroy(f);
-      count++;
+size_t Node_destroy(Node_T n, Arena_T arena) {
+   struct Node_destruction destruction;
+
+   assert(n != NULL);
+
+   destruction.arena = arena;
+   destruction.count = 0;
+   Node_forEachChild(n, Node_destroyChild, &destruction);
+
+   return destruction.count + Node_free(n, arena);
+}
+
+/* see node.h for specification */
+size_t Node_destroyShallow(Node_T n, Arena_T arena) {
+   struct Node_destruction destruction;
+
+   assert(n != NULL);
+
+   destruction.arena = arena;
+   destruction.count = 0;
+   Node_forEachChild(n, Node_destroyFile, &destruction);
+
+   return destruction.count + Node_free(n, arena);
+}
+
+/* see node.h for specification */
+boolean Node_addLock(Node_T n, Arena_T arena, Epoch_T epoch) {
+   assert(n != NULL);
+   assert(n->sharing == NULL);
+   assert(n->many == NULL && n->few[0] == 0);
+
+   n->sharing = Arena_alloc(arena, sizeof(struct node_sharing));
+   if(n->sharing == NULL)
+      return FALSE;
+
+   if(pthread_rwlock_init(&n->sharing->lock, NULL) != 0) {
+      Arena_release(arena, n->sharing, sizeof(struct node_sharing));
+      n->sharing = NULL;
+      return FALSE;
    }
-   DynArray_free(n->fchildren);
+   n->sharing->epoch = epoch;
+   return TRUE;
+}
+
+/* see node.h for specification */
+void Node_lockShared(Node_T n) {
+   int result;
+
+   assert(n != NULL);
 
-   for(i = 0; i < DynArray_getLength(n->dchildren); i++)
-   {
-      d = DynArray_get(n->dchildren, i);
-      count += Node_destroy(d);
+   if(n->sharing != NULL) {
+      result = pthread_rwlock_rdlock(&n->sharing->lock);
+      assert(result == 0);
+      (void) result;
    }
-   DynArray_free(n->dchildren);
+}
+
+/* see node.h for specification */
+void Node_lockExclusive(Node_T n) {
+   int result;
 
-   free(n->path);
-   free(n);
-   count++;
+   assert(n != NULL);
 
-   return count;
+   if(n->sharing != NULL) {
+      result = pthread_rwlock_wrlock(&n->sharing->lock);
+      assert(result == 0);
+      (void) result;
+   }
 }
 
 /* see node.h for specification */
-char* Node_getPath(Node_T n) {
-   char* pathCopy;
+void Node_unlock(Node_T n) {
+   int result;
 
    assert(n != NULL);
 
-   pathCopy = malloc(strlen(n->path)+1);
-   if(pathCopy == NULL)
-      return NULL;
+   if(n->sharing != NULL) {
+      result = pthread_rwlock_unlock(&n->sharing->lock);
+      assert(result == 0);
+      (void) result;
+   }
+}
+
+/* see node.h for specification */
+const char* Node_getName(Node_T n) {
+   assert(n != NULL);
 
-   return strcpy(pathCopy, n->path);
+   return n->name;
 }
 
+/* see node.h for specification */
+size_t Node_getPath(Node_T n, char* buffer, size_t size) {
+   Node_T curr;
+   size_t length = 0;
+   size_t nameLength;
+   size_t end;
+
+   assert(n != NULL);
+   assert(buffer != NULL || size == 0);
+
+   /* the path is each ancestor's name, separated by slashes */
+   for(curr = n; curr != NULL; curr = Node_getParent(curr))
+      length += strlen(Node_getName(curr)) + 1;
+   length--;
+
+   if(size == 0)
+      return length;
+
+   /* fill in the names from the last one back to the root, keeping
+      only the characters that fall within the buffer */
+   end = length;
+   for(curr = n; curr != NULL; curr = Node_getParent(curr)) {
+      nameLength = strlen(Node_getName(curr));
+      end -= nameLength;
+      if(end < size - 1)
+         memcpy(buffer + end, Node_getName(curr),
+                (end + nameLength < size - 1 ?
+                 nameLength : size - 1 - end));
+      if(curr->parent != 0) {
+         end--;
+         if(end < size - 1)
+            buffer[end] = '/';
+      }
+   }
+   buffer[length < size - 1 ? length : size - 1] = '\0';
+
+   return length;
+}
 
 /* see node.h for specification */
 int Node_compare(Node_T node1, Node_T node2) {
    assert(node1 != NULL);
    assert(node2 != NULL);
 
-   return strcmp(node1->path, node2->path);
+   if(node1->name == node2->name)
+      return 0;
+   return strcmp(Node_getName(node1), Node_getName(node2));
 }
 
-/* see node.h for specification */
-size_t Node_getNumChildren(Node_T n, boolean file) {
-   DynArray_T children;
+/*
+   Returns n's set of children, or NULL if it has none there. Sets
+   replaced copy-on-write are published with a single store, so the
+   set returned is a consistent snapshot even to a reader that holds
+   no lock.
+*/
+static ChildSet_T Node_getChildren(Node_T n) {
    assert(n != NULL);
 
-   if(file)
-       children = n->fchildren;
+   return __atomic_load_n(&n->many, __ATOMIC_ACQUIRE);
+}
+
+/*
+   Frees children, a set retired by Node_setChildren.
+*/
+static void Node_freeChildren(void* children, void* unused) {
+   assert(children != NULL);
+
+   (void) unused;
+   ChildSet_free(children);
+}
+
+/*
+   Makes children, which may be NULL, n's set of children, retiring
+   the set it replaces, if any, to n's epoch.
+*/
+static void Node_setChildren(Node_T n, ChildSet_T children) {
+   ChildSet_T old;
+
+   assert(n != NULL);
+
+   old = n->many;
+   __atomic_store_n(&n->many, children, __ATOMIC_RELEASE);
+   if(old != NULL)
+      Epoch_retire(Node_getEpoch(n), old, Node_freeChildren, NULL);
+}
+
+/*
+   Compares key, which ends at its first slash, if it has one, to
+   name, as strcmp would. A key that is itself an interned name, as
+   when a child is linked or unlinked, matches it without reading it.
+*/
+static int Node_compareKey(const char* key, const char* name) {
+   assert(key != NULL);
+   assert(name != NULL);
+
+   if(key == name)
+      return 0;
+
+   while(*key == *name && *key != '\0') {
+      key++;
+      name++;
+   }
+   if(*key == '/')
+      return 0 - (int) (unsigned char) *name;
+   return (int) (unsigned char) *key - (int) (unsigned char) *name;
+}
+
+/*
+   Returns 1 if one of the children that n keeps within itself is
+   named by key, and 0 otherwise, storing in *i its index, or the one
+   it would have.
+*/
+static int Node_rankFew(Node_T n, const char* key, size_t* i) {
+   int compare;
+
+   assert(n != NULL);
+   assert(key != NULL);
+   assert(i != NULL);
+
+   for(*i = 0; *i < NODE_INLINE && n->few[*i] != 0; (*i)++) {
+      compare = Node_compareKey(key, Node_getChildName(
+                   Node_fromEntry(n, n->few[*i])));
+      if(compare == 0)
+         return 1;
+      if(compare < 0)
+         break;
+   }
+   return 0;
+}
+
+/*
+   Returns n's child named by key, a directory or a tagged file, or
+   NULL if it has none.
+*/
+static void* Node_lookup(Node_T n, const char* key) {
+   ChildSet_T children;
+   unsigned int entry;
+   size_t i;
+
+   assert(n != NULL);
+   assert(key != NULL);
+
+   children = Node_getChildren(n);
+   if(children != NULL)
+      entry = ChildSet_find(children, key);
+   else if(Node_rankFew(n, key, &i))
+      entry = n->few[i];
    else
-       children = n->dchildren;
-   return DynArray_getLength(children);
+      entry = 0;
+   if(entry == 0)
+      return NULL;
+   return Node_fromEntry(n, entry);
+}
+
+/*
+   Returns n's child with identifier childID, a directory or a tagged
+   file, or NULL if it has none.
+*/
+static void* Node_childAt(Node_T n, size_t childID) {
+   ChildSet_T children;
+
+   assert(n != NULL);
+
+   children = Node_getChildren(n);
+   if(children != NULL)
+      return (ChildSet_getLength(children) > childID) ?
+             Node_fromEntry(n, ChildSet_get(children, childID)) : NULL;
+   if(childID >= NODE_INLINE || n->few[childID] == 0)
+      return NULL;
+   return Node_fromEntry(n, n->few[childID]);
+}
+
+/*
+   Returns a new, empty set for n's children, allocated from arena,
+   which keeps a hash table of them beyond threshold children, or a
+   B+tree of them if ordered, or NULL if there is an allocation error.
+*/
+static ChildSet_T Node_newChildren(Node_T n, Arena_T arena,
+                                   size_t threshold, boolean ordered) {
+   ChildSet_T children;
+
+   assert(n != NULL);
+
+   children = ChildSet_new(arena, Node_getEntryName, Slab_of(n),
+                           threshold, (int) ordered);
+   if(children != NULL && Node_getEpoch(n) != NULL)
+      ChildSet_share(children);
+   return children;
+}
+
+/*
+   Moves n's children from within n to a new set, allocated from
+   arena with the given threshold and order, along with child, which
+   n is gaining.
+   Returns TRUE, or FALSE if there is an allocation error, in which
+   case nothing changes.
+*/
+static boolean Node_spill(Node_T n, void* child, Arena_T arena,
+                          size_t threshold, boolean ordered) {
+   ChildSet_T children;
+   size_t i;
+
+   assert(n != NULL);
+   assert(n->many == NULL);
+
+   children = Node_newChildren(n, arena, threshold, ordered);
+   if(children == NULL)
+      return FALSE;
+   for(i = 0; i < NODE_INLINE && n->few[i] != 0; i++)
+      if(!ChildSet_add(children, n->few[i])) {
+         ChildSet_free(children);
+         return FALSE;
+      }
+   if(!ChildSet_add(children, Node_toEntry(child))) {
+      ChildSet_free(children);
+      return FALSE;
+   }
+
+   for(i = 0; i < NODE_INLINE; i++)
+      n->few[i] = 0;
+   n->many = children;
+   return TRUE;
+}
+
+/*
+   Adds child, a directory or a tagged file, to n's children, within
+   n if there is room, or else in a set allocated from arena, which
+   keeps a hash table of them beyond threshold children, or a B+tree
+   of them if ordered. With an
+   epoch, the change is made to a copy of the set, which then replaces
+   it, so that readers never see a set being changed.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean Node_addChild(Node_T n, void* child, Arena_T arena,
+                             size_t threshold, boolean ordered) {
+   ChildSet_T children;
+   size_t i;
+   size_t j;
+
+   assert(n != NULL);
+   assert(child != NULL);
+
+   if(Node_getEpoch(n) != NULL) {
+      if(n->many == NULL)
+         children = Node_newChildren(n, arena, threshold, ordered);
+      else
+         children = ChildSet_copy(n->many);
+      if(children == NULL)
+         return FALSE;
+      if(!ChildSet_add(children, Node_toEntry(child))) {
+         ChildSet_free(children);
+         return FALSE;
+      }
+      Node_setChildren(n, children);
+      return TRUE;
+   }
+
+   if(n->many != NULL)
+      return (boolean) ChildSet_add(n->many, Node_toEntry(child));
+
+   if(n->few[NODE_INLINE - 1] != 0)
+      return Node_spill(n, child, arena, threshold, ordered);
+
+   (void) Node_rankFew(n, Node_getChildName(child), &i);
+   for(j = NODE_INLINE - 1; j > i; j--)
+      n->few[j] = n->few[j - 1];
+   n->few[i] = Node_toEntry(child);
+   return TRUE;
+}
+
+/*
+   Moves n's children back within n from its set, which has shrunk to
+   few enough of them, and frees the set.
+*/
+static void Node_unspill(Node_T n) {
+   size_t i;
+
+   assert(n != NULL);
+   assert(n->many != NULL);
+   assert(ChildSet_getLength(n->many) <= NODE_INLINE);
+
+   for(i = 0; i < ChildSet_getLength(n->many); i++)
+      n->few[i] = ChildSet_get(n->many, i);
+   ChildSet_free(n->many);
+   n->many = NULL;
+}
+
+/*
+   Removes the child named name from n's children, copy-on-write if n
+   has an epoch, and frees n's set of children if none are left in it.
+   Returns TRUE, or FALSE if the copy cannot be allocated, in which
+   case n's children are unchanged: the set that readers are searching
+   is never changed in place, which could hide a sibling from them.
+*/
+static boolean Node_removeChild(Node_T n, const char* name) {
+   ChildSet_T children;
+   size_t i;
+
+   assert(n != NULL);
+   assert(name != NULL);
+
+   if(n->many == NULL) {
+      if(!Node_rankFew(n, name, &i))
+         return TRUE;
+      for(; i + 1 < NODE_INLINE; i++)
+         n->few[i] = n->few[i + 1];
+      n->few[NODE_INLINE - 1] = 0;
+      return TRUE;
+   }
+
+   if(Node_getEpoch(n) != NULL) {
+      children = ChildSet_copy(n->many);
+      if(children == NULL)
+         return FALSE;
+      (void) ChildSet_remove(children, name);
+      if(ChildSet_getLength(children) == 0) {
+         ChildSet_free(children);
+         children = NULL;
+      }
+      Node_setChildren(n, children);
+      return TRUE;
+   }
+
+   /* move back within n only once well below the room there, so that
+      a directory at the boundary does not move back and forth */
+   (void) ChildSet_remove(n->many, name);
+   if(ChildSet_getLength(n->many) <= NODE_INLINE / 2)
+      Node_unspill(n);
+   return TRUE;
 }
 
 /* see node.h for specification */
-int Node_hasDirChild(Node_T n, const char* path, size_t* childID) {
-   size_t index = 0;
-   int result;
-   Node_T checker;
+size_t Node_getNumChildren(Node_T n) {
+   ChildSet_T children;
+   size_t i;
 
    assert(n != NULL);
-   assert(path != NULL);
 
-   checker = Node_create(path, NULL);
-   if(checker == NULL) {
-      return 1;
+   children = Node_getChildren(n);
+   if(children != NULL)
+      return ChildSet_getLength(children);
+   for(i = 0; i < NODE_INLINE && n->few[i] != 0; i++)
+      ;
+   return i;
+}
+
+/*
+   Returns 1 if n has a child file, if file is TRUE, or else a child
+   directory, named name, and 0 otherwise, storing its identifier, or
+   the one it would have, in *childID if childID is not NULL.
+*/
+static int Node_hasChild(Node_T n, boolean file, const char* name,
+                         size_t* childID) {
+   ChildSet_T children;
+   void* child;
+
+   assert(n != NULL);
+   assert(name != NULL);
+
+   /* only the position needs the children in order */
+   if(childID == NULL) {
+      child = Node_lookup(n, name);
+      return child != NULL && Node_isFile(child) == file;
    }
 
-   result = DynArray_bsearch(n->dchildren, checker, &index,
-                    (int (*)(const void*, const void*)) Node_compare);
-   (void) Node_destroy(checker);
+   children = Node_getChildren(n);
+   if(children != NULL) {
+      if(!ChildSet_rank(children, name, childID))
+         return 0;
+      child = Node_fromEntry(n, ChildSet_get(children, *childID));
+   }
+   else {
+      if(!Node_rankFew(n, name, childID))
+         return 0;
+      child = Node_fromEntry(n, n->few[*childID]);
+   }
+   return Node_isFile(child) == file;
+}
 
-   if(childID != NULL)
-      *childID = index;
+/* see node.h for specification */
+int Node_hasDirChild(Node_T n, const char* name, size_t* childID) {
+   return Node_hasChild(n, FALSE, name, childID);
+}
 
-   return result;
+/* see node.h for specification */
+int Node_hasFileChild(Node_T n, const char* name, size_t* childID) {
+   return Node_hasChild(n, TRUE, name, childID);
 }
 
 /* see node.h for specification */
-int Node_hasFileChild(Node_T n, const char* path, size_t* childID) {
-   size_t index = 0;
-   int result;
-   File_T checker;
-   
+Node_T Node_findChild(Node_T n, const char* name, File_T* file) {
+   void* child;
+
    assert(n != NULL);
-   assert(path != NULL);
+   assert(name != NULL);
+   assert(file != NULL);
 
-   checker = File_create(path, NULL, NULL, 0);
-   if(checker == NULL) {
-      return -1;
+   *file = NULL;
+   child = Node_lookup(n, name);
+   if(child == NULL)
+      return NULL;
+   if(Node_isFile(child)) {
+      *file = Node_untagFile(child);
+      return NULL;
    }
+   return child;
+}
 
-   result = DynArray_bsearch(n->fchildren, checker, &index,
-                    (int (*)(const void*, const void*)) File_compare);
-   (void) File_destroy(checker);
+/* see node.h for specification */
+Node_T Node_findDirChild(Node_T n, const char* name) {
+   File_T file;
 
-   if(childID != NULL)
-      *childID = index;
+   return Node_findChild(n, name, &file);
+}
 
-   return result;
+/* see node.h for specification */
+File_T Node_findFileChild(Node_T n, const char* name) {
+   File_T file;
+
+   (void) Node_findChild(n, name, &file);
+   return file;
 }
 
 /* see node.h for specification */
 Node_T Node_getDirChild(Node_T n, size_t childID) {
+   void* child;
+
    assert(n != NULL);
 
-   if(DynArray_getLength(n->dchildren) > childID)
-      return DynArray_get(n->dchildren, childID);
-   else
+   child = Node_childAt(n, childID);
+   if(child == NULL || Node_isFile(child))
       return NULL;
+   return child;
 }
 
 /* see node.h for specification */
 File_T Node_getFileChild(Node_T n, size_t childID) {
+   void* child;
+
    assert(n != NULL);
 
-   if(DynArray_getLength(n->fchildren) > childID)
-      return DynArray_get(n->fchildren, childID);
-   else
+   child = Node_childAt(n, childID);
+   if(child == NULL || !Node_isFile(child))
       return NULL;
+   return Node_untagFile(child);
 }
 
 /* see node.h for specification */
 Node_T Node_getParent(Node_T n) {
    assert(n != NULL);
 
-   return n->parent;
+   if(n->parent == 0)
+      return NULL;
+   return Slab_at(Slab_of(n), n->parent);
 }
 
 /* see node.h for specification */
-int Node_linkChild(Node_T parent, Node_T child) {
-   size_t i;
-   char* rest;
-
+int Node_linkChild(Node_T parent, Node_T child, Arena_T arena,
+                   size_t threshold, boolean ordered) {
    assert(parent != NULL);
    assert(child != NULL);
 
-   /* check if the child already exists */
-   if(Node_hasFileChild(parent, child->path, NULL))
+   /* check that the child was created beneath parent */
+   if(Node_getParent(child) != parent)
+      return PARENT_CHILD_ERROR;
+
+   /* check that no child, file or directory, already has the name */
+   if(Node_lookup(parent, Node_getName(child)) != NULL)
       return ALREADY_IN_TREE;
 
-   /* check that parent path is a prefix of child path */
-   i = strlen(parent->path);
-   if(strncmp(child->path, parent->path, i))
+   if(Node_addChild(parent, child, arena, threshold, ordered))
+      return SUCCESS;
+   else
       return PARENT_CHILD_ERROR;
+}
 
-   /* check that the child path extends beyond the parent path */
-   rest = child->path + i;
-   if(strlen(child->path) >= i && rest[0] != '/')
-      return PARENT_CHILD_ERROR;
+/* see node.h for specification */
+int Node_unlinkChild(Node_T parent, Node_T child) {
+   assert(parent != NULL);
+   assert(child != NULL);
+
+   if(!Node_removeChild(parent, Node_getName(child)))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+
+/* see file.h for specification */
+int File_linkChild(Node_T parent, File_T child, Arena_T arena,
+                   size_t threshold, boolean ordered) {
+   assert(parent != NULL);
+   assert(child != NULL);
 
-   /* check that the child is not a grandchild of parent */
-   rest++;
-   if(strstr(rest, "/") != NULL)
+   /* check that the child was created beneath parent */
+   if(File_getParent(child) != parent)
       return PARENT_CHILD_ERROR;
-   
-   child->parent = parent;
 
-   /* check that the child isnt already linked and add at given index */
-   if(DynArray_bsearch(parent->dchildren, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) == 1)
+   /* check that no child, file or directory, already has the name */
+   if(Node_lookup(parent, File_getName(child)) != NULL)
       return ALREADY_IN_TREE;
 
-   if(DynArray_addAt(parent->dchildren, i, child) == TRUE)
+   if(Node_addChild(parent, Node_tagFile(child), arena, threshold,
+                    ordered))
       return SUCCESS;
    else
       return PARENT_CHILD_ERROR;
 }
 
-/* see node.h for specification */
-void Node_unlinkChild(Node_T parent, Node_T child) {
-   size_t i = 0;
-
+/* see file.h for specification */
+int File_unlinkChild(Node_T parent, File_T child) {
    assert(parent != NULL);
    assert(child != NULL);
 
-   if(DynArray_bsearch(parent->dchildren, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) != 0)
-        (void) DynArray_removeAt(parent->dchildren, i);
+   if(!Node_removeChild(parent, File_getName(child)))
+      return MEMORY_ERROR;
+   return SUCCESS;
 }
 
+/*
+   Adds child, a copy of one of the children of the directory that
+   copy is a copy of, to copy's children. copy is not yet reachable by
+   any other thread, so even a set shared with readers is changed in
+   place.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean Node_addCopiedChild(Node_T copy, void* child,
+                                   Arena_T arena, size_t threshold,
+                                   boolean ordered) {
+   assert(copy != NULL);
+   assert(child != NULL);
+
+   if(Node_getEpoch(copy) == NULL)
+      return Node_addChild(copy, child, arena, threshold, ordered);
+
+   if(copy->many == NULL) {
+      copy->many = Node_newChildren(copy, arena, threshold, ordered);
+      if(copy->many == NULL)
+         return FALSE;
+   }
+   return (boolean) ChildSet_add(copy->many, Node_toEntry(child));
+}
+
+/*
+   Copies the hierarchy rooted at n into slab, beneath parent, as
+   Node_copy does, but for the contents of its files.
+   Returns the copy, or NULL if there is an allocation error, in which
+   case nothing of the copy is left.
+*/
+static Node_T Node_copyNames(Node_T n, Node_T parent, Slab_T slab,
+                             Arena_T arena, size_t threshold,
+                             boolean ordered) {
+   Node_T copy;
+   void* child;
+   void* childCopy;
+   size_t c;
+
+   assert(n != NULL);
+
+   copy = Node_create(Node_getName(n), parent, slab);
+   if(copy == NULL)
+      return NULL;
+   if(n->sharing != NULL &&
+      !Node_addLock(copy, arena, Node_getEpoch(n))) {
+      (void) Node_destroy(copy, arena);
+      return NULL;
+   }
+
+   /* the files first, right after their directory... */
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_childAt(n, c);
+      if(!Node_isFile(child))
+         continue;
+      childCopy = File_copy(Node_untagFile(child), copy, slab);
+      if(childCopy == NULL ||
+         !Node_addCopiedChild(copy, Node_tagFile(childCopy), arena,
+                              threshold, ordered)) {
+         if(childCopy != NULL)
+            File_destroy(childCopy);
+         (void) Node_destroy(copy, arena);
+         return NULL;
+      }
+   }
+
+   /* ...and then each subdirectory with all that lies beneath it */
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_childAt(n, c);
+      if(Node_isFile(child))
+         continue;
+      childCopy = Node_copyNames(child, copy, slab, arena,
+                                 threshold, ordered);
+      if(childCopy == NULL ||
+         !Node_addCopiedChild(copy, childCopy, arena, threshold,
+                              ordered)) {
+         if(childCopy != NULL)
+            (void) Node_destroy(childCopy, arena);
+         (void) Node_destroy(copy, arena);
+         return NULL;
+      }
+   }
+
+   return copy;
+}
+
+/*
+   Gives the files of copy, a copy of the hierarchy rooted at n made
+   by Node_copyNames, their contents, in the order in which their
+   names were copied.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+static boolean Node_copyContents(Node_T n, Node_T copy) {
+   void* child;
+   size_t c;
+
+   assert(n != NULL);
+   assert(copy != NULL);
+
+   /* the copy has the same children as n, in the same positions */
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_childAt(n, c);
+      if(Node_isFile(child) &&
+         !File_copyContents(Node_untagFile(Node_childAt(copy, c)),
+                            Node_untagFile(child)))
+         return FALSE;
+   }
+
+   for(c = 0; c < Node_getNumChildren(n); c++) {
+      child = Node_childAt(n, c);
+      if(!Node_isFile(child) &&
+         !Node_copyContents(child, Node_childAt(copy, c)))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* see node.h for specification */
+Node_T Node_copy(Node_T n, Slab_T slab, Arena_T arena,
+                 size_t threshold, boolean ordered) {
+   Node_T copy;
+
+   assert(n != NULL);
+
+   copy = Node_copyNames(n, NULL, slab, arena, threshold, ordered);
+   if(copy != NULL && !Node_copyContents(n, copy)) {
+      (void) Node_destroy(copy, arena);
+      return NULL;
+   }
+   return copy;
+}
 
 /* see node.h for specification */
 char* Node_toString(Node_T n) {
    char* copyPath;
+   size_t length;
 
    assert(n != NULL);
 
-   copyPath = malloc(strlen(n->path)+1);
+   length = Node_getPath(n, NULL, 0);
+   copyPath = malloc(length + 1);
    if(copyPath == NULL) {
       return NULL;
    }
    else {
-      return strcpy(copyPath, n->path);
+      (void) Node_getPath(n, copyPath, length + 1);
+      return copyPath;
    }
 }
@@ -8,76 +8,188 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "arena.h"
 #include "elements.h"
+#include "epoch.h"
+#include "slab.h"
 
 /*
-   Given a parent node and a directory string dir, returns a new
+   Given a parent node and a directory name dir, returns a new
    Node_T or NULL if any allocation error occurs in creating
    the node or its fields.
 
-   The new structure is initialized to have its path as the parent's
-   path (if it exists) prefixed to the directory string parameter,
-   separated by a slash. It is also initialized with its parent link
+   The name is the part of dir before the first slash, if there is
+   one, so dir may point into a longer path. Only the name is stored:
+   the node's full path is the parent's path (if it exists) followed
+   by a slash and the name, and is rebuilt on demand by Node_getPath.
+   The new structure is also initialized with its parent link
    as the parent parameter value, but the parent itself is not changed
    to link to the new node.  The children links are initialized but
    do not point to any children.
+
+   The node is allocated from slab, which must be the one that parent,
+   and every other node and file of the tree, came from, and its name
+   is interned in the Names_T attached to slab as its client. A few
+   children are kept within the node; more need a set, which is
+   allocated when they are linked.
 */
-Node_T Node_create(const char* dir, Node_T parent);
+Node_T Node_create(const char* dir, Node_T parent, Slab_T slab);
 
 /*
   Destroys the entire hierarchy of nodes rooted at n,
-  including n itself. Returns the number of nodes destroyed.
+  including n itself, releasing the nodes and files to their slab and
+  their children sets to arena, which must be the one they were
+  linked with. None of the nodes may be locked.
+  Returns the number of nodes destroyed.
 */
-size_t Node_destroy(Node_T n);
+size_t Node_destroy(Node_T n, Arena_T arena);
 
 /*
-  Compares node1 and node2 based on their paths.
+  Destroys n and its files, as Node_destroy does, but none of its
+  child directories, which the caller must first take from n with
+  Node_getDirChild and destroy separately, so that a large hierarchy
+  can be destroyed a directory at a time, by several threads.
+  Returns the number of nodes destroyed: n and its files.
+*/
+size_t Node_destroyShallow(Node_T n, Arena_T arena);
+
+/*
+  Copies the hierarchy rooted at n into slab, as a hierarchy with no
+  parent, laid out for traversal: each directory is followed by its
+  files, and then by the hierarchy of each of its subdirectories in
+  order of name, as they are listed, and the files' contents and
+  lengths follow all of that. Children sets that the copies need are
+  allocated from arena, and keep hash tables beyond threshold
+  children, or B+trees if ordered, and each copy of a directory with
+  a lock gets one too, from arena, with the same epoch. n is
+  unchanged; none of its nodes may be locked.
+  Returns the copy, or NULL if there is an allocation error, in which
+  case nothing of the copy is left.
+*/
+Node_T Node_copy(Node_T n, Slab_T slab, Arena_T arena,
+                 size_t threshold, boolean ordered);
+
+/*
+   Gives n a reader-writer lock, allocated from arena, for sharing it
+   between threads. The lock guards n's children arrays and the
+   contents of its files; n's name and parent never change. Without a
+   lock, the three functions below do nothing.
+   If epoch is not NULL, the children arrays are never changed in
+   place: each change is made to a copy, which replaces the array
+   atomically, and the old array is retired to epoch. Readers inside
+   epoch may then search n's children without taking the lock.
+   Returns TRUE, or FALSE if there is an allocation error.
+*/
+boolean Node_addLock(Node_T n, Arena_T arena, Epoch_T epoch);
+
+/*
+   Locks n for reading its children, waiting for any thread that has
+   it locked exclusively.
+*/
+void Node_lockShared(Node_T n);
+
+/*
+   Locks n for changing its children, waiting for every other thread
+   that has it locked.
+*/
+void Node_lockExclusive(Node_T n);
+
+/*
+   Releases the lock on n taken by Node_lockShared or
+   Node_lockExclusive.
+*/
+void Node_unlock(Node_T n);
+
+/*
+  Compares node1 and node2, which must be siblings, by their names.
   Returns <0, 0, or >0 if node1 is less than,
   equal to, or greater than node2, respectively.
 */
 int Node_compare(Node_T node1, Node_T node2);
 
 /*
-   Returns n's path.
+   Returns n's name, the last component of its path. The name is
+   owned by n and remains valid until n is destroyed; it must not be
+   modified or freed by the caller.
+*/
+const char* Node_getName(Node_T n);
+
+/*
+   Writes n's full path into buffer, which holds size characters,
+   truncating it if necessary so that it is always '\0'-terminated
+   (unless size is 0, in which case buffer may be NULL).
+   Returns the length of the full path, so a return value of size or
+   more means that the path did not fit.
 */
-char* Node_getPath(Node_T n);
+size_t Node_getPath(Node_T n, char* buffer, size_t size);
 
 /*
-  Returns the number of child directories n has, if file is false.
-  Returnes the number of child files n has, if file is true.
+  Returns the number of children, directories and files together, that
+  n has. They are kept in a single set ordered by name, and a child's
+  identifier is its position in that order.
 */
-size_t Node_getNumChildren(Node_T n, boolean file);
+size_t Node_getNumChildren(Node_T n);
 
 /*
-  Returns 1 if n has a child directory with path,
-  0 if it does not have such a directory child, and -1 if
-  there is an allocation error during search.
+  Returns 1 if n has a child directory named name, and
+  0 if it does not have such a directory child.
+  The search allocates no memory.
+
+  name ends at its first slash, if there is one, so the rest of a
+  path can follow it.
 
   If n does have such a child, and childID is not NULL, store the
   child's identifier in *childID. If n does not have such a child,
-  store the identifier that such a child would have in *childID.
+  store the identifier that such a child would have in *childID, which
+  is that of n's file of the same name, if it has one.
 */
-int Node_hasDirChild(Node_T n, const char* path, size_t *childID);
+int Node_hasDirChild(Node_T n, const char* name, size_t *childID);
 
 /*
-   Returns 1 if n has a child file with path,
-   0 if it does not have such a file child, and -1 if
-   there is an allocation error during search.
+   Returns 1 if n has a child file named name, and
+   0 if it does not have such a file child.
+   The search allocates no memory.
+
+   As with Node_hasDirChild, name ends at its first slash, if any.
 
    If n does have such a child, and childID is not NULL, store the
    child's identifier in *childID. If n does not have such a child,
    store the identifier that such a child would have in *childID.
 */
-int Node_hasFileChild(Node_T n, const char* path, size_t* childID);
+int Node_hasFileChild(Node_T n, const char* name, size_t* childID);
+
+/*
+   Returns n's child directory named name, or NULL if it has none, and
+   stores in *file n's child file named name, or NULL if it has none,
+   all in a single search, since no directory and file share a name.
+   As with Node_hasDirChild, name ends at its first slash, if any.
+   Like Node_findDirChild, it is safe for readers that hold no lock.
+*/
+Node_T Node_findChild(Node_T n, const char* name, File_T* file);
+
+/*
+   Returns n's child directory named name, or NULL if it has none.
+   As with Node_hasDirChild, name ends at its first slash, if any.
+   Unlike a search followed by Node_getDirChild, the search and the
+   fetch are made in the same array, so it is safe for readers that
+   hold no lock on n.
+*/
+Node_T Node_findDirChild(Node_T n, const char* name);
+
+/*
+   Returns n's child file named name, or NULL if it has none, as
+   Node_findDirChild does for directories.
+*/
+File_T Node_findFileChild(Node_T n, const char* name);
 
 /*
-   Returns the child node of n with identifier childID, if one exists,
-   otherwise returns NULL.
+   Returns the child node of n with identifier childID, if one exists
+   and is a directory, otherwise returns NULL.
 */
 Node_T Node_getDirChild(Node_T n, size_t childID);
 
-/* Returns the child file of n with identifier childID, if one exists,
-   otherwise returns NULL.
+/* Returns the child file of n with identifier childID, if one exists
+   and is a file, otherwise returns NULL.
 */
 File_T Node_getFileChild(Node_T n, size_t childID);
 
@@ -89,22 +201,31 @@ Node_T Node_getParent(Node_T n);
 /*
   Makes child a child of parent, if possible, and returns SUCCESS.
   This is not possible in the following cases:
-  * parent already has a child with child's path,
+  * parent already has a child with child's name,
     in which case: returns ALREADY_IN_TREE
-    * child's path is not parent's path + / + directory,
+    * child was not created with parent as its parent,
     or the parent cannot link to the child,
     in which cases: returns PARENT_CHILD_ERROR
+  Any memory that parent needs for its children is allocated from
+  arena, and a set of them keeps a hash table of them beyond
+  threshold children, or a B+tree of them if ordered, or neither if
+  threshold is 0.
 */
-int Node_linkChild(Node_T parent, Node_T child);
+int Node_linkChild(Node_T parent, Node_T child, Arena_T arena,
+                   size_t threshold, boolean ordered);
 
 /*
-  Unlinks node parent from its node child, if it can be found in 
+  Unlinks node parent from its node child, if it can be found in
   the parent's children. child is unchanged.
+  Returns SUCCESS, or MEMORY_ERROR if parent's children are shared
+  with readers and their copy without child cannot be allocated, in
+  which case parent is unchanged. Only a parent in a tree with
+  FT_CONCURRENT can fail.
 */
-void Node_unlinkChild(Node_T parent, Node_T child);
+int Node_unlinkChild(Node_T parent, Node_T child);
 
 /*
-  Returns a string representation for n, 
+  Returns a string representation for n, its full path,
   or NULL if there is an allocation error.
 
   Allocates memory for the returned string,
@@ -0,0 +1,384 @@
+/*--------------------------------------------------------------------*/
+/* pool.c                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthreads, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include "pool.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of tasks that a Worker's deque first has room for. */
+
+enum { MIN_TASKS = 16 };
+
+/*--------------------------------------------------------------------*/
+
+/* A Worker is one thread of a Pool, with the deque of tasks it has
+   been given. */
+
+struct Worker
+{
+   /* The mutex guarding the deque, which the Worker takes to pop its
+      newest task and other Workers take to steal its oldest. */
+   pthread_mutex_t sLock;
+
+   /* The deque: a circular array of uCapacity tasks, of which the
+      uCount starting at index uFirst are present, oldest first. */
+   void **ppvTasks;
+   size_t uFirst;
+   size_t uCount;
+   size_t uCapacity;
+
+   /* The thread, and the Pool it works for. */
+   pthread_t sThread;
+   Pool_T oPool;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Pool consists of its Workers, the function they run, and what
+   they need to wait for work and to be waited for. */
+
+struct Pool
+{
+   /* The function to run on each task, and its extra argument. */
+   void (*pfRun)(void *pvTask, void *pvExtra);
+   void *pvExtra;
+
+   /* The Workers. */
+   struct Worker *psWorkers;
+   size_t uThreads;
+
+   /* The number of tasks added and not yet finished, and the number
+      of Workers waiting for a task, both updated atomically. */
+   size_t uPending;
+   size_t uSleeping;
+
+   /* The index of the Worker to be dealt the next task from outside,
+      modulo uThreads, updated atomically. */
+   size_t uNext;
+
+   /* 1 (TRUE) once the Workers are to exit, guarded by sLock. */
+   int iStopping;
+
+   /* The mutex with which Workers wait for sWork, signalled when a
+      task is added, and Pool_wait waits for sIdle, broadcast when
+      uPending drops to 0. */
+   pthread_mutex_t sLock;
+   pthread_cond_t sWork;
+   pthread_cond_t sIdle;
+
+   /* The key under which each Worker's thread finds its Worker. */
+   pthread_key_t sKey;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Push pvTask onto the new end of psWorker's deque, growing it if
+   necessary.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+static int Pool_push(struct Worker *psWorker, void *pvTask)
+{
+   void **ppvTasks;
+   size_t uCapacity;
+   size_t u;
+
+   assert(psWorker != NULL);
+
+   (void)pthread_mutex_lock(&psWorker->sLock);
+   if (psWorker->uCount == psWorker->uCapacity)
+   {
+      uCapacity = psWorker->uCapacity * 2;
+      if (uCapacity < MIN_TASKS)
+         uCapacity = MIN_TASKS;
+      ppvTasks = (void**)malloc(uCapacity * sizeof(void*));
+      if (ppvTasks == NULL)
+      {
+         (void)pthread_mutex_unlock(&psWorker->sLock);
+         return 0;
+      }
+      for (u = 0; u < psWorker->uCount; u++)
+         ppvTasks[u] = psWorker->ppvTasks[(psWorker->uFirst + u) %
+                                          psWorker->uCapacity];
+      free(psWorker->ppvTasks);
+      psWorker->ppvTasks = ppvTasks;
+      psWorker->uFirst = 0;
+      psWorker->uCapacity = uCapacity;
+   }
+   psWorker->ppvTasks[(psWorker->uFirst + psWorker->uCount) %
+                      psWorker->uCapacity] = pvTask;
+   psWorker->uCount++;
+   (void)pthread_mutex_unlock(&psWorker->sLock);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Pop and return the newest task from psWorker's deque if iNewest is
+   1 (TRUE), and its oldest otherwise, or NULL if the deque is
+   empty. */
+
+static void *Pool_pop(struct Worker *psWorker, int iNewest)
+{
+   void *pvTask = NULL;
+
+   assert(psWorker != NULL);
+
+   (void)pthread_mutex_lock(&psWorker->sLock);
+   if (psWorker->uCount > 0)
+   {
+      psWorker->uCount--;
+      if (iNewest)
+         pvTask = psWorker->ppvTasks[(psWorker->uFirst +
+                                      psWorker->uCount) %
+                                     psWorker->uCapacity];
+      else
+      {
+         pvTask = psWorker->ppvTasks[psWorker->uFirst];
+         psWorker->uFirst = (psWorker->uFirst + 1) %
+                            psWorker->uCapacity;
+      }
+   }
+   (void)pthread_mutex_unlock(&psWorker->sLock);
+   return pvTask;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next task for psWorker: its own newest, or else the
+   oldest of the first other Worker of oPool that has one.  Return
+   NULL if no Worker has a task. */
+
+static void *Pool_find(Pool_T oPool, struct Worker *psWorker)
+{
+   void *pvTask;
+   size_t uIndex;
+   size_t u;
+
+   assert(oPool != NULL);
+   assert(psWorker != NULL);
+
+   pvTask = Pool_pop(psWorker, 1);
+   uIndex = (size_t)(psWorker - oPool->psWorkers);
+   for (u = 1; pvTask == NULL && u < oPool->uThreads; u++)
+      pvTask = Pool_pop(&oPool->psWorkers[(uIndex + u) %
+                                          oPool->uThreads], 0);
+   return pvTask;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count one task of oPool as finished, waking Pool_wait if it was the
+   last. */
+
+static void Pool_finish(Pool_T oPool)
+{
+   assert(oPool != NULL);
+
+   if (__atomic_sub_fetch(&oPool->uPending, 1, __ATOMIC_SEQ_CST) == 0)
+   {
+      (void)pthread_mutex_lock(&oPool->sLock);
+      (void)pthread_cond_broadcast(&oPool->sIdle);
+      (void)pthread_mutex_unlock(&oPool->sLock);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the tasks of the Worker pvWorker, and those it steals, until
+   its Pool stops.  Return NULL. */
+
+static void *Pool_work(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   Pool_T oPool;
+   void *pvTask;
+
+   assert(psWorker != NULL);
+
+   oPool = psWorker->oPool;
+   (void)pthread_setspecific(oPool->sKey, psWorker);
+
+   for (;;)
+   {
+      pvTask = Pool_find(oPool, psWorker);
+      if (pvTask == NULL)
+      {
+         /* Announce that this Worker is waiting before looking one
+            last time, so that a task added meanwhile either is found
+            or finds the Worker waiting. */
+         (void)pthread_mutex_lock(&oPool->sLock);
+         __atomic_add_fetch(&oPool->uSleeping, 1, __ATOMIC_SEQ_CST);
+         while (! oPool->iStopping &&
+                (pvTask = Pool_find(oPool, psWorker)) == NULL)
+            (void)pthread_cond_wait(&oPool->sWork, &oPool->sLock);
+         __atomic_sub_fetch(&oPool->uSleeping, 1, __ATOMIC_SEQ_CST);
+         (void)pthread_mutex_unlock(&oPool->sLock);
+         if (pvTask == NULL)
+            return NULL;
+      }
+      (*oPool->pfRun)(pvTask, oPool->pvExtra);
+      Pool_finish(oPool);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Stop the first uStarted Workers of oPool, and then free oPool with
+   all of its Workers.  No task may be pending. */
+
+static void Pool_destroy(Pool_T oPool, size_t uStarted)
+{
+   size_t u;
+
+   assert(oPool != NULL);
+
+   (void)pthread_mutex_lock(&oPool->sLock);
+   oPool->iStopping = 1;
+   (void)pthread_cond_broadcast(&oPool->sWork);
+   (void)pthread_mutex_unlock(&oPool->sLock);
+
+   for (u = 0; u < uStarted; u++)
+      (void)pthread_join(oPool->psWorkers[u].sThread, NULL);
+
+   for (u = 0; u < oPool->uThreads; u++)
+   {
+      free(oPool->psWorkers[u].ppvTasks);
+      (void)pthread_mutex_destroy(&oPool->psWorkers[u].sLock);
+   }
+   free(oPool->psWorkers);
+   (void)pthread_key_delete(oPool->sKey);
+   (void)pthread_cond_destroy(&oPool->sIdle);
+   (void)pthread_cond_destroy(&oPool->sWork);
+   (void)pthread_mutex_destroy(&oPool->sLock);
+   free(oPool);
+}
+
+/*--------------------------------------------------------------------*/
+
+Pool_T Pool_new(size_t uThreads,
+                void (*pfRun)(void *pvTask, void *pvExtra),
+                void *pvExtra)
+{
+   Pool_T oPool;
+   size_t u;
+
+   assert(pfRun != NULL);
+
+   if (uThreads == 0)
+      return NULL;
+
+   oPool = (struct Pool*)malloc(sizeof(struct Pool));
+   if (oPool == NULL)
+      return NULL;
+   oPool->psWorkers =
+      (struct Worker*)calloc(uThreads, sizeof(struct Worker));
+   if (oPool->psWorkers == NULL)
+   {
+      free(oPool);
+      return NULL;
+   }
+
+   oPool->pfRun = pfRun;
+   oPool->pvExtra = pvExtra;
+   oPool->uThreads = uThreads;
+   oPool->uPending = 0;
+   oPool->uSleeping = 0;
+   oPool->uNext = 0;
+   oPool->iStopping = 0;
+
+   /* The default attributes need no memory, so these cannot fail
+      but for lack of keys. */
+   (void)pthread_mutex_init(&oPool->sLock, NULL);
+   (void)pthread_cond_init(&oPool->sWork, NULL);
+   (void)pthread_cond_init(&oPool->sIdle, NULL);
+   for (u = 0; u < uThreads; u++)
+   {
+      (void)pthread_mutex_init(&oPool->psWorkers[u].sLock, NULL);
+      oPool->psWorkers[u].oPool = oPool;
+   }
+   if (pthread_key_create(&oPool->sKey, NULL) != 0)
+   {
+      (void)pthread_cond_destroy(&oPool->sIdle);
+      (void)pthread_cond_destroy(&oPool->sWork);
+      (void)pthread_mutex_destroy(&oPool->sLock);
+      for (u = 0; u < uThreads; u++)
+         (void)pthread_mutex_destroy(&oPool->psWorkers[u].sLock);
+      free(oPool->psWorkers);
+      free(oPool);
+      return NULL;
+   }
+
+   for (u = 0; u < uThreads; u++)
+      if (pthread_create(&oPool->psWorkers[u].sThread, NULL,
+                         Pool_work, &oPool->psWorkers[u]) != 0)
+      {
+         Pool_destroy(oPool, u);
+         return NULL;
+      }
+
+   return oPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Pool_free(Pool_T oPool)
+{
+   if (oPool == NULL)
+      return;
+
+   Pool_wait(oPool);
+   Pool_destroy(oPool, oPool->uThreads);
+}
+
+/*--------------------------------------------------------------------*/
+
+int Pool_add(Pool_T oPool, void *pvTask)
+{
+   struct Worker *psWorker;
+   size_t uNext;
+
+   assert(oPool != NULL);
+   assert(pvTask != NULL);
+
+   psWorker = (struct Worker*)pthread_getspecific(oPool->sKey);
+   if (psWorker == NULL)
+   {
+      uNext = __atomic_fetch_add(&oPool->uNext, 1, __ATOMIC_RELAXED);
+      psWorker = &oPool->psWorkers[uNext % oPool->uThreads];
+   }
+
+   __atomic_add_fetch(&oPool->uPending, 1, __ATOMIC_SEQ_CST);
+   if (! Pool_push(psWorker, pvTask))
+   {
+      Pool_finish(oPool);
+      return 0;
+   }
+
+   if (__atomic_load_n(&oPool->uSleeping, __ATOMIC_SEQ_CST) > 0)
+   {
+      (void)pthread_mutex_lock(&oPool->sLock);
+      (void)pthread_cond_signal(&oPool->sWork);
+      (void)pthread_mutex_unlock(&oPool->sLock);
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Pool_wait(Pool_T oPool)
+{
+   assert(oPool != NULL);
+
+   (void)pthread_mutex_lock(&oPool->sLock);
+   while (__atomic_load_n(&oPool->uPending, __ATOMIC_SEQ_CST) != 0)
+      (void)pthread_cond_wait(&oPool->sIdle, &oPool->sLock);
+   (void)pthread_mutex_unlock(&oPool->sLock);
+}
@@ -0,0 +1,57 @@
+/*--------------------------------------------------------------------*/
+/* pool.h                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef POOL_INCLUDED
+#define POOL_INCLUDED
+
+#include <stddef.h>
+
+/* A Pool_T object is a set of worker threads that run tasks.  Each
+   worker keeps the tasks it is given in a deque of its own: it runs
+   the most recent of them first, so a task that adds more tasks has
+   them run while their memory is still in the cache, and a worker
+   with nothing left steals the oldest task of another, which tends to
+   be the largest.  Tasks added by threads outside the Pool are dealt
+   to the workers in turn. */
+
+typedef struct Pool *Pool_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new Pool_T object with uThreads worker threads, which run
+   each task pvTask added to it by calling (*pfRun)(pvTask, pvExtra),
+   or NULL if uThreads is 0, or if insufficient memory is available
+   or a thread cannot be started. */
+
+Pool_T Pool_new(size_t uThreads,
+                void (*pfRun)(void *pvTask, void *pvExtra),
+                void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Wait for every task added to oPool, including those added by its
+   tasks, to finish, and then stop its workers and free oPool.  No
+   thread outside oPool may add a task during the call.  oPool may be
+   NULL, in which case nothing is freed. */
+
+void Pool_free(Pool_T oPool);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvTask, which must not be NULL, to oPool, to be run by one of
+   its workers.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available, in which case pvTask is not run.
+   May be called by oPool's tasks as well as by any other thread. */
+
+int Pool_add(Pool_T oPool, void *pvTask);
+
+/*--------------------------------------------------------------------*/
+
+/* Wait until every task added to oPool so far, and every task they
+   add, has finished.  Must not be called by oPool's tasks. */
+
+void Pool_wait(Pool_T oPool);
+
+#endif
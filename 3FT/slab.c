@@ -0,0 +1,633 @@
+/*--------------------------------------------------------------------*/
+/* slab.c                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+/* for pthread_mutex_t, which -ansi would otherwise hide */
+#define _POSIX_C_SOURCE 200112L
+
+#include "slab.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Records are made of GRANULE-byte granules, and chunks, which are
+   CHUNK_SIZE bytes, of 2 to the OFFSET_BITS granules.  An index is a
+   chunk's number followed by the OFFSET_BITS bits of a granule's
+   offset within it, and chunks are numbered below MAX_CHUNKS, so
+   that every index fits in 31 bits. */
+
+enum { GRANULE = 8, OFFSET_BITS = 13, MAX_CHUNKS = 1 << 18 };
+
+enum { CHUNK_SIZE = GRANULE << OFFSET_BITS };
+
+/* Record sizes are rounded up to a multiple of GRANULE up to
+   MAX_SMALL_SIZE, and of MAX_SMALL_SIZE beyond it, and each rounded
+   size has its own free list.  A record of at most MAX_RECORD_SIZE
+   bytes is allocated from a chunk, since its rounded size still fits
+   in one after the chunk's header.  A larger record is a large
+   record: it has a block of its own from the heap, aligned as a
+   chunk is, which it spans beyond the block's first CHUNK_SIZE
+   bytes, and which takes a chunk's number. */
+
+enum { MAX_SMALL_SIZE = 512, MAX_RECORD_SIZE = CHUNK_SIZE - 512 };
+
+/* The number of free lists. */
+
+enum { SIZE_CLASSES = MAX_SMALL_SIZE / GRANULE +
+                      CHUNK_SIZE / MAX_SMALL_SIZE };
+
+/* The most chunks that are allocated from the heap at once.  The
+   first block of chunks holds one, and each later block twice as
+   many as the one before, up to this. */
+
+enum { MAX_BLOCK_CHUNKS = 32 };
+
+/*--------------------------------------------------------------------*/
+
+/* A ChunkHeader occupies the first bytes of each chunk, so that a
+   record's Slab and index can be found from its address. */
+
+union ChunkHeader
+{
+   /* The fields. */
+   struct
+   {
+      /* The Slab to which the chunk belongs. */
+      Slab_T oSlab;
+
+      /* The number of the chunk within the Slab. */
+      unsigned int uNumber;
+   } sFields;
+
+   /* Padding, to a whole number of granules. */
+   char acPadding[2 * GRANULE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Large follows the ChunkHeader of the block of a large record, and
+   links the block into its Slab's list of them, so that each can be
+   freed on its own. */
+
+struct Large
+{
+   /* The block as it was allocated, before it was aligned. */
+   void *pvMemory;
+
+   /* The previous and the next Large in the list. */
+   struct Large *psPrev;
+   struct Large *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Block is a block of chunks allocated from the heap at once. */
+
+struct Block
+{
+   /* The block as it was allocated, before its chunks were aligned. */
+   void *pvMemory;
+
+   /* The Block allocated before this one. */
+   struct Block *psNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Slab consists of a directory of its chunks, the unused part of
+   the most recent chunk, the chunks allocated but not yet used, a
+   free list per record size, and its large records. */
+
+struct Slab
+{
+   /* The directory, an array of uMaxChunks + 1 pointers: element 0 is
+      the directory that this one replaced, or NULL, kept until the
+      Slab is freed since a reader may still be using it, and element
+      n + 1 is the address of chunk n. */
+   char **ppcChunks;
+
+   /* The number of chunks in use, and that the directory can hold. */
+   size_t uChunks;
+   size_t uMaxChunks;
+
+   /* The next unused byte of the most recent chunk, and its end. */
+   char *pcNext;
+   char *pcEnd;
+
+   /* The chunks of the most recent block not yet in use: the first of
+      them, and how many there are. */
+   char *pcSpare;
+   size_t uSpare;
+
+   /* The number of chunks in the next block. */
+   size_t uBlockChunks;
+
+   /* The blocks, most recent first. */
+   struct Block *psBlocks;
+
+   /* The blocks of the large records, most recent first. */
+   struct Large *psLarges;
+
+   /* The numbers of the chunks of released large records, which later
+      large records reuse: an array of uMaxFreeNumbers numbers, of
+      which uFreeNumbers are in use. */
+   unsigned int *puFreeNumbers;
+   size_t uFreeNumbers;
+   size_t uMaxFreeNumbers;
+
+   /* The indices of the first released record of each size class, or
+      0.  The first bytes of each released record hold the index of
+      the next one. */
+   unsigned int auFreeLists[SIZE_CLASSES];
+
+   /* The client's pointer, or NULL. */
+   void *pvClient;
+
+   /* The mutex serializing the use of a shared Slab, or NULL if the
+      Slab is not shared. */
+   pthread_mutex_t *psLock;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the header of the chunk that holds pvRecord. */
+
+static union ChunkHeader *Slab_header(const void *pvRecord)
+{
+   assert(pvRecord != NULL);
+
+   return (union ChunkHeader*)
+      ((size_t)pvRecord & ~(size_t)(CHUNK_SIZE - 1));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize rounded up to a size class, and store the number of
+   that class in *puClass. */
+
+static size_t Slab_round(size_t uSize, size_t *puClass)
+{
+   assert(puClass != NULL);
+
+   if (uSize == 0)
+      uSize = GRANULE;
+   if (uSize <= MAX_SMALL_SIZE)
+   {
+      uSize = (uSize + GRANULE - 1) / GRANULE * GRANULE;
+      *puClass = uSize / GRANULE - 1;
+      return uSize;
+   }
+   uSize = (uSize + MAX_SMALL_SIZE - 1) / MAX_SMALL_SIZE *
+           MAX_SMALL_SIZE;
+   *puClass = MAX_SMALL_SIZE / GRANULE + uSize / MAX_SMALL_SIZE - 2;
+   return uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+Slab_T Slab_new(int iShared)
+{
+   Slab_T oSlab;
+   size_t u;
+
+   oSlab = (struct Slab*)malloc(sizeof(struct Slab));
+   if (oSlab == NULL)
+      return NULL;
+
+   oSlab->ppcChunks = NULL;
+   oSlab->uChunks = 0;
+   oSlab->uMaxChunks = 0;
+   oSlab->pcNext = NULL;
+   oSlab->pcEnd = NULL;
+   oSlab->pcSpare = NULL;
+   oSlab->uSpare = 0;
+   oSlab->uBlockChunks = 1;
+   oSlab->psBlocks = NULL;
+   oSlab->psLarges = NULL;
+   oSlab->puFreeNumbers = NULL;
+   oSlab->uFreeNumbers = 0;
+   oSlab->uMaxFreeNumbers = 0;
+   for (u = 0; u < SIZE_CLASSES; u++)
+      oSlab->auFreeLists[u] = 0;
+   oSlab->pvClient = NULL;
+   oSlab->psLock = NULL;
+
+   if (!iShared)
+      return oSlab;
+
+   oSlab->psLock = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+   if (oSlab->psLock == NULL)
+   {
+      free(oSlab);
+      return NULL;
+   }
+   if (pthread_mutex_init(oSlab->psLock, NULL) != 0)
+   {
+      free(oSlab->psLock);
+      free(oSlab);
+      return NULL;
+   }
+
+   return oSlab;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Slab_free(Slab_T oSlab)
+{
+   struct Block *psBlock;
+   struct Block *psNextBlock;
+   struct Large *psLarge;
+   struct Large *psNextLarge;
+   char **ppcChunks;
+   char **ppcOldChunks;
+
+   if (oSlab == NULL)
+      return;
+
+   for (psBlock = oSlab->psBlocks; psBlock != NULL;
+        psBlock = psNextBlock)
+   {
+      psNextBlock = psBlock->psNext;
+      free(psBlock->pvMemory);
+      free(psBlock);
+   }
+
+   for (psLarge = oSlab->psLarges; psLarge != NULL;
+        psLarge = psNextLarge)
+   {
+      psNextLarge = psLarge->psNext;
+      free(psLarge->pvMemory);
+   }
+   free(oSlab->puFreeNumbers);
+
+   for (ppcChunks = oSlab->ppcChunks; ppcChunks != NULL;
+        ppcChunks = ppcOldChunks)
+   {
+      ppcOldChunks = (char**)ppcChunks[0];
+      free(ppcChunks);
+   }
+
+   if (oSlab->psLock != NULL)
+   {
+      (void)pthread_mutex_destroy(oSlab->psLock);
+      free(oSlab->psLock);
+   }
+   free(oSlab);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Allocate a new block of chunks for oSlab from the heap.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Slab_addBlock(Slab_T oSlab)
+{
+   struct Block *psBlock;
+   size_t uAddress;
+
+   assert(oSlab != NULL);
+
+   psBlock = (struct Block*)malloc(sizeof(struct Block));
+   if (psBlock == NULL)
+      return 0;
+
+   /* One chunk more than is used, so that they can be aligned. */
+   psBlock->pvMemory = malloc((oSlab->uBlockChunks + 1) * CHUNK_SIZE);
+   if (psBlock->pvMemory == NULL)
+   {
+      free(psBlock);
+      return 0;
+   }
+   psBlock->psNext = oSlab->psBlocks;
+   oSlab->psBlocks = psBlock;
+
+   uAddress = ((size_t)psBlock->pvMemory + CHUNK_SIZE - 1) &
+              ~(size_t)(CHUNK_SIZE - 1);
+   oSlab->pcSpare = (char*)uAddress;
+   oSlab->uSpare = oSlab->uBlockChunks;
+   if (oSlab->uBlockChunks < MAX_BLOCK_CHUNKS)
+      oSlab->uBlockChunks *= 2;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSlab's directory for another chunk.  The directory
+   is replaced by a larger copy, rather than resized in place, so that
+   a reader may go on using the old one.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+static int Slab_growDirectory(Slab_T oSlab)
+{
+   char **ppcChunks;
+   size_t uMaxChunks;
+
+   assert(oSlab != NULL);
+
+   uMaxChunks = (oSlab->uMaxChunks == 0) ? 4 : 2 * oSlab->uMaxChunks;
+   ppcChunks = (char**)malloc((uMaxChunks + 1) * sizeof(char*));
+   if (ppcChunks == NULL)
+      return 0;
+
+   ppcChunks[0] = (char*)oSlab->ppcChunks;
+   if (oSlab->uChunks > 0)
+      memcpy(ppcChunks + 1, oSlab->ppcChunks + 1,
+             oSlab->uChunks * sizeof(char*));
+   __atomic_store_n(&oSlab->ppcChunks, ppcChunks, __ATOMIC_RELEASE);
+   oSlab->uMaxChunks = uMaxChunks;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure that oSlab's directory has room for another chunk.
+   Return 1 (TRUE) if it does, or 0 (FALSE) if insufficient memory is
+   available or oSlab has as many chunks as indices can name. */
+
+static int Slab_makeRoom(Slab_T oSlab)
+{
+   assert(oSlab != NULL);
+
+   if (oSlab->uChunks == MAX_CHUNKS)
+      return 0;
+   if (oSlab->uChunks == oSlab->uMaxChunks &&
+       !Slab_growDirectory(oSlab))
+      return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start a new chunk for oSlab to allocate records from.  The rest of
+   the old chunk is abandoned until the Slab is freed.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available or oSlab has as many chunks as indices can name. */
+
+static int Slab_addChunk(Slab_T oSlab)
+{
+   union ChunkHeader *psHeader;
+
+   assert(oSlab != NULL);
+
+   if (!Slab_makeRoom(oSlab))
+      return 0;
+   if (oSlab->uSpare == 0 && !Slab_addBlock(oSlab))
+      return 0;
+
+   psHeader = (union ChunkHeader*)oSlab->pcSpare;
+   oSlab->pcSpare += CHUNK_SIZE;
+   oSlab->uSpare--;
+
+   psHeader->sFields.oSlab = oSlab;
+   psHeader->sFields.uNumber = (unsigned int)oSlab->uChunks;
+   oSlab->ppcChunks[oSlab->uChunks + 1] = (char*)psHeader;
+   oSlab->uChunks++;
+
+   oSlab->pcNext = (char*)(psHeader + 1);
+   oSlab->pcEnd = (char*)psHeader + CHUNK_SIZE;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a large record of uSize bytes from oSlab, in a block of its
+   own, with the number of a released large record's chunk if there is
+   one, or else a new one, or NULL if insufficient memory is available
+   or oSlab has as many chunks as indices can name. */
+
+static void *Slab_allocLarge(Slab_T oSlab, size_t uSize)
+{
+   union ChunkHeader *psHeader;
+   struct Large *psLarge;
+   void *pvMemory;
+   size_t uAddress;
+   unsigned int uNumber;
+
+   assert(oSlab != NULL);
+
+   if (oSlab->uFreeNumbers == 0 && !Slab_makeRoom(oSlab))
+      return NULL;
+
+   /* One chunk more than is used, so that it can be aligned. */
+   pvMemory = malloc(CHUNK_SIZE + sizeof(union ChunkHeader) +
+                     sizeof(struct Large) + uSize);
+   if (pvMemory == NULL)
+      return NULL;
+
+   uAddress = ((size_t)pvMemory + CHUNK_SIZE - 1) &
+              ~(size_t)(CHUNK_SIZE - 1);
+   psHeader = (union ChunkHeader*)uAddress;
+   psLarge = (struct Large*)(psHeader + 1);
+   psLarge->pvMemory = pvMemory;
+   psLarge->psPrev = NULL;
+   psLarge->psNext = oSlab->psLarges;
+   if (oSlab->psLarges != NULL)
+      oSlab->psLarges->psPrev = psLarge;
+   oSlab->psLarges = psLarge;
+
+   if (oSlab->uFreeNumbers > 0)
+      uNumber = oSlab->puFreeNumbers[--oSlab->uFreeNumbers];
+   else
+      uNumber = (unsigned int)oSlab->uChunks++;
+   psHeader->sFields.oSlab = oSlab;
+   psHeader->sFields.uNumber = uNumber;
+   oSlab->ppcChunks[uNumber + 1] = (char*)psHeader;
+   return psLarge + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvRecord, a large record of oSlab, to the heap, and keep the
+   number of its chunk for a later large record, if there is memory
+   to keep it in. */
+
+static void Slab_releaseLarge(Slab_T oSlab, void *pvRecord)
+{
+   struct Large *psLarge;
+   unsigned int *puFreeNumbers;
+   size_t uMaxFreeNumbers;
+
+   assert(oSlab != NULL);
+   assert(pvRecord != NULL);
+
+   psLarge = (struct Large*)pvRecord - 1;
+   if (psLarge->psPrev != NULL)
+      psLarge->psPrev->psNext = psLarge->psNext;
+   else
+      oSlab->psLarges = psLarge->psNext;
+   if (psLarge->psNext != NULL)
+      psLarge->psNext->psPrev = psLarge->psPrev;
+
+   if (oSlab->uFreeNumbers == oSlab->uMaxFreeNumbers)
+   {
+      uMaxFreeNumbers = (oSlab->uMaxFreeNumbers == 0) ? 4 :
+                        2 * oSlab->uMaxFreeNumbers;
+      puFreeNumbers = (unsigned int*)realloc(oSlab->puFreeNumbers,
+         uMaxFreeNumbers * sizeof(unsigned int));
+      if (puFreeNumbers != NULL)
+      {
+         oSlab->puFreeNumbers = puFreeNumbers;
+         oSlab->uMaxFreeNumbers = uMaxFreeNumbers;
+      }
+   }
+   if (oSlab->uFreeNumbers < oSlab->uMaxFreeNumbers)
+      oSlab->puFreeNumbers[oSlab->uFreeNumbers++] =
+         Slab_header(pvRecord)->sFields.uNumber;
+
+   free(psLarge->pvMemory);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a record of at least uSize bytes from oSlab, as Slab_alloc
+   does, without locking oSlab. */
+
+static void *Slab_allocUnlocked(Slab_T oSlab, size_t uSize)
+{
+   size_t uClass;
+   unsigned int uIndex;
+   void *pvRecord;
+
+   assert(oSlab != NULL);
+
+   if (uSize > MAX_RECORD_SIZE)
+      return Slab_allocLarge(oSlab, uSize);
+   uSize = Slab_round(uSize, &uClass);
+
+   /* Reuse a released record of the same size, if there is one. */
+   uIndex = oSlab->auFreeLists[uClass];
+   if (uIndex != 0)
+   {
+      pvRecord = Slab_at(oSlab, uIndex);
+      oSlab->auFreeLists[uClass] = *(unsigned int*)pvRecord;
+      return pvRecord;
+   }
+
+   /* Otherwise bump the pointer, starting a new chunk if need be. */
+   if ((size_t)(oSlab->pcEnd - oSlab->pcNext) < uSize &&
+       !Slab_addChunk(oSlab))
+      return NULL;
+
+   pvRecord = oSlab->pcNext;
+   oSlab->pcNext += uSize;
+   return pvRecord;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvRecord, of size uSize, to oSlab, as Slab_release does,
+   without locking oSlab. */
+
+static void Slab_releaseUnlocked(Slab_T oSlab, void *pvRecord,
+                                 size_t uSize)
+{
+   size_t uClass;
+
+   assert(oSlab != NULL);
+   assert(pvRecord != NULL);
+   assert(Slab_of(pvRecord) == oSlab);
+
+   if (uSize > MAX_RECORD_SIZE)
+   {
+      Slab_releaseLarge(oSlab, pvRecord);
+      return;
+   }
+   (void)Slab_round(uSize, &uClass);
+   *(unsigned int*)pvRecord = oSlab->auFreeLists[uClass];
+   oSlab->auFreeLists[uClass] = Slab_indexOf(pvRecord);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Slab_alloc(Slab_T oSlab, size_t uSize)
+{
+   void *pvRecord;
+
+   assert(oSlab != NULL);
+
+   if (oSlab->psLock == NULL)
+      return Slab_allocUnlocked(oSlab, uSize);
+
+   (void)pthread_mutex_lock(oSlab->psLock);
+   pvRecord = Slab_allocUnlocked(oSlab, uSize);
+   (void)pthread_mutex_unlock(oSlab->psLock);
+   return pvRecord;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Slab_release(Slab_T oSlab, void *pvRecord, size_t uSize)
+{
+   assert(oSlab != NULL);
+   assert(pvRecord != NULL);
+
+   if (oSlab->psLock == NULL)
+   {
+      Slab_releaseUnlocked(oSlab, pvRecord, uSize);
+      return;
+   }
+
+   (void)pthread_mutex_lock(oSlab->psLock);
+   Slab_releaseUnlocked(oSlab, pvRecord, uSize);
+   (void)pthread_mutex_unlock(oSlab->psLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+Slab_T Slab_of(const void *pvRecord)
+{
+   assert(pvRecord != NULL);
+
+   return Slab_header(pvRecord)->sFields.oSlab;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Slab_setClient(Slab_T oSlab, void *pvClient)
+{
+   assert(oSlab != NULL);
+
+   oSlab->pvClient = pvClient;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Slab_getClient(Slab_T oSlab)
+{
+   assert(oSlab != NULL);
+
+   return oSlab->pvClient;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int Slab_indexOf(const void *pvRecord)
+{
+   size_t uOffset;
+
+   assert(pvRecord != NULL);
+
+   uOffset = (size_t)pvRecord & (CHUNK_SIZE - 1);
+   return (Slab_header(pvRecord)->sFields.uNumber << OFFSET_BITS) |
+          (unsigned int)(uOffset / GRANULE);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *Slab_at(Slab_T oSlab, unsigned int uIndex)
+{
+   char **ppcChunks;
+
+   assert(oSlab != NULL);
+   assert(uIndex != 0);
+
+   ppcChunks = __atomic_load_n(&oSlab->ppcChunks, __ATOMIC_ACQUIRE);
+   return ppcChunks[(uIndex >> OFFSET_BITS) + 1] +
+          (size_t)(uIndex & ((1 << OFFSET_BITS) - 1)) * GRANULE;
+}
@@ -0,0 +1,97 @@
+/*--------------------------------------------------------------------*/
+/* slab.h                                                             */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SLAB_INCLUDED
+#define SLAB_INCLUDED
+
+#include <stddef.h>
+
+/* A Slab_T object is a growable store of small records, each of
+   which is named by a 32-bit unsigned int index as well as by its
+   address, so that records can refer to one another in half the
+   space of a pointer.  Records are bump-allocated from chunks that
+   never move, and released records are recycled through free lists
+   kept per record size, but for records too large for a chunk, each
+   of which is allocated from the heap on its own.  The chunks, and
+   those records' blocks, are aligned to the chunk size, so that a
+   record's own index, and the Slab_T it belongs to, are found from
+   its address alone.
+
+   The index 0 names no record. */
+
+typedef struct Slab *Slab_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Slab_T object, or NULL if insufficient memory
+   is available.  If iShared is 1 (TRUE), the Slab may be used by
+   several threads at once: its allocations and releases are
+   serialized by a mutex.  Slab_at never locks. */
+
+Slab_T Slab_new(int iShared);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oSlab and every record that was ever allocated from it,
+   whether or not it was released.  oSlab may be NULL, in which case
+   nothing is freed. */
+
+void Slab_free(Slab_T oSlab);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a record of at least uSize bytes from oSlab, aligned for
+   any object of at most eight bytes, or NULL if insufficient memory
+   is available.  A record of more than a chunk can hold, which is
+   just under 64 kilobytes, has a block of the heap to itself, which
+   it gives back when it is released. */
+
+void *Slab_alloc(Slab_T oSlab, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvRecord, which was allocated from oSlab with size uSize,
+   so that it can be reused by a later allocation of the same size. */
+
+void Slab_release(Slab_T oSlab, void *pvRecord, size_t uSize);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the Slab_T object from which pvRecord was allocated. */
+
+Slab_T Slab_of(const void *pvRecord);
+
+/*--------------------------------------------------------------------*/
+
+/* Attach pvClient to oSlab, for whatever use its client makes of it,
+   such as finding, from a record, other state kept with the records
+   of oSlab.  A new Slab_T object has NULL attached. */
+
+void Slab_setClient(Slab_T oSlab, void *pvClient);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the pointer last attached to oSlab by Slab_setClient. */
+
+void *Slab_getClient(Slab_T oSlab);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of pvRecord, which was allocated from a Slab_T
+   object.  The index is nonzero and less than 2 to the 31st power,
+   so that a client may use the remaining bit as a tag. */
+
+unsigned int Slab_indexOf(const void *pvRecord);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the record of oSlab whose index is uIndex, which must be
+   nonzero.  May be called without locking, by a thread that has
+   learned uIndex through some other synchronization with the thread
+   that allocated the record. */
+
+void *Slab_at(Slab_T oSlab, unsigned int uIndex);
+
+#endif
@@ -0,0 +1,776 @@
+/*--------------------------------------------------------------------*/
+/* snapshot.c                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "snapshot.h"
+#include "bitvec.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of names in each block of the name stream, of which only
+   the first is stored whole. */
+
+enum { NAMES_PER_BLOCK = 16 };
+
+/* The least number of entries, and of bytes of names, for which room
+   is made at once. */
+
+enum { MIN_ENTRIES = 64, MIN_NAMES = 1024 };
+
+/* The most bytes that a number takes in the name stream, at 7 bits
+   per byte. */
+
+enum { MAX_NUMBER_BYTES = (sizeof(size_t) * 8 + 6) / 7 };
+
+/*--------------------------------------------------------------------*/
+
+/* A Snapshot consists of its shape, the marks of its files, and its
+   name stream, with what is needed only while it is being built. */
+
+struct Snapshot
+{
+   /* The number of entries. */
+   size_t uLength;
+
+   /* The shape: a 1 and a 0 for a root above the real one, and then,
+      for each entry in turn, a 1 for each of its children and a 0.
+      The children of entry e are thus the entries after the (e + 1)st
+      0, one for each 1 between it and the next 0, and they are
+      numbered in order from the number of 1s before it.  Until the
+      Snapshot is finished, its uShapeLength bits are in puShape, which
+      has room for uShapeWords words, and oShape is NULL. */
+   BitVec_T oShape;
+   size_t *puShape;
+   size_t uShapeLength;
+   size_t uShapeWords;
+
+   /* A bit for each entry, set for files.  Until the Snapshot is
+      finished, the bits are in puFiles, which has room for uFileWords
+      words, and oFiles is NULL. */
+   BitVec_T oFiles;
+   size_t *puFiles;
+   size_t uFileWords;
+
+   /* The name stream, of uNamesLength bytes, with room for
+      uNamesCapacity.  For each entry, the length of the prefix that
+      its name shares with the name before it, which is 0 for the first
+      of each block, the length of the rest of the name, and the rest
+      of the name, and, for a file, its length.  The block of entry e
+      begins at byte puBlocks[e / NAMES_PER_BLOCK]. */
+   unsigned char *pucNames;
+   size_t uNamesLength;
+   size_t uNamesCapacity;
+   size_t *puBlocks;
+
+   /* The number of characters that Snapshot_map needs for a path. */
+   size_t uBufferLength;
+
+   /* While the Snapshot is being built: the length of the full path of
+      each entry, and the number of children of each, with room for
+      uCapacity entries; the directory whose children are being added,
+      and how many have been; the last name added, with room for
+      uLastCapacity characters; and the length of the longest name in
+      the current block. */
+   size_t *puPathLengths;
+   size_t *puDegrees;
+   size_t uCapacity;
+   size_t uParent;
+   size_t uPlaced;
+   char *pcLast;
+   size_t uLastCapacity;
+   size_t uBlockNameLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append the bit iBit to the array *ppuWords, which holds *puLength
+   bits and has room for *puWords words, growing it as needed.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+static int Snapshot_pushBit(size_t **ppuWords, size_t *puLength,
+                            size_t *puWords, int iBit)
+{
+   size_t *puGrown;
+   size_t uWords;
+
+   assert(ppuWords != NULL);
+   assert(puLength != NULL);
+   assert(puWords != NULL);
+
+   if (*puLength == *puWords * BITVEC_WORD_BITS)
+   {
+      uWords = 2 * *puWords;
+      if (uWords < MIN_ENTRIES / BITVEC_WORD_BITS + 1)
+         uWords = MIN_ENTRIES / BITVEC_WORD_BITS + 1;
+      puGrown = (size_t*)realloc(*ppuWords, uWords * sizeof(size_t));
+      if (puGrown == NULL)
+         return 0;
+      memset(puGrown + *puWords, 0,
+             (uWords - *puWords) * sizeof(size_t));
+      *ppuWords = puGrown;
+      *puWords = uWords;
+   }
+
+   if (iBit)
+      (*ppuWords)[*puLength / BITVEC_WORD_BITS] |=
+         (size_t)1 << (*puLength % BITVEC_WORD_BITS);
+   (*puLength)++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append uNumber to the name stream of oSnapshot, 7 bits to a byte,
+   low bits first, with the high bit of each byte but the last set.
+   The stream must have room for it. */
+
+static void Snapshot_putNumber(Snapshot_T oSnapshot, size_t uNumber)
+{
+   assert(oSnapshot != NULL);
+
+   while (uNumber >= 0x80)
+   {
+      oSnapshot->pucNames[oSnapshot->uNamesLength++] =
+         (unsigned char)(uNumber | 0x80);
+      uNumber >>= 7;
+   }
+   oSnapshot->pucNames[oSnapshot->uNamesLength++] =
+      (unsigned char)uNumber;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number at *ppucStream, and advance *ppucStream past
+   it. */
+
+static size_t Snapshot_getNumber(const unsigned char **ppucStream)
+{
+   size_t uNumber = 0;
+   size_t uShift = 0;
+   unsigned char ucByte;
+
+   assert(ppucStream != NULL);
+
+   do
+   {
+      ucByte = *(*ppucStream)++;
+      uNumber |= (size_t)(ucByte & 0x7f) << uShift;
+      uShift += 7;
+   } while (ucByte & 0x80);
+   return uNumber;
+}
+
+/*--------------------------------------------------------------------*/
+
+Snapshot_T Snapshot_new(void)
+{
+   Snapshot_T oSnapshot;
+
+   oSnapshot = (Snapshot_T)calloc(1, sizeof(struct Snapshot));
+   if (oSnapshot == NULL)
+      return NULL;
+
+   /* The root above the root has the root as its only child. */
+   if (! Snapshot_pushBit(&oSnapshot->puShape, &oSnapshot->uShapeLength,
+                          &oSnapshot->uShapeWords, 1) ||
+       ! Snapshot_pushBit(&oSnapshot->puShape, &oSnapshot->uShapeLength,
+                          &oSnapshot->uShapeWords, 0))
+   {
+      Snapshot_free(oSnapshot);
+      return NULL;
+   }
+   return oSnapshot;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Snapshot_free(Snapshot_T oSnapshot)
+{
+   if (oSnapshot == NULL)
+      return;
+
+   BitVec_free(oSnapshot->oShape);
+   BitVec_free(oSnapshot->oFiles);
+   free(oSnapshot->puShape);
+   free(oSnapshot->puFiles);
+   free(oSnapshot->pucNames);
+   free(oSnapshot->puBlocks);
+   free(oSnapshot->puPathLengths);
+   free(oSnapshot->puDegrees);
+   free(oSnapshot->pcLast);
+   free(oSnapshot);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSnapshot for one more entry, with a name of
+   uNameLength characters.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if insufficient memory is available. */
+
+static int Snapshot_reserve(Snapshot_T oSnapshot, size_t uNameLength)
+{
+   size_t *puGrown;
+   unsigned char *pucNames;
+   char *pcLast;
+   size_t uCapacity;
+   size_t uNeeded;
+
+   assert(oSnapshot != NULL);
+
+   if (oSnapshot->uLength == oSnapshot->uCapacity)
+   {
+      uCapacity = 2 * oSnapshot->uCapacity;
+      if (uCapacity < MIN_ENTRIES)
+         uCapacity = MIN_ENTRIES;
+      puGrown = (size_t*)realloc(oSnapshot->puPathLengths,
+                                 uCapacity * sizeof(size_t));
+      if (puGrown == NULL)
+         return 0;
+      oSnapshot->puPathLengths = puGrown;
+      puGrown = (size_t*)realloc(oSnapshot->puDegrees,
+                                 uCapacity * sizeof(size_t));
+      if (puGrown == NULL)
+         return 0;
+      oSnapshot->puDegrees = puGrown;
+      puGrown = (size_t*)realloc(oSnapshot->puBlocks,
+                                 (uCapacity / NAMES_PER_BLOCK) *
+                                 sizeof(size_t));
+      if (puGrown == NULL)
+         return 0;
+      oSnapshot->puBlocks = puGrown;
+      oSnapshot->uCapacity = uCapacity;
+   }
+
+   uNeeded = uNameLength + 3 * MAX_NUMBER_BYTES;
+   if (oSnapshot->uNamesCapacity - oSnapshot->uNamesLength < uNeeded)
+   {
+      uCapacity = 2 * oSnapshot->uNamesCapacity;
+      if (uCapacity < MIN_NAMES)
+         uCapacity = MIN_NAMES;
+      if (uCapacity - oSnapshot->uNamesLength < uNeeded)
+         uCapacity = oSnapshot->uNamesLength + uNeeded;
+      pucNames = (unsigned char*)realloc(oSnapshot->pucNames,
+                                         uCapacity);
+      if (pucNames == NULL)
+         return 0;
+      oSnapshot->pucNames = pucNames;
+      oSnapshot->uNamesCapacity = uCapacity;
+   }
+
+   if (oSnapshot->uLastCapacity <= uNameLength)
+   {
+      pcLast = (char*)realloc(oSnapshot->pcLast, uNameLength + 1);
+      if (pcLast == NULL)
+         return 0;
+      oSnapshot->pcLast = pcLast;
+      oSnapshot->uLastCapacity = uNameLength + 1;
+   }
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Snapshot_add(Snapshot_T oSnapshot, const char *pcName, int iIsFile,
+                 size_t uLength, size_t uChildren)
+{
+   size_t uEntry;
+   size_t uNameLength;
+   size_t uShared = 0;
+   size_t uBase = 0;
+   size_t u;
+
+   assert(oSnapshot != NULL);
+   assert(pcName != NULL);
+   assert(oSnapshot->oShape == NULL);
+   assert(! iIsFile || uChildren == 0);
+
+   uEntry = oSnapshot->uLength;
+   uNameLength = strlen(pcName);
+   if (! Snapshot_reserve(oSnapshot, uNameLength))
+      return 0;
+
+   for (u = 0; u < uChildren; u++)
+      if (! Snapshot_pushBit(&oSnapshot->puShape,
+                             &oSnapshot->uShapeLength,
+                             &oSnapshot->uShapeWords, 1))
+         return 0;
+   if (! Snapshot_pushBit(&oSnapshot->puShape,
+                          &oSnapshot->uShapeLength,
+                          &oSnapshot->uShapeWords, 0))
+      return 0;
+   u = uEntry;
+   if (! Snapshot_pushBit(&oSnapshot->puFiles, &u,
+                          &oSnapshot->uFileWords, iIsFile))
+      return 0;
+
+   /* The entry is the next child of the first directory with children
+      still to come. */
+   if (uEntry > 0)
+   {
+      while (oSnapshot->uPlaced ==
+             oSnapshot->puDegrees[oSnapshot->uParent])
+      {
+         oSnapshot->uParent++;
+         oSnapshot->uPlaced = 0;
+         assert(oSnapshot->uParent < uEntry);
+      }
+      oSnapshot->uPlaced++;
+      uBase = oSnapshot->puPathLengths[oSnapshot->uParent] + 1;
+   }
+   oSnapshot->puPathLengths[uEntry] = uBase + uNameLength;
+   oSnapshot->puDegrees[uEntry] = uChildren;
+
+   if (uEntry % NAMES_PER_BLOCK == 0)
+   {
+      oSnapshot->puBlocks[uEntry / NAMES_PER_BLOCK] =
+         oSnapshot->uNamesLength;
+      oSnapshot->uBlockNameLength = 0;
+   }
+   else
+      while (pcName[uShared] != '\0' &&
+             pcName[uShared] == oSnapshot->pcLast[uShared])
+         uShared++;
+
+   Snapshot_putNumber(oSnapshot, uShared);
+   Snapshot_putNumber(oSnapshot, uNameLength - uShared);
+   memcpy(oSnapshot->pucNames + oSnapshot->uNamesLength,
+          pcName + uShared, uNameLength - uShared);
+   oSnapshot->uNamesLength += uNameLength - uShared;
+   if (iIsFile)
+      Snapshot_putNumber(oSnapshot, uLength);
+   memcpy(oSnapshot->pcLast, pcName, uNameLength + 1);
+
+   /* Decoding the name in a buffer passes through the longer names
+      before it in its block. */
+   if (uNameLength > oSnapshot->uBlockNameLength)
+      oSnapshot->uBlockNameLength = uNameLength;
+   if (uBase + oSnapshot->uBlockNameLength + 1 >
+       oSnapshot->uBufferLength)
+      oSnapshot->uBufferLength =
+         uBase + oSnapshot->uBlockNameLength + 1;
+
+   oSnapshot->uLength++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Snapshot_finish(Snapshot_T oSnapshot)
+{
+   void *pvShrunk;
+
+   assert(oSnapshot != NULL);
+   assert(oSnapshot->oShape == NULL);
+   assert(oSnapshot->uShapeLength == 2 * oSnapshot->uLength + 1 ||
+          oSnapshot->uLength == 0);
+
+   oSnapshot->oShape = BitVec_new(oSnapshot->puShape,
+                                  oSnapshot->uShapeLength);
+   if (oSnapshot->oShape == NULL)
+      return 0;
+   oSnapshot->puShape = NULL;
+
+   oSnapshot->oFiles = BitVec_new(oSnapshot->puFiles,
+                                  oSnapshot->uLength);
+   if (oSnapshot->oFiles == NULL)
+      return 0;
+   oSnapshot->puFiles = NULL;
+
+   /* What was needed only for building goes, and the name stream is
+      cut to its length. */
+   free(oSnapshot->puPathLengths);
+   free(oSnapshot->puDegrees);
+   free(oSnapshot->pcLast);
+   oSnapshot->puPathLengths = NULL;
+   oSnapshot->puDegrees = NULL;
+   oSnapshot->pcLast = NULL;
+   if (oSnapshot->uNamesLength > 0)
+   {
+      pvShrunk = realloc(oSnapshot->pucNames, oSnapshot->uNamesLength);
+      if (pvShrunk != NULL)
+         oSnapshot->pucNames = (unsigned char*)pvShrunk;
+   }
+   if (oSnapshot->uLength > 0)
+   {
+      pvShrunk = realloc(oSnapshot->puBlocks,
+                         ((oSnapshot->uLength - 1) / NAMES_PER_BLOCK
+                          + 1) * sizeof(size_t));
+      if (pvShrunk != NULL)
+         oSnapshot->puBlocks = (size_t*)pvShrunk;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *puFirst the first child of the directory uEntry of the
+   finished oSnapshot, in *puFiles the number of its children that are
+   files, and in *puCount the number of its children. */
+
+static void Snapshot_getChildren(Snapshot_T oSnapshot, size_t uEntry,
+                                 size_t *puFirst, size_t *puFiles,
+                                 size_t *puCount)
+{
+   size_t uStart;
+
+   assert(oSnapshot != NULL);
+   assert(uEntry < oSnapshot->uLength);
+   assert(puFirst != NULL);
+   assert(puFiles != NULL);
+   assert(puCount != NULL);
+
+   /* The children's 1s follow the (uEntry + 1)st 0, before which are
+      uEntry + 1 0s, so there are uStart - uEntry - 1 1s before them,
+      and the first child is entry uStart - uEntry - 1. */
+   uStart = BitVec_selectZero(oSnapshot->oShape, uEntry) + 1;
+   *puCount = BitVec_selectZero(oSnapshot->oShape, uEntry + 1) - uStart;
+   *puFirst = uStart - uEntry - 1;
+
+   /* A directory's files come before its directories. */
+   *puFiles = BitVec_rank(oSnapshot->oFiles, *puFirst + *puCount) -
+      BitVec_rank(oSnapshot->oFiles, *puFirst);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the character of a key at pcKey, as a number, or 0 at the
+   end of the key, which is the end of pcKey or a slash. */
+
+static int Snapshot_keyChar(const char *pcKey)
+{
+   assert(pcKey != NULL);
+
+   if (*pcKey == '/')
+      return 0;
+   return (int)(unsigned char)*pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the first of the entries uFrom up to but not including uTo of
+   oSnapshot, which are in one block and whose names are in order,
+   whose name does not come before the key pcKey, which ends at the end
+   of the string or at a slash.  Store it, or uTo if there is none, in
+   *puEntry, and return 0 if its name is the key, a negative number if
+   it comes after the key, and a positive one if there is none.  The
+   names are not decoded: the block is walked from its first name,
+   keeping the length of the prefix that each name shares with the key
+   and the order of the two, each from the name before. */
+
+static int Snapshot_scan(Snapshot_T oSnapshot, const char *pcKey,
+                         size_t uFrom, size_t uTo, size_t *puEntry)
+{
+   const unsigned char *pucStream;
+   size_t uShared;
+   size_t uRest;
+   size_t uMatched = 0;
+   size_t uEntry;
+   size_t u;
+   int iOrder = 0;
+
+   assert(oSnapshot != NULL);
+   assert(pcKey != NULL);
+   assert(uFrom < uTo && uTo <= oSnapshot->uLength);
+   assert((uTo - 1) / NAMES_PER_BLOCK == uFrom / NAMES_PER_BLOCK);
+   assert(puEntry != NULL);
+
+   uEntry = uFrom - uFrom % NAMES_PER_BLOCK;
+   pucStream = oSnapshot->pucNames +
+      oSnapshot->puBlocks[uFrom / NAMES_PER_BLOCK];
+   for (; uEntry < uTo; uEntry++)
+   {
+      uShared = Snapshot_getNumber(&pucStream);
+      uRest = Snapshot_getNumber(&pucStream);
+
+      if (uShared < uMatched)
+      {
+         /* The name leaves the last one, and so the key, where the
+            last one matched the key. */
+         uMatched = uShared;
+         iOrder = Snapshot_keyChar(pcKey + uMatched) -
+            (uRest > 0 ? (int)pucStream[0] : 0);
+      }
+      else if (uShared == uMatched)
+      {
+         /* The name matches the key as far as the last one did, and
+            its rest is to be compared with the rest of the key. */
+         for (u = 0; u < uRest && (unsigned char)pcKey[uMatched] ==
+                 pucStream[u]; u++)
+            uMatched++;
+         iOrder = Snapshot_keyChar(pcKey + uMatched) -
+            (u < uRest ? (int)pucStream[u] : 0);
+      }
+      /* Otherwise the name matches the last one beyond where the last
+         one left the key, so it leaves the key there too. */
+
+      if (uEntry >= uFrom && iOrder <= 0)
+      {
+         *puEntry = uEntry;
+         return iOrder;
+      }
+      pucStream += uRest;
+      if (BitVec_get(oSnapshot->oFiles, uEntry))
+         (void)Snapshot_getNumber(&pucStream);
+   }
+
+   *puEntry = uTo;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the entries uLow up to but not including uHigh of oSnapshot,
+   whose names are in order, for the one whose name is the key pcKey.
+   Return 1 (TRUE) if there is one, storing it in *puEntry, and 0
+   (FALSE) otherwise. */
+
+static int Snapshot_search(Snapshot_T oSnapshot, const char *pcKey,
+                           size_t uLow, size_t uHigh, size_t *puEntry)
+{
+   size_t uFirstBlock;
+   size_t uLowBlock;
+   size_t uHighBlock;
+   size_t uMiddle;
+   size_t uStart;
+   size_t uEnd;
+   int iOrder;
+
+   assert(oSnapshot != NULL);
+   assert(pcKey != NULL);
+   assert(puEntry != NULL);
+
+   if (uLow >= uHigh)
+      return 0;
+
+   /* The first names of the blocks that begin within the range are
+      stored whole, so they are searched first, for the last that does
+      not come after the key. */
+   uFirstBlock = uLow / NAMES_PER_BLOCK + 1;
+   uLowBlock = uFirstBlock;
+   uHighBlock = (uHigh - 1) / NAMES_PER_BLOCK + 1;
+   while (uLowBlock < uHighBlock)
+   {
+      uMiddle = uLowBlock + (uHighBlock - uLowBlock) / 2;
+      iOrder = Snapshot_scan(oSnapshot, pcKey,
+                             uMiddle * NAMES_PER_BLOCK,
+                             uMiddle * NAMES_PER_BLOCK + 1, puEntry);
+      if (iOrder == 0)
+         return 1;
+      if (iOrder < 0)
+         uHighBlock = uMiddle;
+      else
+         uLowBlock = uMiddle + 1;
+   }
+
+   /* Then the rest of that block, or the start of the range, is
+      walked once. */
+   if (uLowBlock == uFirstBlock)
+      uStart = uLow;
+   else
+      uStart = (uLowBlock - 1) * NAMES_PER_BLOCK;
+   uEnd = (uStart / NAMES_PER_BLOCK + 1) * NAMES_PER_BLOCK;
+   if (uEnd > uHigh)
+      uEnd = uHigh;
+   return Snapshot_scan(oSnapshot, pcKey, uStart, uEnd, puEntry) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Snapshot_find(Snapshot_T oSnapshot, const char *pcPath,
+                  size_t *puEntry)
+{
+   const char *pcEnd;
+   size_t uEntry = 0;
+   size_t uFirst;
+   size_t uFiles;
+   size_t uCount;
+
+   assert(oSnapshot != NULL);
+   assert(oSnapshot->oShape != NULL);
+   assert(pcPath != NULL);
+   assert(puEntry != NULL);
+
+   if (oSnapshot->uLength == 0)
+      return 0;
+
+   /* The first component names the root. */
+   if (Snapshot_scan(oSnapshot, pcPath, 0, 1, &uEntry) != 0)
+      return 0;
+   pcPath += strcspn(pcPath, "/");
+
+   while (*pcPath == '/')
+   {
+      pcPath++;
+      if (BitVec_get(oSnapshot->oFiles, uEntry))
+         return 0;
+      Snapshot_getChildren(oSnapshot, uEntry, &uFirst, &uFiles,
+                           &uCount);
+
+      /* Only the last component may name a file. */
+      pcEnd = pcPath + strcspn(pcPath, "/");
+      if (! Snapshot_search(oSnapshot, pcPath, uFirst + uFiles,
+                            uFirst + uCount, &uEntry) &&
+          (*pcEnd != '\0' ||
+           ! Snapshot_search(oSnapshot, pcPath, uFirst,
+                             uFirst + uFiles, &uEntry)))
+         return 0;
+      pcPath = pcEnd;
+   }
+
+   *puEntry = uEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Snapshot_isFile(Snapshot_T oSnapshot, size_t uEntry)
+{
+   assert(oSnapshot != NULL);
+   assert(oSnapshot->oFiles != NULL);
+   assert(uEntry < oSnapshot->uLength);
+
+   return BitVec_get(oSnapshot->oFiles, uEntry);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Decode the name of the entry uEntry of oSnapshot into pcBuffer,
+   which must hold as many characters as the longest name in its
+   block, and return its length.  pcBuffer is not '\0'-terminated,
+   and may be NULL, in which case the name is only skipped.  If
+   ppucAfter is not NULL, store in *ppucAfter the position in the name
+   stream after the name. */
+
+static size_t Snapshot_decode(Snapshot_T oSnapshot, size_t uEntry,
+                              char *pcBuffer,
+                              const unsigned char **ppucAfter)
+{
+   const unsigned char *pucStream;
+   size_t uShared;
+   size_t uRest;
+   size_t uEntryHere;
+
+   assert(oSnapshot != NULL);
+   assert(uEntry < oSnapshot->uLength);
+
+   uEntryHere = uEntry - uEntry % NAMES_PER_BLOCK;
+   pucStream = oSnapshot->pucNames +
+      oSnapshot->puBlocks[uEntry / NAMES_PER_BLOCK];
+   for (; ; uEntryHere++)
+   {
+      uShared = Snapshot_getNumber(&pucStream);
+      uRest = Snapshot_getNumber(&pucStream);
+      if (pcBuffer != NULL)
+         memcpy(pcBuffer + uShared, pucStream, uRest);
+      pucStream += uRest;
+      if (uEntryHere == uEntry)
+         break;
+      if (BitVec_get(oSnapshot->oFiles, uEntryHere))
+         (void)Snapshot_getNumber(&pucStream);
+   }
+
+   if (ppucAfter != NULL)
+      *ppucAfter = pucStream;
+   return uShared + uRest;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Snapshot_getLength(Snapshot_T oSnapshot, size_t uEntry)
+{
+   const unsigned char *pucAfter;
+
+   assert(oSnapshot != NULL);
+   assert(Snapshot_isFile(oSnapshot, uEntry));
+
+   (void)Snapshot_decode(oSnapshot, uEntry, NULL, &pucAfter);
+   return Snapshot_getNumber(&pucAfter);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Snapshot_getBufferLength(Snapshot_T oSnapshot)
+{
+   assert(oSnapshot != NULL);
+
+   return oSnapshot->uBufferLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(pcBuffer, uPathLength, pvExtra) for the directory
+   uEntry of oSnapshot, whose full path, of length uPathLength, is in
+   pcBuffer, and then, in pre-order, for everything beneath it, as
+   Snapshot_map does. */
+
+static int Snapshot_mapFrom(Snapshot_T oSnapshot, size_t uEntry,
+                            char *pcBuffer, size_t uPathLength,
+                            int (*pfApply)(const char *pcPath,
+                                           size_t uLength,
+                                           void *pvExtra),
+                            void *pvExtra)
+{
+   size_t uFirst;
+   size_t uFiles;
+   size_t uCount;
+   size_t uLength;
+   size_t u;
+   int iResult;
+
+   assert(oSnapshot != NULL);
+   assert(pcBuffer != NULL);
+   assert(pfApply != NULL);
+
+   pcBuffer[uPathLength] = '\0';
+   iResult = (*pfApply)(pcBuffer, uPathLength, pvExtra);
+   if (iResult != 0)
+      return iResult;
+
+   Snapshot_getChildren(oSnapshot, uEntry, &uFirst, &uFiles, &uCount);
+   for (u = uFirst; u < uFirst + uCount; u++)
+   {
+      pcBuffer[uPathLength] = '/';
+      uLength = uPathLength + 1 +
+         Snapshot_decode(oSnapshot, u, pcBuffer + uPathLength + 1,
+                         NULL);
+      if (u < uFirst + uFiles)
+      {
+         pcBuffer[uLength] = '\0';
+         iResult = (*pfApply)(pcBuffer, uLength, pvExtra);
+      }
+      else
+         iResult = Snapshot_mapFrom(oSnapshot, u, pcBuffer, uLength,
+                                    pfApply, pvExtra);
+      if (iResult != 0)
+         return iResult;
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Snapshot_map(Snapshot_T oSnapshot, char *pcBuffer,
+                 int (*pfApply)(const char *pcPath, size_t uLength,
+                                void *pvExtra),
+                 void *pvExtra)
+{
+   size_t uLength;
+
+   assert(oSnapshot != NULL);
+   assert(oSnapshot->oShape != NULL);
+   assert(pcBuffer != NULL);
+   assert(pfApply != NULL);
+
+   if (oSnapshot->uLength == 0)
+      return 0;
+
+   uLength = Snapshot_decode(oSnapshot, 0, pcBuffer, NULL);
+   return Snapshot_mapFrom(oSnapshot, 0, pcBuffer, uLength, pfApply,
+                           pvExtra);
+}
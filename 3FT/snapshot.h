@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------*/
+/* snapshot.h                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SNAPSHOT_INCLUDED
+#define SNAPSHOT_INCLUDED
+
+#include <stddef.h>
+
+/* A Snapshot_T object is an immutable record of the shape of a
+   hierarchy of named directories and files, and of the lengths of its
+   files, in as few bits as will still answer questions about it
+   without unpacking it.  Its shape is a level-order unary degree
+   sequence: a bit array holding, for each entry in level order, a 1
+   for each of its children and then a 0, so that the children of any
+   entry are found by counting bits, in a little over 2 bits per
+   entry.  A second bit array marks the files.  The names, in the same
+   order, are front-coded: each name but the first of every block of
+   16 is stored as the length of the prefix it shares with the name
+   before it and the rest of it, and each file's length follows its
+   name.
+
+   A Snapshot_T is built by adding its entries, level by level, each
+   directory's children together, its files before its directories and
+   each in order of name, and is then finished, after which it is
+   only read.  A finished Snapshot_T may be read by any number of
+   threads at once.  Entries are identified by their position in the
+   order added, from 0 for the root. */
+
+typedef struct Snapshot *Snapshot_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty Snapshot_T object, to which entries are to be
+   added, or NULL if insufficient memory is available. */
+
+Snapshot_T Snapshot_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oSnapshot.  oSnapshot may be NULL, in which case nothing is
+   freed. */
+
+void Snapshot_free(Snapshot_T oSnapshot);
+
+/*--------------------------------------------------------------------*/
+
+/* Add to the unfinished oSnapshot an entry named pcName, which is a
+   file whose contents are uLength bytes long if iIsFile is 1 (TRUE),
+   and otherwise a directory with uChildren children.  The first entry
+   is the root, and each entry after it is the next child of the first
+   directory added whose children have not all been added yet.  Return
+   1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+int Snapshot_add(Snapshot_T oSnapshot, const char *pcName, int iIsFile,
+                 size_t uLength, size_t uChildren);
+
+/*--------------------------------------------------------------------*/
+
+/* Finish oSnapshot, after which no entry may be added.  Every child
+   promised by the directories added must have been added.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available. */
+
+int Snapshot_finish(Snapshot_T oSnapshot);
+
+/*--------------------------------------------------------------------*/
+
+/* Search the finished oSnapshot for the entry whose full path, the
+   names from the root down joined by slashes, is pcPath.  Return 1
+   (TRUE) if there is one, storing its identifier in *puEntry, and 0
+   (FALSE) otherwise. */
+
+int Snapshot_find(Snapshot_T oSnapshot, const char *pcPath,
+                  size_t *puEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the entry uEntry of oSnapshot is a file, and 0
+   (FALSE) if it is a directory. */
+
+int Snapshot_isFile(Snapshot_T oSnapshot, size_t uEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the contents of the file uEntry of
+   oSnapshot. */
+
+size_t Snapshot_getLength(Snapshot_T oSnapshot, size_t uEntry);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of characters that a buffer given to Snapshot_map
+   for oSnapshot must hold, which is more than the length of the
+   longest full path of an entry, since names are decoded in place. */
+
+size_t Snapshot_getBufferLength(Snapshot_T oSnapshot);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfApply)(pcPath, uLength, pvExtra) for the full path pcPath,
+   of length uLength, of each entry of the finished oSnapshot, in
+   pre-order: each directory, then its files, then each of its
+   directories with everything beneath it.  Build each path in
+   pcBuffer, which must hold Snapshot_getBufferLength(oSnapshot)
+   characters.  Stop at the first call that returns a nonzero value,
+   and return that value.  Return 0 if every call returns 0. */
+
+int Snapshot_map(Snapshot_T oSnapshot, char *pcBuffer,
+                 int (*pfApply)(const char *pcPath, size_t uLength,
+                                void *pvExtra),
+                 void *pvExtra);
+
+#endif
@@ -0,0 +1,336 @@
+/*--------------------------------------------------------------------*/
+/* symtable.c                                                         */
+/* Authors: Misrach Ewunetie, Shruti Roy                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The sequence of bucket counts that a SymTable passes through as it
+   grows.  Each is a prime near a power of two. */
+
+static const size_t auBucketCounts[] = {
+   509, 1021, 2039, 4093, 8191, 16381, 32749, 65521, 131071, 262139,
+   524287, 1048573, 2097143, 4194301, 8388593, 16777213, 33554393,
+   67108859, 134217689, 268435399, 536870909, 1073741789
+};
+
+/* The number of elements in auBucketCounts. */
+
+enum { BUCKET_COUNTS = sizeof(auBucketCounts) / sizeof(size_t) };
+
+/*--------------------------------------------------------------------*/
+
+/* A Binding is a node in the chain of one bucket.  The key is stored
+   in the same allocation, immediately after the Binding itself. */
+
+struct Binding
+{
+   /* The key, which points just past this structure. */
+   const char *pcKey;
+
+   /* The hash of the key, before reduction to a bucket index. */
+   size_t uHash;
+
+   /* The value. */
+   const void *pvValue;
+
+   /* The next Binding in the same bucket. */
+   struct Binding *psNextBinding;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is an array of buckets, each of which is a chain of
+   Bindings, along with the number of bindings it contains. */
+
+struct SymTable
+{
+   /* The number of bindings. */
+   size_t uLength;
+
+   /* The index in auBucketCounts of the current bucket count. */
+   size_t uBucketCountIndex;
+
+   /* The array of buckets. */
+   struct Binding **ppsBuckets;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey, before reduction to a bucket index. */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the Binding within oSymTable whose key is pcKey and whose
+   hash is uHash, or NULL if there is no such Binding. */
+
+static struct Binding *SymTable_find(SymTable_T oSymTable,
+                                     const char *pcKey, size_t uHash)
+{
+   struct Binding *psBinding;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psBinding = oSymTable->ppsBuckets[
+      uHash % auBucketCounts[oSymTable->uBucketCountIndex]];
+   for (; psBinding != NULL; psBinding = psBinding->psNextBinding)
+      if (psBinding->uHash == uHash &&
+          strcmp(psBinding->pcKey, pcKey) == 0)
+         return psBinding;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increase the bucket count of oSymTable to the next one in the
+   sequence, rehashing its bindings.  If insufficient memory is
+   available, leave oSymTable unchanged. */
+
+static void SymTable_grow(SymTable_T oSymTable)
+{
+   size_t uOldCount;
+   size_t uNewCount;
+   size_t u;
+   struct Binding **ppsNewBuckets;
+   struct Binding *psBinding;
+   struct Binding *psNextBinding;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->uBucketCountIndex + 1 == BUCKET_COUNTS)
+      return;
+
+   uOldCount = auBucketCounts[oSymTable->uBucketCountIndex];
+   uNewCount = auBucketCounts[oSymTable->uBucketCountIndex + 1];
+
+   ppsNewBuckets = (struct Binding**)
+      calloc(uNewCount, sizeof(struct Binding*));
+   if (ppsNewBuckets == NULL)
+      return;
+
+   for (u = 0; u < uOldCount; u++)
+      for (psBinding = oSymTable->ppsBuckets[u]; psBinding != NULL;
+           psBinding = psNextBinding)
+      {
+         psNextBinding = psBinding->psNextBinding;
+         psBinding->psNextBinding =
+            ppsNewBuckets[psBinding->uHash % uNewCount];
+         ppsNewBuckets[psBinding->uHash % uNewCount] = psBinding;
+      }
+
+   free(oSymTable->ppsBuckets);
+   oSymTable->ppsBuckets = ppsNewBuckets;
+   oSymTable->uBucketCountIndex++;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (struct SymTable*)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->uLength = 0;
+   oSymTable->uBucketCountIndex = 0;
+   oSymTable->ppsBuckets = (struct Binding**)
+      calloc(auBucketCounts[0], sizeof(struct Binding*));
+   if (oSymTable->ppsBuckets == NULL)
+   {
+      free(oSymTable);
+      return NULL;
+   }
+
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t u;
+   struct Binding *psBinding;
+   struct Binding *psNextBinding;
+
+   assert(oSymTable != NULL);
+
+   for (u = 0; u < auBucketCounts[oSymTable->uBucketCountIndex]; u++)
+      for (psBinding = oSymTable->ppsBuckets[u]; psBinding != NULL;
+           psBinding = psNextBinding)
+      {
+         psNextBinding = psBinding->psNextBinding;
+         free(psBinding);
+      }
+
+   free(oSymTable->ppsBuckets);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   return oSymTable->uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   size_t uHash;
+   size_t uBucket;
+   size_t uKeyLength;
+   struct Binding *psBinding;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(pcKey);
+   if (SymTable_find(oSymTable, pcKey, uHash) != NULL)
+      return 0;
+
+   if (oSymTable->uLength >=
+       auBucketCounts[oSymTable->uBucketCountIndex])
+      SymTable_grow(oSymTable);
+
+   uKeyLength = strlen(pcKey);
+   psBinding = (struct Binding*)
+      malloc(sizeof(struct Binding) + uKeyLength + 1);
+   if (psBinding == NULL)
+      return 0;
+
+   psBinding->pcKey = (const char*)(psBinding + 1);
+   memcpy(psBinding + 1, pcKey, uKeyLength + 1);
+   psBinding->uHash = uHash;
+   psBinding->pvValue = pvValue;
+
+   uBucket = uHash % auBucketCounts[oSymTable->uBucketCountIndex];
+   psBinding->psNextBinding = oSymTable->ppsBuckets[uBucket];
+   oSymTable->ppsBuckets[uBucket] = psBinding;
+   oSymTable->uLength++;
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct Binding *psBinding;
+   const void *pvOldValue;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psBinding = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+   if (psBinding == NULL)
+      return NULL;
+
+   pvOldValue = psBinding->pvValue;
+   psBinding->pvValue = pvValue;
+   return (void*)pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey)) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   struct Binding *psBinding;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psBinding = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+   if (psBinding == NULL)
+      return NULL;
+
+   return (void*)psBinding->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   size_t uHash;
+   struct Binding **ppsLink;
+   struct Binding *psBinding;
+   const void *pvValue;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(pcKey);
+   ppsLink = &oSymTable->ppsBuckets[
+      uHash % auBucketCounts[oSymTable->uBucketCountIndex]];
+   for (; *ppsLink != NULL; ppsLink = &(*ppsLink)->psNextBinding)
+   {
+      psBinding = *ppsLink;
+      if (psBinding->uHash == uHash &&
+          strcmp(psBinding->pcKey, pcKey) == 0)
+      {
+         *ppsLink = psBinding->psNextBinding;
+         pvValue = psBinding->pvValue;
+         free(psBinding);
+         oSymTable->uLength--;
+         return (void*)pvValue;
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+   size_t u;
+   struct Binding *psBinding;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   for (u = 0; u < auBucketCounts[oSymTable->uBucketCountIndex]; u++)
+      for (psBinding = oSymTable->ppsBuckets[u]; psBinding != NULL;
+           psBinding = psBinding->psNextBinding)
+         (*pfApply)(psBinding->pcKey, (void*)psBinding->pvValue,
+                    (void*)pvExtra);
+}